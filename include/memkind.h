@@ -7,6 +7,7 @@ extern "C" {
 #endif
 
 #include <stdbool.h>
+#include <stdint.h>
 #include <sys/types.h>
 
 #ifndef MEMKIND_MALLOC_USABLE_SIZE_CONST
@@ -100,7 +101,18 @@ typedef enum memkind_bits_t
     /**
      * Allocations backed by 2 MB page size (2^21 = 2MB).
      */
-    MEMKIND_MASK_PAGE_SIZE_2MB = 21ull
+    MEMKIND_MASK_PAGE_SIZE_2MB = 21ull,
+
+    /**
+     * Allocations backed by 1 GB page size (2^30 = 1GB).
+     */
+    MEMKIND_MASK_PAGE_SIZE_1GB = 30ull,
+
+    /**
+     * Allocations backed by transparent huge pages: extents are 2 MB aligned
+     * and advised with MADV_HUGEPAGE.
+     */
+    MEMKIND_MASK_THP = (1ull << 8)
 } memkind_bits_t;
 
 /// \brief Memkind type definition
@@ -223,6 +235,61 @@ typedef enum memkind_mem_usage_policy
     MEMKIND_MEM_USAGE_POLICY_MAX_VALUE
 } memkind_mem_usage_policy;
 
+/// \brief Memkind file-backed memory preallocation mode
+typedef enum memkind_pmem_prealloc
+{
+    /**
+     * File space is allocated and mapped for each extent (default).
+     */
+    MEMKIND_PMEM_PREALLOC_NONE = 0,
+
+    /**
+     * Whole file is allocated and mapped once at creation of kind.
+     */
+    MEMKIND_PMEM_PREALLOC_FILE = 1,
+
+    /**
+     * As MEMKIND_PMEM_PREALLOC_FILE, additionally page tables of mapping are
+     * populated at creation of kind.
+     */
+    MEMKIND_PMEM_PREALLOC_POPULATE = 2,
+
+    /**
+     * Max preallocation mode value.
+     */
+    MEMKIND_PMEM_PREALLOC_MAX_VALUE
+} memkind_pmem_prealloc;
+
+/// \brief Memkind arena selection strategy
+typedef enum memkind_arena_select
+{
+    /**
+     * Arena selected by hash of calling thread (default).
+     */
+    MEMKIND_ARENA_SELECT_THREAD = 0,
+
+    /**
+     * Kind is mapped to single arena shared by all threads (bijective
+     * mapping between kind and arena).
+     */
+    MEMKIND_ARENA_SELECT_BIJECTIVE = 1,
+
+    /**
+     * Arena of CPU on which calling thread runs.
+     */
+    MEMKIND_ARENA_SELECT_CPU = 2,
+
+    /**
+     * Arena of NUMA node on which calling thread runs.
+     */
+    MEMKIND_ARENA_SELECT_NODE = 3,
+
+    /**
+     * Max arena selection strategy value.
+     */
+    MEMKIND_ARENA_SELECT_MAX_VALUE
+} memkind_arena_select;
+
 /// \brief Memkind memory statistics type
 typedef enum memkind_stat_type
 {
@@ -345,6 +412,35 @@ void memkind_config_set_size(struct memkind_config *cfg, size_t pmem_size);
 void memkind_config_set_memory_usage_policy(struct memkind_config *cfg,
                                             memkind_mem_usage_policy policy);
 
+///
+/// \brief Update memkind configuration with number of arenas of kind
+/// \warning EXPERIMENTAL API
+/// \param cfg memkind configuration
+/// \param arena_num number of arenas, rounded up to power of 2, 0 selects
+///        default number of arenas
+///
+void memkind_config_set_arena_num(struct memkind_config *cfg,
+                                  unsigned arena_num);
+
+///
+/// \brief Update memkind configuration with arena selection strategy of kind
+/// \warning EXPERIMENTAL API
+/// \param cfg memkind configuration
+/// \param select arena selection strategy
+///
+void memkind_config_set_arena_select(struct memkind_config *cfg,
+                                     memkind_arena_select select);
+
+///
+/// \brief Update memkind configuration with preallocation mode of PMEM kind
+/// \warning EXPERIMENTAL API
+/// \note Preallocation requires size limit of PMEM kind
+/// \param cfg memkind configuration
+/// \param prealloc preallocation mode
+///
+void memkind_config_set_pmem_prealloc(struct memkind_config *cfg,
+                                      memkind_pmem_prealloc prealloc);
+
 ///
 /// \brief Create kind that allocates memory with specific memory type, memory
 ///        binding policy and flags.
@@ -375,6 +471,64 @@ int memkind_create_kind(memkind_memtype_t memtype_flags,
                         memkind_policy_t policy, memkind_bits_t flags,
                         memkind_t *kind);
 
+struct bitmask;
+
+///
+/// \brief Create kind that allocates memory bound to explicit set of NUMA
+///        nodes with specified memory policy
+/// \warning EXPERIMENTAL API
+/// \note Kind is dynamic, it has to be destroyed with memkind_destroy_kind()
+/// \param nodemask set of nodes in libnuma format, e.g. returned by
+///        numa_parse_nodestring(), nodes must have memory
+/// \param mbind_mode memory policy of mbind(2): MPOL_BIND, MPOL_PREFERRED or
+///        MPOL_INTERLEAVE
+/// \param flags 0 or MEMKIND_MASK_THP
+/// \param kind pointer to kind which will be created
+/// \return Memkind operation status, MEMKIND_SUCCESS on success,
+///         MEMKIND_ERROR_MEMTYPE_NOT_AVAILABLE, MEMKIND_ERROR_INVALID or other
+///         values on failure
+///
+int memkind_create_kind_nodemask(const struct bitmask *nodemask,
+                                 int mbind_mode, memkind_bits_t flags,
+                                 memkind_t *kind);
+
+///
+/// \brief Create kind that interleaves pages between NUMA nodes in proportion
+///        to node weights
+/// \warning EXPERIMENTAL API
+/// \note Kind is dynamic, it has to be destroyed with memkind_destroy_kind()
+/// \param nodemask set of nodes in libnuma format, nodes must have memory
+/// \param weights array of weights indexed by node id, weight of each node in
+///        nodemask must be positive; when NULL, bandwidth of the nodes
+///        reported by HMAT is used
+/// \param kind pointer to kind which will be created
+/// \return Memkind operation status, MEMKIND_SUCCESS on success,
+///         MEMKIND_ERROR_MEMTYPE_NOT_AVAILABLE, MEMKIND_ERROR_INVALID or other
+///         values on failure
+///
+int memkind_create_kind_weighted_interleave(const struct bitmask *nodemask,
+                                            const unsigned *weights,
+                                            memkind_t *kind);
+
+///
+/// \brief Create kind that fills preferred NUMA nodes up to the watermark of
+///        their occupancy, then places new memory on fallback nodes
+/// \warning EXPERIMENTAL API
+/// \note Kind is dynamic, it has to be destroyed with memkind_destroy_kind()
+/// \param preferred set of nodes filled first, in libnuma format
+/// \param fallback set of nodes used when occupancy of preferred nodes
+///        reaches the watermark, in libnuma format
+/// \param watermark occupancy of preferred nodes in percent (1 - 100), kind
+///        returns to preferred nodes when occupancy drops 5 percent below it
+/// \param kind pointer to kind which will be created
+/// \return Memkind operation status, MEMKIND_SUCCESS on success,
+///         MEMKIND_ERROR_MEMTYPE_NOT_AVAILABLE, MEMKIND_ERROR_INVALID or other
+///         values on failure
+///
+int memkind_create_kind_spill(const struct bitmask *preferred,
+                              const struct bitmask *fallback,
+                              unsigned watermark, memkind_t *kind);
+
 ///
 /// \brief Destroy previously created kind object, which must have been returned
 ///        by a call to memkind_create_kind() or memkind_create_pmem().
@@ -468,6 +622,24 @@ extern memkind_t MEMKIND_HIGHEST_BANDWIDTH_LOCAL;
 /// \note STANDARD API
 extern memkind_t MEMKIND_HIGHEST_BANDWIDTH_LOCAL_PREFERRED;
 
+/// \warning EXPERIMENTAL API
+extern memkind_t MEMKIND_DEFAULT_THP;
+
+/// \warning EXPERIMENTAL API
+extern memkind_t MEMKIND_HBW_THP;
+
+/// \warning EXPERIMENTAL API
+extern memkind_t MEMKIND_DAX_KMEM_THP;
+
+/// \warning EXPERIMENTAL API
+extern memkind_t MEMKIND_HUGETLB_1GB;
+
+/// \warning EXPERIMENTAL API
+extern memkind_t MEMKIND_HBW_HUGETLB_1GB;
+
+/// \warning EXPERIMENTAL API
+extern memkind_t MEMKIND_DAX_KMEM_HUGETLB_1GB;
+
 ///
 /// \brief Get Memkind API version
 /// \note STANDARD API
@@ -519,6 +691,114 @@ int memkind_create_pmem_with_config(struct memkind_config *cfg,
 ///
 int memkind_create_fixed(void *addr, size_t size, memkind_t *kind);
 
+///
+/// \brief Create a new persistent PMEM kind on top of the named file path,
+///        heap allocated from the kind survives restart of the application
+/// \warning EXPERIMENTAL API
+/// \param path path to the file of the heap, file is created if it does not
+///        exist
+/// \param max_size size of created heap, ignored if the heap already exists
+/// \param kind pointer to kind which will be created
+/// \return Memkind operation status, MEMKIND_SUCCESS on success, other values
+///         on failure
+///
+int memkind_create_pmem_persistent(const char *path, size_t max_size,
+                                   memkind_t *kind);
+
+///
+/// \brief Get root object of persistent PMEM kind
+/// \warning EXPERIMENTAL API
+/// \param kind persistent PMEM kind
+/// \return Pointer to root object, NULL if root object is not set or kind is
+///         not persistent PMEM kind
+///
+void *memkind_pmem_get_root(memkind_t kind);
+
+///
+/// \brief Set root object of persistent PMEM kind
+/// \warning EXPERIMENTAL API
+/// \param kind persistent PMEM kind
+/// \param ptr pointer to memory allocated from kind or NULL to clear root
+/// \return Memkind operation status, MEMKIND_SUCCESS on success,
+///         MEMKIND_ERROR_INVALID on failure
+///
+int memkind_pmem_set_root(memkind_t kind, void *ptr);
+
+///
+/// \brief Flush CPU caches of memory range of file-backed PMEM kind, stores
+///        are durable after following memkind_pmem_drain()
+/// \warning EXPERIMENTAL API
+/// \note Uses CLWB, CLFLUSHOPT or CLFLUSH when persistent kind maps the file
+///       with MAP_SYNC, otherwise falls back to msync(2) of the range
+/// \param kind PMEM or persistent PMEM kind
+/// \param addr beginning of the range, memory allocated from kind
+/// \param len length of the range in bytes
+/// \return Memkind operation status, MEMKIND_SUCCESS on success, other values
+///         on failure
+///
+int memkind_pmem_flush(memkind_t kind, const void *addr, size_t len);
+
+///
+/// \brief Wait until previously flushed stores are durable
+/// \warning EXPERIMENTAL API
+///
+void memkind_pmem_drain(void);
+
+///
+/// \brief Make stores to memory range of file-backed PMEM kind durable,
+///        equivalent of memkind_pmem_flush() followed by memkind_pmem_drain()
+/// \warning EXPERIMENTAL API
+/// \param kind PMEM or persistent PMEM kind
+/// \param addr beginning of the range, memory allocated from kind
+/// \param len length of the range in bytes
+/// \return Memkind operation status, MEMKIND_SUCCESS on success, other values
+///         on failure
+///
+int memkind_pmem_persist(memkind_t kind, const void *addr, size_t len);
+
+///
+/// \brief Create a new kind on top of the shared memory object name, which
+///        heap could be used by multiple processes at the same time
+/// \warning EXPERIMENTAL API
+/// \param name name of the shared memory object as in shm_open(3), object is
+///        created if it does not exist
+/// \param size size of created heap, ignored if the heap already exists
+/// \param kind pointer to kind which will be created
+/// \return Memkind operation status, MEMKIND_SUCCESS on success, other values
+///         on failure
+///
+int memkind_create_shared(const char *name, size_t size, memkind_t *kind);
+
+///
+/// \brief Remove the shared memory object name of shared kind, the heap is
+///        released when all kinds using it are destroyed
+/// \warning EXPERIMENTAL API
+/// \param name name of the shared memory object
+/// \return Memkind operation status, MEMKIND_SUCCESS on success,
+///         MEMKIND_ERROR_INVALID on failure
+///
+int memkind_unlink_shared(const char *name);
+
+///
+/// \brief Get offset of memory allocated from shared kind, which is valid in
+///        all processes using the heap
+/// \warning EXPERIMENTAL API
+/// \param kind shared kind
+/// \param ptr pointer to memory allocated from kind
+/// \return Offset of ptr, 0 if ptr does not belong to the heap of kind
+///
+size_t memkind_shared_get_offset(memkind_t kind, const void *ptr);
+
+///
+/// \brief Get pointer to memory of shared kind from offset
+/// \warning EXPERIMENTAL API
+/// \param kind shared kind
+/// \param offset offset returned by memkind_shared_get_offset()
+/// \return Pointer to memory in address space of the calling process, NULL if
+///         offset is out of the heap of kind
+///
+void *memkind_shared_get_ptr(memkind_t kind, size_t offset);
+
 ///
 /// \brief Check if kind is available
 /// \note STANDARD API
@@ -539,6 +819,18 @@ int memkind_check_available(memkind_t kind);
 ///
 ssize_t memkind_get_capacity(memkind_t kind);
 
+///
+/// \brief Get occupancy of memory of nodes of a given kind
+/// \warning EXPERIMENTAL API
+/// \param kind specified memory kind, for kinds created with
+///        memkind_create_kind_spill() occupancy of preferred nodes is reported
+/// \param occupancy pointer to memory used on the nodes by all processes, in
+///        percent of their capacity
+/// \return Memkind operation status, MEMKIND_SUCCESS on success, other values
+///         on failure
+///
+int memkind_get_occupancy(memkind_t kind, unsigned *occupancy);
+
 ///
 /// \brief Update memkind cached statistics
 /// \note STANDARD API
@@ -558,6 +850,71 @@ int memkind_update_cached_stats(void);
 ///
 int memkind_get_stat(memkind_t kind, memkind_stat_type stat, size_t *value);
 
+/// \brief Memkind statistics of kind
+struct memkind_stats {
+    size_t stat[MEMKIND_STAT_TYPE_MAX_VALUE]; // indexed by memkind_stat_type
+};
+
+///
+/// \brief Get all types of statistics of several kinds
+/// \warning EXPERIMENTAL API
+/// \note Cached statistics are updated once before reading them, there is no
+///       need to call memkind_update_cached_stats()
+/// \param kinds array of memory kinds, NULL element selects statistics of
+///        memory used by the whole memkind library
+/// \param n number of kinds
+/// \param out array of n statistics, out[i] is filled with statistics of
+///        kinds[i]
+/// \return Memkind operation status, MEMKIND_SUCCESS on success, other values
+///         on failure
+///
+int memkind_get_stats_snapshot(memkind_t *kinds, size_t n,
+                               struct memkind_stats *out);
+
+/// \brief Memkind statistics of size class of arena
+struct memkind_size_class_stats {
+    size_t size;      // size class in bytes
+    uint64_t nmalloc; // number of allocations served by size class
+    uint64_t ndalloc; // number of deallocations
+    size_t curregs;   // number of live allocations
+    size_t curslabs;  // number of slabs, 0 for large size classes
+    size_t nregs;     // number of regions in slab, 0 for large size classes
+};
+
+/// \brief Memkind statistics of arena of kind
+struct memkind_arena_stats {
+    unsigned arena;          // jemalloc index of arena
+    size_t active;           // bytes in active pages
+    size_t dirty;            // bytes in dirty pages
+    size_t muzzy;            // bytes in muzzy pages
+    size_t retained;         // bytes of retained virtual memory
+    size_t extents;          // number of dirty, muzzy and retained extents
+    uint64_t lock_ops;       // number of acquisitions of arena locks
+    uint64_t lock_wait;      // number of contended acquisitions
+    uint64_t lock_wait_time; // time spent waiting for arena locks in ns
+    unsigned nclasses;       // number of size classes, small before large
+    const struct memkind_size_class_stats *classes;
+};
+
+///
+/// \brief Get detailed statistics of each arena of several kinds
+/// \warning EXPERIMENTAL API
+/// \note Cached statistics are updated once before reading them
+/// \param kinds array of memory kinds to report, NULL reports all kinds
+/// \param n number of kinds, ignored when kinds is NULL
+/// \param cb function called for each initialized arena of selected kinds,
+///        stats are valid only during call and cb must not create or destroy
+///        kinds
+/// \param arg data passed to cb function
+/// \return Memkind operation status, MEMKIND_SUCCESS on success, other values
+///         on failure
+///
+int memkind_get_arena_stats(memkind_t *kinds, size_t n,
+                            void (*cb)(memkind_t kind,
+                                       const struct memkind_arena_stats *stats,
+                                       void *arg),
+                            void *arg);
+
 ///
 /// \brief Print human-readable malloc statistics
 /// \note STANDARD API
@@ -638,6 +995,31 @@ void *memkind_realloc(memkind_t kind, void *ptr, size_t size);
 ///
 void memkind_free(memkind_t kind, void *ptr);
 
+///
+/// \brief Copy n bytes from src to dst, which is memory of specified kind
+/// \warning EXPERIMENTAL API
+/// \note Large copies to PMEM and KMEM DAX kinds use non-temporal stores,
+///       which do not pollute CPU caches with copied data
+/// \param kind specified memory kind of dst
+/// \param dst pointer to the destination memory
+/// \param src pointer to the source memory, must not overlap with dst
+/// \param n number of bytes to copy
+/// \return Pointer to the destination memory
+///
+void *memkind_memcpy(memkind_t kind, void *dst, const void *src, size_t n);
+
+///
+/// \brief Fill n bytes of memory of specified kind with constant byte c
+/// \warning EXPERIMENTAL API
+/// \note Large fills of PMEM and KMEM DAX kinds use non-temporal stores
+/// \param kind specified memory kind of s
+/// \param s pointer to the memory
+/// \param c value of byte
+/// \param n number of bytes to fill
+/// \return Pointer to the memory
+///
+void *memkind_memset(memkind_t kind, void *s, int c, size_t n);
+
 ///
 /// \brief Try to reallocate allocation to reduce fragmentation
 /// \note STANDARD API
@@ -647,6 +1029,53 @@ void memkind_free(memkind_t kind, void *ptr);
 ///
 void *memkind_defrag_reallocate(memkind_t kind, void *ptr);
 
+///
+/// \brief Try to reallocate several allocations to reduce fragmentation
+/// \warning EXPERIMENTAL API
+/// \param kind specified memory kind, NULL detects kind of each allocation
+/// \param ptrs array of pointers to the allocated memory, pointer of moved
+///        allocation is replaced with pointer to newly transferred memory
+/// \param n number of pointers
+/// \param moved array of n flags set when allocation was moved, could be NULL
+/// \return Number of moved allocations
+///
+size_t memkind_defrag_reallocate_batch(memkind_t kind, void **ptrs, size_t n,
+                                       bool *moved);
+
+///
+/// \brief Get utilization of slabs of small allocations of specified kind
+/// \warning EXPERIMENTAL API
+/// \note You need to call memkind_update_cached_stats() before, because
+///       statistics are cached by the memkind library
+/// \param kind specified memory kind
+/// \param utilization fraction of slab memory used by live allocations, 1.0
+///        when kind has no slabs
+/// \return Memkind operation status, MEMKIND_SUCCESS on success, other values
+///         on failure
+///
+int memkind_get_utilization(memkind_t kind, double *utilization);
+
+///
+/// \brief Set callback called by background thread when utilization of
+///        specified kind drops below threshold
+/// \warning EXPERIMENTAL API
+/// \note The callback is expected to run defrag cycle of the kind, e.g. with
+///       memkind_defrag_reallocate_batch(). It must not destroy the kind,
+///       memkind_destroy_kind() of the kind waits for its running callback.
+/// \param kind specified memory kind
+/// \param threshold utilization below which defrag_cb is called, 0 disables
+///        trigger of the kind
+/// \param interval_ms period of checking utilization of the kind
+/// \param defrag_cb function called with kind and arg
+/// \param arg data passed to defrag_cb function
+/// \return Memkind operation status, MEMKIND_SUCCESS on success, other values
+///         on failure
+///
+int memkind_set_defrag_trigger(memkind_t kind, double threshold,
+                               unsigned interval_ms,
+                               void (*defrag_cb)(memkind_t kind, void *arg),
+                               void *arg);
+
 ///
 /// \brief Verifies if file-backed memory kind in the specified directory can be
 ///        created with the DAX attribute
@@ -674,6 +1103,42 @@ int memkind_set_bg_threads(bool state);
 /// when set to false
 void memkind_set_allow_zero_allocs(memkind_t kind, bool allow_zero_allocs);
 
+///
+/// \brief Keeps pool of pre-faulted memory ahead of extents of specified kind
+/// \warning EXPERIMENTAL API
+/// \param kind specified memory kind
+/// \param pool_size size of memory populated in background ahead of allocated
+///        extents, 0 disables pool
+/// \param low_watermark size of populated memory below which pool is refilled
+/// \return Memkind operation status, MEMKIND_SUCCESS on success, other values
+///         on failure
+///
+int memkind_set_prefault_pool(memkind_t kind, size_t pool_size,
+                              size_t low_watermark);
+
+///
+/// \brief Sets decay times of unused dirty and muzzy pages of specified kind
+/// \warning EXPERIMENTAL API
+/// \param kind specified memory kind
+/// \param dirty_decay_ms time in milliseconds after which unused dirty pages
+///        are purged, 0 purges immediately, -1 disables purging
+/// \param muzzy_decay_ms time in milliseconds for which lazily purged pages
+///        are kept, 0 disables lazy purging, -1 disables forced purging
+/// \return Memkind operation status, MEMKIND_SUCCESS on success, other values
+///         on failure
+///
+int memkind_set_decay(memkind_t kind, ssize_t dirty_decay_ms,
+                      ssize_t muzzy_decay_ms);
+
+///
+/// \brief Returns all unused pages of specified kind to the operating system
+/// \warning EXPERIMENTAL API
+/// \param kind specified memory kind
+/// \return Memkind operation status, MEMKIND_SUCCESS on success, other values
+///         on failure
+///
+int memkind_purge(memkind_t kind);
+
 #ifdef __cplusplus
 }
 #endif
@@ -43,6 +43,12 @@ int memkind_arena_update_memory_usage_policy(struct memkind *kind,
                                              memkind_mem_usage_policy policy);
 int memkind_arena_set_max_bg_threads(size_t threads_limit);
 int memkind_arena_set_bg_threads(bool state);
+void memkind_arena_set_va_reserve_size(size_t size);
+int memkind_arena_set_prefault_pool(struct memkind *kind, size_t pool_size,
+                                    size_t low_watermark);
+int memkind_arena_set_decay(struct memkind *kind, ssize_t dirty_decay_ms,
+                            ssize_t muzzy_decay_ms);
+int memkind_arena_purge(struct memkind *kind);
 int memkind_arena_update_cached_stats(void);
 int memkind_arena_get_kind_stat(struct memkind *kind,
                                 memkind_stat_type stat_type, size_t *stat);
@@ -50,8 +56,18 @@ int memkind_arena_get_stat_with_check_init(struct memkind *kind,
                                            memkind_stat_type stat,
                                            bool check_init, size_t *value);
 int memkind_arena_get_global_stat(memkind_stat_type stat_type, size_t *stat);
+int memkind_arena_get_arena_stats(
+    struct memkind *kind,
+    void (*cb)(memkind_t kind, const struct memkind_arena_stats *stats,
+               void *arg),
+    void *arg);
 void *memkind_arena_defrag_reallocate(struct memkind *kind, void *ptr);
 void *memkind_arena_defrag_reallocate_with_kind_detect(void *ptr);
+int memkind_arena_get_utilization(struct memkind *kind, double *utilization);
+int memkind_arena_set_defrag_trigger(struct memkind *kind, double threshold,
+                                     unsigned interval_ms,
+                                     void (*cb)(memkind_t kind, void *arg),
+                                     void *arg);
 bool memkind_get_hog_memory(void);
 void memkind_set_hog_memory(const char *str);
 int memkind_arena_stats_print(void (*write_cb)(void *, const char *),
@@ -8,6 +8,8 @@ extern "C" {
 
 #include <memkind.h>
 
+#include <numa.h>
+
 /*
  * Header file for the DAX KMEM memory memkind operations.
  * More details in memkind_dax_kmem(3) man page.
@@ -16,6 +18,7 @@ extern "C" {
  * API standards are described in memkind(3) man page.
  */
 
+int memkind_dax_kmem_get_nodemask(struct bitmask **bm);
 int memkind_dax_kmem_all_get_mbind_nodemask(struct memkind *kind,
                                             unsigned long *nodemask,
                                             unsigned long maxnode);
@@ -24,6 +27,8 @@ extern struct memkind_ops MEMKIND_DAX_KMEM_OPS;
 extern struct memkind_ops MEMKIND_DAX_KMEM_ALL_OPS;
 extern struct memkind_ops MEMKIND_DAX_KMEM_PREFERRED_OPS;
 extern struct memkind_ops MEMKIND_DAX_KMEM_INTERLEAVE_OPS;
+extern struct memkind_ops MEMKIND_DAX_KMEM_THP_OPS;
+extern struct memkind_ops MEMKIND_DAX_KMEM_HUGETLB_1GB_OPS;
 
 #ifdef __cplusplus
 }
@@ -8,6 +8,9 @@ extern "C" {
 
 #include <memkind.h>
 
+#include <numa.h>
+#include <stdbool.h>
+
 /*
  * Header file for the high bandwidth memory memkind operations.
  * More details in memkind_hbw(3) man page.
@@ -18,6 +21,8 @@ extern "C" {
 
 int memkind_hbw_check_available(struct memkind *kind);
 int memkind_hbw_hugetlb_check_available(struct memkind *kind);
+int memkind_hbw_hugetlb_1gb_check_available(struct memkind *kind);
+int memkind_hbw_thp_check_available(struct memkind *kind);
 int memkind_hbw_get_mbind_nodemask(struct memkind *kind,
                                    unsigned long *nodemask,
                                    unsigned long maxnode);
@@ -27,6 +32,8 @@ int memkind_hbw_get_preferred_mbind_nodemask(struct memkind *kind,
 int memkind_hbw_all_get_mbind_nodemask(struct memkind *kind,
                                        unsigned long *nodemask,
                                        unsigned long maxnode);
+int memkind_hbw_get_nodemask(struct bitmask **bm);
+bool memkind_hbw_hmat_supported(void);
 void memkind_hbw_init_once(void);
 void memkind_hbw_all_init_once(void);
 void memkind_hbw_hugetlb_init_once(void);
@@ -34,6 +41,8 @@ void memkind_hbw_all_hugetlb_init_once(void);
 void memkind_hbw_preferred_init_once(void);
 void memkind_hbw_preferred_hugetlb_init_once(void);
 void memkind_hbw_interleave_init_once(void);
+void memkind_hbw_hugetlb_1gb_init_once(void);
+void memkind_hbw_thp_init_once(void);
 
 extern struct memkind_ops MEMKIND_HBW_OPS;
 extern struct memkind_ops MEMKIND_HBW_ALL_OPS;
@@ -42,6 +51,8 @@ extern struct memkind_ops MEMKIND_HBW_ALL_HUGETLB_OPS;
 extern struct memkind_ops MEMKIND_HBW_PREFERRED_OPS;
 extern struct memkind_ops MEMKIND_HBW_PREFERRED_HUGETLB_OPS;
 extern struct memkind_ops MEMKIND_HBW_INTERLEAVE_OPS;
+extern struct memkind_ops MEMKIND_HBW_THP_OPS;
+extern struct memkind_ops MEMKIND_HBW_HUGETLB_1GB_OPS;
 
 #ifdef __cplusplus
 }
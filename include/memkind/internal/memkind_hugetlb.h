@@ -9,6 +9,7 @@ extern "C" {
 #include <memkind.h>
 
 #include <numa.h>
+#include <sys/types.h>
 
 /*
  * Header file for the hugetlb memory memkind operations.
@@ -19,13 +20,19 @@ extern "C" {
  */
 
 int memkind_hugetlb_get_mmap_flags(struct memkind *kind, int *flags);
+int memkind_hugetlb_1gb_get_mmap_flags(struct memkind *kind, int *flags);
 void memkind_hugetlb_init_once(void);
+void memkind_hugetlb_1gb_init_once(void);
 int memkind_hugetlb_check_available_2mb(struct memkind *kind);
+int memkind_hugetlb_check_available_1gb(struct memkind *kind);
+size_t memkind_hugetlb_get_pagesize(struct memkind *kind);
+ssize_t memkind_hugetlb_get_capacity(struct memkind *kind, size_t huge_size);
 int get_nr_hugepages_cached(size_t pagesize, struct bitmask *nodemask,
                             size_t *out);
 int get_nr_overcommit_hugepages_cached(size_t pagesize, size_t *out);
 
 extern struct memkind_ops MEMKIND_HUGETLB_OPS;
+extern struct memkind_ops MEMKIND_HUGETLB_1GB_OPS;
 
 #ifdef __cplusplus
 }
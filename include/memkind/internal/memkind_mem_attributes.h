@@ -16,10 +16,12 @@ typedef enum memory_attribute_t
     MEM_ATTR_LATENCY = 2
 } memory_attribute_t;
 
-int get_per_cpu_local_nodes_mask(struct bitmask ***nodes_mask,
-                                 memory_attribute_t attr);
-int set_closest_numanode_mem_attr(void **numanode,
-                                  memkind_node_variant_t node_variant);
+// queries of the hwloc topology, which is loaded once per process
+int get_mem_attr_local_nodes(int init_node, memory_attribute_t attr,
+                             struct bitmask *nodes);
+int get_mem_attr_hbw_nodes(int init_node, struct bitmask *nodes);
+int get_nodes_bandwidth(const struct bitmask *nodemask,
+                        unsigned long long *bandwidth);
 
 #ifdef __cplusplus
 }
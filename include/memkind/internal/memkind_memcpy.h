@@ -0,0 +1,31 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/* Copyright (C) 2022 Intel Corporation. */
+
+#pragma once
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <memkind.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * Header file for copy and fill of memory of slow tier kinds (PMEM, KMEM
+ * DAX) with non-temporal stores, which bypass CPU caches.
+ *
+ * Functionality defined in this header is considered as EXPERIMENTAL API.
+ * API standards are described in memkind(3) man page.
+ */
+
+// below this size regular stores are faster, as data fits in CPU caches
+#define MEMKIND_MEMCPY_NT_THRESHOLD (2 * 1024 * 1024)
+
+bool memkind_memcpy_nt_enabled(struct memkind *kind, size_t size);
+void memkind_memcpy_nt(void *dst, const void *src, size_t n);
+void memkind_memset_nt(void *s, int c, size_t n);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,66 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/* Copyright (C) 2022 Intel Corporation. */
+
+#pragma once
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "memkind_arena.h"
+#include "memkind_default.h"
+#include <memkind.h>
+
+#include <numa.h>
+#include <numaif.h>
+
+#ifndef MPOL_WEIGHTED_INTERLEAVE
+#define MPOL_WEIGHTED_INTERLEAVE 6
+#endif
+
+/*
+ * Header file for the memkind operations of kinds bound to the set of NUMA
+ * nodes given by the user, with one of mbind(2) memory policies. Weighted
+ * interleave kinds place pages on the nodes in proportion to node weights,
+ * with MPOL_WEIGHTED_INTERLEAVE when the kernel uses the same weights,
+ * otherwise each extent is split into ranges bound to single nodes.
+ *
+ * Functionality defined in this header is considered as EXPERIMENTAL API.
+ * API standards are described in memkind(3) man page.
+ */
+
+int memkind_nodemask_create(struct memkind *kind, struct memkind_ops *ops,
+                            const char *name);
+int memkind_nodemask_destroy(struct memkind *kind);
+int memkind_nodemask_get_mbind_nodemask(struct memkind *kind,
+                                        unsigned long *nodemask,
+                                        unsigned long maxnode);
+int memkind_nodemask_get_mbind_mode(struct memkind *kind, int *mode);
+int memkind_nodemask_set_weights(struct memkind *kind,
+                                 const unsigned long long *weights);
+int memkind_nodemask_weighted_mbind(struct memkind *kind, void *ptr,
+                                    size_t size);
+
+struct memkind_nodemask {
+    struct bitmask *nodemask; // nodes to which extents are bound
+    int mode; // MPOL_BIND, MPOL_PREFERRED, MPOL_INTERLEAVE or
+              // MPOL_WEIGHTED_INTERLEAVE
+    // used only by weighted interleave kinds
+    int *nodes;            // nodes of nodemask in ascending order
+    unsigned *weights;     // weights of nodes, reduced by common divisor
+    unsigned num_nodes;
+    unsigned total_weight; // pages in one interleave cycle
+    unsigned long cursor;  // pages placed after the last full cycle
+    bool kernel_weights;   // kernel interleaves with the same weights
+};
+
+size_t memkind_nodemask_weighted_pages(const struct memkind_nodemask *priv,
+                                       unsigned idx, size_t pages,
+                                       unsigned pos);
+
+extern struct memkind_ops MEMKIND_NODEMASK_OPS;
+extern struct memkind_ops MEMKIND_NODEMASK_THP_OPS;
+extern struct memkind_ops MEMKIND_WEIGHTED_INTERLEAVE_OPS;
+
+#ifdef __cplusplus
+}
+#endif
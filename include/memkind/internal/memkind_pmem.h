@@ -29,6 +29,18 @@ void *memkind_pmem_mmap(struct memkind *kind, void *addr, size_t size);
 int memkind_pmem_get_mmap_flags(struct memkind *kind, int *flags);
 int memkind_pmem_create_tmpfile(const char *dir, int *fd);
 int memkind_pmem_validate_dir(const char *dir);
+int memkind_pmem_preallocate(struct memkind *kind, bool populate);
+int memkind_pmem_map_flags(bool map_sync);
+bool memkind_pmem_map_sync_supported(int fd);
+int memkind_pmem_flush_range(bool map_sync, const void *addr, size_t len);
+bool memkind_pmem_range_mapped(struct memkind *kind, const void *addr,
+                               size_t len);
+void memkind_pmem_drain_stores(void);
+
+struct pmem_range {
+    uintptr_t start;
+    uintptr_t end;
+};
 
 struct memkind_pmem {
     int fd;
@@ -37,6 +49,11 @@ struct memkind_pmem {
     pthread_mutex_t pmem_lock;
     size_t current_size;
     char *dir;
+    void *base; // mapping of whole preallocated file, NULL - not preallocated
+    // mappings of file, sorted by address, adjacent ones are coalesced
+    struct pmem_range *ranges;
+    size_t ranges_num;
+    size_t ranges_cap;
 };
 
 extern struct memkind_ops MEMKIND_PMEM_OPS;
@@ -0,0 +1,70 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/* Copyright (C) 2022 Intel Corporation. */
+
+#pragma once
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "memkind_default.h"
+#include <memkind.h>
+
+#include <pthread.h>
+
+/*
+ * Header file for the persistent file-backed memory memkind operations.
+ * In contrast to PMEM kind, heap metadata is kept inside the named file,
+ * which is mapped at the same address on every open, so the heap and
+ * pointers stored in it survive restart of the application. Shared memory
+ * kind keeps the same heap in shared memory object, which is attached by
+ * cooperating processes.
+ *
+ * Functionality defined in this header is considered as EXPERIMENTAL API.
+ * API standards are described in memkind(3) man page.
+ */
+
+int memkind_pmem_persistent_create(struct memkind *kind,
+                                   struct memkind_ops *ops, const char *name);
+int memkind_pmem_persistent_destroy(struct memkind *kind);
+int memkind_pmem_persistent_open_file(const char *path, int *fd);
+int memkind_pmem_persistent_map(struct memkind *kind, int fd, size_t size);
+void *memkind_pmem_persistent_malloc(struct memkind *kind, size_t size);
+void *memkind_pmem_persistent_calloc(struct memkind *kind, size_t num,
+                                     size_t size);
+int memkind_pmem_persistent_posix_memalign(struct memkind *kind, void **memptr,
+                                           size_t alignment, size_t size);
+void *memkind_pmem_persistent_realloc(struct memkind *kind, void *ptr,
+                                      size_t size);
+void memkind_pmem_persistent_free(struct memkind *kind, void *ptr);
+size_t memkind_pmem_persistent_malloc_usable_size(struct memkind *kind,
+                                                  void *ptr);
+int memkind_pmem_persistent_get_stat(struct memkind *kind,
+                                     memkind_stat_type stat, size_t *value);
+void *memkind_pmem_persistent_defrag_reallocate(struct memkind *kind,
+                                                void *ptr);
+void *memkind_pmem_persistent_get_root(struct memkind *kind);
+int memkind_pmem_persistent_set_root(struct memkind *kind, void *ptr);
+int memkind_pmem_persistent_flush(struct memkind *kind, const void *addr,
+                                  size_t len);
+int memkind_shared_destroy(struct memkind *kind);
+int memkind_shared_open(const char *name, int *fd, bool *created);
+int memkind_shared_map(struct memkind *kind, int fd, bool created,
+                       size_t size);
+size_t memkind_pmem_persistent_offset(struct memkind *kind, const void *ptr);
+void *memkind_pmem_persistent_ptr(struct memkind *kind, size_t offset);
+
+struct memkind_pmem_persistent {
+    int fd;
+    char *base; // mapping of whole file, header is at the beginning
+    size_t size;
+    pthread_mutex_t *lock; // heap lock, in the header for shared memory kind
+    pthread_mutex_t local_lock;
+    bool map_sync; // file is mapped with MAP_SYNC
+};
+
+extern struct memkind_ops MEMKIND_PMEM_PERSISTENT_OPS;
+extern struct memkind_ops MEMKIND_SHARED_OPS;
+
+#ifdef __cplusplus
+}
+#endif
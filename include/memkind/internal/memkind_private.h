@@ -37,6 +37,8 @@ extern "C" {
 #define jemk_rallocx            JE_SYMBOL(rallocx)
 #define jemk_realloc            JE_SYMBOL(realloc)
 #define jemk_mallctl            JE_SYMBOL(mallctl)
+#define jemk_mallctlnametomib   JE_SYMBOL(mallctlnametomib)
+#define jemk_mallctlbymib       JE_SYMBOL(mallctlbymib)
 #define jemk_memalign           JE_SYMBOL(memalign)
 #define jemk_posix_memalign     JE_SYMBOL(posix_memalign)
 #define jemk_free               JE_SYMBOL(free)
@@ -48,7 +50,7 @@ extern "C" {
 
 // Number of static kinds.  Needs to be kept in sync with the number of
 // such kinds included in memkind_registry_g.
-#define MEMKIND_NUM_STATIC_KINDS 23
+#define MEMKIND_NUM_STATIC_KINDS 29
 
 enum memkind_const_private
 {
@@ -87,19 +89,28 @@ struct memkind {
     char name[MEMKIND_NAME_LENGTH_PRIV];
     pthread_once_t init_once;
     unsigned int arena_map_len; // is power of 2
-    unsigned int *arena_map;    // To be deleted beyond 1.2.0+
+    unsigned int *arena_map;    // jemalloc arena of each slot, 0 - arena of
+                                // slot is not created yet
     pthread_key_t arena_key;
     void *priv;
     unsigned int arena_map_mask; // arena_map_len - 1 to optimize modulo
                                  // operation on arena_map_len
-    unsigned int arena_zero;     // index first jemalloc arena of this kind
+    unsigned int arena_zero;     // index of jemalloc arena of first slot
     bool allow_zero_allocs;      // Return valid ptr for malloc(0) calls
+    struct extent_hooks_s *arena_hooks; // extent hooks of arenas created
+                                        // on first use of slot
+    bool arena_metadata_use_hooks;
+    memkind_arena_select arena_select; // strategy of mapping thread to slot
+    bool use_tcache; // dynamic kind caches allocations in thread caches
 };
 
 struct memkind_config {
-    const char *pmem_dir;            // PMEM kind path
-    size_t pmem_size;                // PMEM kind size
-    memkind_mem_usage_policy policy; // kind memory usage policy
+    const char *pmem_dir;              // PMEM kind path
+    size_t pmem_size;                  // PMEM kind size
+    memkind_mem_usage_policy policy;   // kind memory usage policy
+    unsigned arena_num;                // number of arenas, 0 - default
+    memkind_arena_select arena_select; // arena selection strategy
+    memkind_pmem_prealloc prealloc;    // PMEM kind preallocation mode
 };
 
 typedef enum memkind_node_variant_t
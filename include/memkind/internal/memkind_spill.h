@@ -0,0 +1,58 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/* Copyright (C) 2022 Intel Corporation. */
+
+#pragma once
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "memkind_arena.h"
+#include "memkind_default.h"
+#include <memkind.h>
+
+#include <numa.h>
+
+/*
+ * Header file for the memkind operations of fill-then-spill kinds. New
+ * extents of the kind prefer the preferred nodes until occupancy of these
+ * nodes crosses the watermark, then they prefer the fallback nodes until
+ * occupancy drops below the watermark by MEMKIND_SPILL_HYSTERESIS.
+ *
+ * Functionality defined in this header is considered as EXPERIMENTAL API.
+ * API standards are described in memkind(3) man page.
+ */
+
+#ifndef MPOL_PREFERRED_MANY
+#define MPOL_PREFERRED_MANY 5
+#endif
+
+// occupancy in percent below the watermark at which kind stops spilling
+#define MEMKIND_SPILL_HYSTERESIS 5
+// occupancy of nodes is measured at most once per this interval
+#define MEMKIND_SPILL_CHECK_INTERVAL_NS (10 * 1000 * 1000)
+
+int memkind_spill_create(struct memkind *kind, struct memkind_ops *ops,
+                         const char *name);
+int memkind_spill_destroy(struct memkind *kind);
+int memkind_spill_mbind(struct memkind *kind, void *ptr, size_t size);
+int memkind_spill_get_mbind_nodemask(struct memkind *kind,
+                                     unsigned long *nodemask,
+                                     unsigned long maxnode);
+int memkind_spill_get_mbind_mode(struct memkind *kind, int *mode);
+int memkind_nodes_occupancy(const struct bitmask *nodemask,
+                            unsigned *occupancy);
+
+struct memkind_spill {
+    struct bitmask *preferred; // nodes filled first
+    struct bitmask *fallback;  // nodes used above the watermark
+    unsigned watermark;        // occupancy of preferred nodes in percent
+    unsigned occupancy;        // last measured occupancy of preferred nodes
+    bool spilling;             // new extents prefer fallback nodes
+    unsigned long long checked_ns; // time of the last measurement
+};
+
+extern struct memkind_ops MEMKIND_SPILL_OPS;
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,29 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/* Copyright (C) 2022 Intel Corporation. */
+
+#pragma once
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <memkind.h>
+
+#include <stddef.h>
+
+/*
+ * Header file for the transparent huge page memkind operations.
+ * More details in memkind(3) man page.
+ *
+ * Functionality defined in this header is considered as EXPERIMENTAL API.
+ * API standards are described in memkind(3) man page.
+ */
+
+int memkind_thp_madvise(struct memkind *kind, void *addr, size_t size);
+int memkind_thp_check_available(struct memkind *kind);
+void memkind_default_thp_init_once(void);
+
+extern struct memkind_ops MEMKIND_DEFAULT_THP_OPS;
+
+#ifdef __cplusplus
+}
+#endif
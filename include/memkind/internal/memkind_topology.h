@@ -0,0 +1,61 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/* Copyright (C) 2022 Intel Corporation. */
+
+#pragma once
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <memkind/internal/memkind_private.h>
+
+#include <stdbool.h>
+
+/*
+ * Header file for the topology model shared by kinds which choose memory
+ * NUMA nodes relative to the CPU of the calling thread. For each attribute
+ * the model holds per-CPU lists of destination nodes, it is built once per
+ * process on first use and is immutable afterwards.
+ */
+
+typedef enum memkind_topology_attr_t
+{
+    TOPOLOGY_LOCAL_CAPACITY = 0,
+    TOPOLOGY_LOCAL_LATENCY,
+    TOPOLOGY_LOCAL_BANDWIDTH,
+    TOPOLOGY_HBW_CLOSEST,
+    TOPOLOGY_HBW_ALL,
+    TOPOLOGY_DAX_KMEM_CLOSEST,
+    TOPOLOGY_DAX_KMEM_ALL,
+    TOPOLOGY_ATTR_MAX
+} memkind_topology_attr_t;
+
+struct memkind_topology_range {
+    unsigned first;
+    unsigned num;
+};
+
+struct memkind_topology_nodes {
+    int err;
+    // set when no CPU has more than one destination node
+    bool single;
+    // first initiator node with more than one destination node
+    int multi_node;
+    unsigned num_cpus;
+    // destination nodes of CPU i are nodes[cpus[i].first ... + cpus[i].num)
+    struct memkind_topology_range *cpus;
+    int *nodes;
+    // nodemask of CPU i is masks[i * mask_words ... + mask_words)
+    unsigned mask_words;
+    unsigned long *masks;
+};
+
+const struct memkind_topology_nodes *
+memkind_topology_get(memkind_topology_attr_t attr);
+int memkind_topology_set_nodemask(memkind_topology_attr_t attr,
+                                  memkind_node_variant_t node_variant,
+                                  unsigned long *nodemask,
+                                  unsigned long maxnode);
+
+#ifdef __cplusplus
+}
+#endif
@@ -49,7 +49,13 @@ enum class kinds
     LOWEST_LATENCY_LOCAL = 19,
     LOWEST_LATENCY_LOCAL_PREFERRED = 20,
     HIGHEST_BANDWIDTH_LOCAL = 21,
-    HIGHEST_BANDWIDTH_LOCAL_PREFERRED = 22
+    HIGHEST_BANDWIDTH_LOCAL_PREFERRED = 22,
+    DEFAULT_THP = 23,
+    HBW_THP = 24,
+    DAX_KMEM_THP = 25,
+    HUGETLB_1GB = 26,
+    HBW_HUGETLB_1GB = 27,
+    DAX_KMEM_HUGETLB_1GB = 28
 };
 
 namespace static_kind
@@ -158,6 +164,24 @@ public:
             case libmemkind::kinds::HIGHEST_BANDWIDTH_LOCAL_PREFERRED:
                 _kind = MEMKIND_HIGHEST_BANDWIDTH_LOCAL_PREFERRED;
                 break;
+            case libmemkind::kinds::DEFAULT_THP:
+                _kind = MEMKIND_DEFAULT_THP;
+                break;
+            case libmemkind::kinds::HBW_THP:
+                _kind = MEMKIND_HBW_THP;
+                break;
+            case libmemkind::kinds::DAX_KMEM_THP:
+                _kind = MEMKIND_DAX_KMEM_THP;
+                break;
+            case libmemkind::kinds::HUGETLB_1GB:
+                _kind = MEMKIND_HUGETLB_1GB;
+                break;
+            case libmemkind::kinds::HBW_HUGETLB_1GB:
+                _kind = MEMKIND_HBW_HUGETLB_1GB;
+                break;
+            case libmemkind::kinds::DAX_KMEM_HUGETLB_1GB:
+                _kind = MEMKIND_DAX_KMEM_HUGETLB_1GB;
+                break;
             default:
                 throw std::runtime_error("Unknown libmemkind::kinds");
                 break;
@@ -210,6 +210,29 @@ static inline void memtier_free(void *ptr)
 ///
 size_t memtier_kind_allocated_size(memkind_t kind);
 
+///
+/// \brief Place memory region mapped outside of memkind in memtier memory
+/// \note STANDARD API
+/// \param memory memtier memory
+/// \param addr start of anonymous private memory region
+/// \param size size of the region
+/// \return Memory kind chosen by memtier policy, NULL on failure
+/// \note Region is bound to NUMA nodes of the chosen kind and its size is
+///       added to the allocated size of the kind. Kinds backed by file
+///       (e.g. FS_DAX) are skipped.
+///
+memkind_t memtier_place_region(struct memtier_memory *memory, void *addr,
+                               size_t size);
+
+///
+/// \brief Remove part of region placed with memtier_place_region() from
+///        allocated size of the kind
+/// \note STANDARD API
+/// \param kind memory kind returned by memtier_place_region()
+/// \param size size of the released part of the region
+///
+void memtier_release_region(memkind_t kind, size_t size);
+
 ///
 /// \brief Set memtier property
 /// \note STANDARD API
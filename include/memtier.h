@@ -0,0 +1,42 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/* Copyright (C) 2022 Intel Corporation. */
+
+#pragma once
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <memkind_memtier.h>
+
+/**
+ * Header file for the functions exported by libmemtier.so, the memory
+ * tiering library loaded with LD_PRELOAD.
+ * More details in libmemtier(7) man page.
+ *
+ * Applications which have to run also without libmemtier.so should
+ * declare these functions as weak symbols and check them for NULL.
+ */
+
+///
+/// \brief Pin calling thread to a single tier
+/// \note STANDARD API
+/// \param tier zero-based index of tier in MEMKIND_MEM_TIERS, negative
+///        value removes the pin
+/// \return Operation status, 0 on success, EINVAL when tier is not defined,
+///         EAGAIN when tiers are not created yet
+///
+int memtier_thread_set_tier(int tier);
+
+///
+/// \brief Route allocations of calling thread to memtier memory
+/// \note STANDARD API
+/// \param memory memtier memory created by the application, NULL removes
+///        the override
+/// \note Memory must not be deleted while the thread uses it. Pin set with
+///       this function has priority over thread rules.
+///
+void memtier_thread_set_memory(struct memtier_memory *memory);
+
+#ifdef __cplusplus
+}
+#endif
@@ -17,9 +17,14 @@
 #include <memkind/internal/memkind_interleave.h>
 #include <memkind/internal/memkind_local.h>
 #include <memkind/internal/memkind_log.h>
+#include <memkind/internal/memkind_mem_attributes.h>
+#include <memkind/internal/memkind_nodemask.h>
 #include <memkind/internal/memkind_pmem.h>
+#include <memkind/internal/memkind_pmem_persistent.h>
 #include <memkind/internal/memkind_private.h>
 #include <memkind/internal/memkind_regular.h>
+#include <memkind/internal/memkind_spill.h>
+#include <memkind/internal/memkind_thp.h>
 #include <memkind/internal/tbb_wrapper.h>
 
 #include "config.h"
@@ -29,6 +34,7 @@
 #include <fcntl.h>
 #include <limits.h>
 #include <numa.h>
+#include <numaif.h>
 #include <pthread.h>
 #include <signal.h>
 #include <stdint.h>
@@ -209,6 +215,42 @@ static struct memkind MEMKIND_HIGHEST_BANDWIDTH_LOCAL_PREFERRED_STATIC = {
     .init_once = PTHREAD_ONCE_INIT,
 };
 
+static struct memkind MEMKIND_DEFAULT_THP_STATIC = {
+    .ops = &MEMKIND_DEFAULT_THP_OPS,
+    .name = "memkind_default_thp",
+    .init_once = PTHREAD_ONCE_INIT,
+};
+
+static struct memkind MEMKIND_HBW_THP_STATIC = {
+    .ops = &MEMKIND_HBW_THP_OPS,
+    .name = "memkind_hbw_thp",
+    .init_once = PTHREAD_ONCE_INIT,
+};
+
+static struct memkind MEMKIND_DAX_KMEM_THP_STATIC = {
+    .ops = &MEMKIND_DAX_KMEM_THP_OPS,
+    .name = "memkind_dax_kmem_thp",
+    .init_once = PTHREAD_ONCE_INIT,
+};
+
+static struct memkind MEMKIND_HUGETLB_1GB_STATIC = {
+    .ops = &MEMKIND_HUGETLB_1GB_OPS,
+    .name = "memkind_hugetlb_1gb",
+    .init_once = PTHREAD_ONCE_INIT,
+};
+
+static struct memkind MEMKIND_HBW_HUGETLB_1GB_STATIC = {
+    .ops = &MEMKIND_HBW_HUGETLB_1GB_OPS,
+    .name = "memkind_hbw_hugetlb_1gb",
+    .init_once = PTHREAD_ONCE_INIT,
+};
+
+static struct memkind MEMKIND_DAX_KMEM_HUGETLB_1GB_STATIC = {
+    .ops = &MEMKIND_DAX_KMEM_HUGETLB_1GB_OPS,
+    .name = "memkind_dax_kmem_hugetlb_1gb",
+    .init_once = PTHREAD_ONCE_INIT,
+};
+
 // clang-format off
 MEMKIND_EXPORT struct memkind *MEMKIND_DEFAULT = &MEMKIND_DEFAULT_STATIC;
 MEMKIND_EXPORT struct memkind *MEMKIND_HUGETLB = &MEMKIND_HUGETLB_STATIC;
@@ -233,6 +275,12 @@ MEMKIND_EXPORT struct memkind *MEMKIND_LOWEST_LATENCY_LOCAL = &MEMKIND_LOWEST_LA
 MEMKIND_EXPORT struct memkind *MEMKIND_LOWEST_LATENCY_LOCAL_PREFERRED = &MEMKIND_LOWEST_LATENCY_LOCAL_PREFERRED_STATIC;
 MEMKIND_EXPORT struct memkind *MEMKIND_HIGHEST_BANDWIDTH_LOCAL = &MEMKIND_HIGHEST_BANDWIDTH_LOCAL_STATIC;
 MEMKIND_EXPORT struct memkind *MEMKIND_HIGHEST_BANDWIDTH_LOCAL_PREFERRED = &MEMKIND_HIGHEST_BANDWIDTH_LOCAL_PREFERRED_STATIC;
+MEMKIND_EXPORT struct memkind *MEMKIND_DEFAULT_THP = &MEMKIND_DEFAULT_THP_STATIC;
+MEMKIND_EXPORT struct memkind *MEMKIND_HBW_THP = &MEMKIND_HBW_THP_STATIC;
+MEMKIND_EXPORT struct memkind *MEMKIND_DAX_KMEM_THP = &MEMKIND_DAX_KMEM_THP_STATIC;
+MEMKIND_EXPORT struct memkind *MEMKIND_HUGETLB_1GB = &MEMKIND_HUGETLB_1GB_STATIC;
+MEMKIND_EXPORT struct memkind *MEMKIND_HBW_HUGETLB_1GB = &MEMKIND_HBW_HUGETLB_1GB_STATIC;
+MEMKIND_EXPORT struct memkind *MEMKIND_DAX_KMEM_HUGETLB_1GB = &MEMKIND_DAX_KMEM_HUGETLB_1GB_STATIC;
 
 struct memkind_registry {
     struct memkind *partition_map[MEMKIND_MAX_KIND];
@@ -265,6 +313,12 @@ static struct memkind_registry memkind_registry_g = {
         &MEMKIND_LOWEST_LATENCY_LOCAL_PREFERRED_STATIC,
         &MEMKIND_HIGHEST_BANDWIDTH_LOCAL_STATIC,
         &MEMKIND_HIGHEST_BANDWIDTH_LOCAL_PREFERRED_STATIC,
+        &MEMKIND_DEFAULT_THP_STATIC,
+        &MEMKIND_HBW_THP_STATIC,
+        &MEMKIND_DAX_KMEM_THP_STATIC,
+        &MEMKIND_HUGETLB_1GB_STATIC,
+        &MEMKIND_HBW_HUGETLB_1GB_STATIC,
+        &MEMKIND_DAX_KMEM_HUGETLB_1GB_STATIC,
     },
     MEMKIND_NUM_STATIC_KINDS,
     PTHREAD_MUTEX_INITIALIZER
@@ -296,6 +350,8 @@ static int validate_memtype_bits(memkind_memtype_t memtype)
 static int validate_flags_bits(memkind_bits_t flags)
 {
     CLEAR_BIT(flags, MEMKIND_MASK_PAGE_SIZE_2MB);
+    CLEAR_BIT(flags, MEMKIND_MASK_PAGE_SIZE_1GB);
+    CLEAR_BIT(flags, MEMKIND_MASK_THP);
 
     if (flags != 0)
         return -1;
@@ -326,8 +382,12 @@ static struct create_args supported_args[] = {
     {&MEMKIND_HBW_PREFERRED_STATIC, MEMKIND_POLICY_PREFERRED_LOCAL, 0, MEMKIND_MEMTYPE_HIGH_BANDWIDTH},
     {&MEMKIND_HBW_PREFERRED_HUGETLB_STATIC, MEMKIND_POLICY_PREFERRED_LOCAL, MEMKIND_MASK_PAGE_SIZE_2MB, MEMKIND_MEMTYPE_HIGH_BANDWIDTH},
     {&MEMKIND_HBW_INTERLEAVE_STATIC, MEMKIND_POLICY_INTERLEAVE_ALL, 0, MEMKIND_MEMTYPE_HIGH_BANDWIDTH},
+    {&MEMKIND_HBW_THP_STATIC, MEMKIND_POLICY_BIND_LOCAL, MEMKIND_MASK_THP, MEMKIND_MEMTYPE_HIGH_BANDWIDTH},
+    {&MEMKIND_HBW_HUGETLB_1GB_STATIC, MEMKIND_POLICY_BIND_LOCAL, MEMKIND_MASK_PAGE_SIZE_1GB, MEMKIND_MEMTYPE_HIGH_BANDWIDTH},
     {&MEMKIND_DEFAULT_STATIC, MEMKIND_POLICY_PREFERRED_LOCAL, 0, MEMKIND_MEMTYPE_DEFAULT},
     {&MEMKIND_HUGETLB_STATIC, MEMKIND_POLICY_PREFERRED_LOCAL, MEMKIND_MASK_PAGE_SIZE_2MB, MEMKIND_MEMTYPE_DEFAULT},
+    {&MEMKIND_DEFAULT_THP_STATIC, MEMKIND_POLICY_PREFERRED_LOCAL, MEMKIND_MASK_THP, MEMKIND_MEMTYPE_DEFAULT},
+    {&MEMKIND_HUGETLB_1GB_STATIC, MEMKIND_POLICY_PREFERRED_LOCAL, MEMKIND_MASK_PAGE_SIZE_1GB, MEMKIND_MEMTYPE_DEFAULT},
     {&MEMKIND_INTERLEAVE_STATIC, MEMKIND_POLICY_INTERLEAVE_ALL, 0, MEMKIND_MEMTYPE_HIGH_BANDWIDTH | MEMKIND_MEMTYPE_DEFAULT},
 };
 // clang-format on
@@ -542,6 +602,7 @@ static void nop(void)
 {}
 
 static int memkind_create(struct memkind_ops *ops, const char *name,
+                          const struct memkind_config *cfg,
                           struct memkind **kind)
 {
     int err;
@@ -584,7 +645,13 @@ static int memkind_create(struct memkind_ops *ops, const char *name,
         goto exit;
     }
 
-    (*kind)->partition = memkind_registry_g.num_kind;
+    // slot in registry is unique among live kinds, unlike number of kinds
+    // after destruction of some kind
+    (*kind)->partition = id_kind;
+    if (cfg) {
+        (*kind)->arena_map_len = cfg->arena_num;
+        (*kind)->arena_select = cfg->arena_select;
+    }
     err = ops->create(*kind, ops, name);
     if (err) {
         jemk_free(*kind);
@@ -603,6 +670,175 @@ exit:
     return err;
 }
 
+static int check_kind_nodemask(const struct bitmask *nodemask)
+{
+    unsigned i;
+
+    if (numa_bitmask_weight(nodemask) == 0) {
+        log_err("Cannot create kind: empty nodemask.");
+        return MEMKIND_ERROR_INVALID;
+    }
+    for (i = 0; i < nodemask->size; ++i) {
+        if (numa_bitmask_isbitset(nodemask, i) &&
+            !numa_bitmask_isbitset(numa_all_nodes_ptr, i)) {
+            log_err("Cannot create kind: node %u has no memory available.", i);
+            return MEMKIND_ERROR_MEMTYPE_NOT_AVAILABLE;
+        }
+    }
+    return MEMKIND_SUCCESS;
+}
+
+MEMKIND_EXPORT int memkind_create_kind_nodemask(const struct bitmask *nodemask,
+                                                int mbind_mode,
+                                                memkind_bits_t flags,
+                                                memkind_t *kind)
+{
+    static unsigned nodemask_kind_id;
+    struct memkind_ops *ops = &MEMKIND_NODEMASK_OPS;
+
+    if (kind == NULL || nodemask == NULL) {
+        log_err("Cannot create kind: 'kind' or 'nodemask' is NULL pointer.");
+        return MEMKIND_ERROR_INVALID;
+    }
+    if (mbind_mode != MPOL_BIND && mbind_mode != MPOL_PREFERRED &&
+        mbind_mode != MPOL_INTERLEAVE) {
+        log_err("Cannot create kind: unsupported mbind mode %d.", mbind_mode);
+        return MEMKIND_ERROR_INVALID;
+    }
+    if (flags == MEMKIND_MASK_THP) {
+        ops = &MEMKIND_NODEMASK_THP_OPS;
+        if (memkind_thp_check_available(NULL)) {
+            log_err("Cannot create kind: THP are not available.");
+            return MEMKIND_ERROR_MEMTYPE_NOT_AVAILABLE;
+        }
+    } else if (flags != 0) {
+        log_err("Cannot create kind: incorrect flags.");
+        return MEMKIND_ERROR_INVALID;
+    }
+    int err = check_kind_nodemask(nodemask);
+    if (err) {
+        return err;
+    }
+
+    char name[MEMKIND_NAME_LENGTH_PRIV];
+    snprintf(name, sizeof(name), "nodemask%u",
+             __atomic_fetch_add(&nodemask_kind_id, 1, __ATOMIC_RELAXED));
+    err = memkind_create(ops, name, NULL, kind);
+    if (err) {
+        return err;
+    }
+
+    struct memkind_nodemask *priv = (*kind)->priv;
+    copy_bitmask_to_bitmask((struct bitmask *)nodemask, priv->nodemask);
+    priv->mode = mbind_mode;
+    return MEMKIND_SUCCESS;
+}
+
+MEMKIND_EXPORT int
+memkind_create_kind_weighted_interleave(const struct bitmask *nodemask,
+                                        const unsigned *weights,
+                                        memkind_t *kind)
+{
+    static unsigned weighted_kind_id;
+    unsigned long long *node_weights;
+    unsigned i;
+
+    if (kind == NULL || nodemask == NULL) {
+        log_err("Cannot create kind: 'kind' or 'nodemask' is NULL pointer.");
+        return MEMKIND_ERROR_INVALID;
+    }
+    int err = check_kind_nodemask(nodemask);
+    if (err) {
+        return err;
+    }
+
+    node_weights = jemk_calloc(nodemask->size, sizeof(unsigned long long));
+    if (!node_weights) {
+        log_err("calloc() failed.");
+        return MEMKIND_ERROR_MALLOC;
+    }
+    if (weights) {
+        for (i = 0; i < nodemask->size; ++i) {
+            if (!numa_bitmask_isbitset(nodemask, i)) {
+                continue;
+            }
+            if (weights[i] == 0) {
+                log_err("Cannot create kind: weight of node %u is zero.", i);
+                err = MEMKIND_ERROR_INVALID;
+                goto exit;
+            }
+            node_weights[i] = weights[i];
+        }
+    } else {
+        // bandwidth reported by HMAT is the weight of node
+        err = get_nodes_bandwidth(nodemask, node_weights);
+        if (err) {
+            goto exit;
+        }
+    }
+
+    char name[MEMKIND_NAME_LENGTH_PRIV];
+    snprintf(name, sizeof(name), "weighted%u",
+             __atomic_fetch_add(&weighted_kind_id, 1, __ATOMIC_RELAXED));
+    err = memkind_create(&MEMKIND_WEIGHTED_INTERLEAVE_OPS, name, NULL, kind);
+    if (err) {
+        goto exit;
+    }
+
+    struct memkind_nodemask *priv = (*kind)->priv;
+    copy_bitmask_to_bitmask((struct bitmask *)nodemask, priv->nodemask);
+    priv->mode = MPOL_WEIGHTED_INTERLEAVE;
+    err = memkind_nodemask_set_weights(*kind, node_weights);
+    if (err) {
+        memkind_destroy_kind(*kind);
+        *kind = NULL;
+    }
+
+exit:
+    jemk_free(node_weights);
+    return err;
+}
+
+MEMKIND_EXPORT int memkind_create_kind_spill(const struct bitmask *preferred,
+                                             const struct bitmask *fallback,
+                                             unsigned watermark,
+                                             memkind_t *kind)
+{
+    static unsigned spill_kind_id;
+
+    if (kind == NULL || preferred == NULL || fallback == NULL) {
+        log_err("Cannot create kind: 'kind' or nodemask is NULL pointer.");
+        return MEMKIND_ERROR_INVALID;
+    }
+    if (watermark == 0 || watermark > 100) {
+        log_err("Cannot create kind: watermark %u is not a percentage.",
+                watermark);
+        return MEMKIND_ERROR_INVALID;
+    }
+    int err = check_kind_nodemask(preferred);
+    if (err) {
+        return err;
+    }
+    err = check_kind_nodemask(fallback);
+    if (err) {
+        return err;
+    }
+
+    char name[MEMKIND_NAME_LENGTH_PRIV];
+    snprintf(name, sizeof(name), "spill%u",
+             __atomic_fetch_add(&spill_kind_id, 1, __ATOMIC_RELAXED));
+    err = memkind_create(&MEMKIND_SPILL_OPS, name, NULL, kind);
+    if (err) {
+        return err;
+    }
+
+    struct memkind_spill *priv = (*kind)->priv;
+    copy_bitmask_to_bitmask((struct bitmask *)preferred, priv->preferred);
+    copy_bitmask_to_bitmask((struct bitmask *)fallback, priv->fallback);
+    priv->watermark = watermark;
+    return MEMKIND_SUCCESS;
+}
+
 static int memkind_use_other_heap_manager(void)
 {
 #ifdef MEMKIND_ENABLE_HEAP_MANAGER
@@ -643,6 +879,19 @@ memkind_construct(void)
             }
             memkind_arena_set_max_bg_threads(thread_limit);
         }
+
+        env = memkind_get_env("MEMKIND_VA_RESERVE_SIZE");
+        if (env) {
+            char *end;
+            errno = 0;
+            size_t reserve_size = strtoull(env, &end, 10);
+            if (*env == '\0' || *end != '\0' || errno != 0) {
+                log_fatal("Error: Wrong value of MEMKIND_VA_RESERVE_SIZE=%s",
+                          env);
+                abort();
+            }
+            memkind_arena_set_va_reserve_size(reserve_size);
+        }
     }
     memkind_set_hog_memory(memkind_get_env("MEMKIND_HOG_MEMORY"));
 }
@@ -695,13 +944,18 @@ MEMKIND_EXPORT ssize_t memkind_get_capacity(struct memkind *kind)
     ssize_t capacity = 0;
     bool all_nodes_ptr_used = false;
 
-    if (kind->ops->get_mbind_mode == memkind_preferred_get_mbind_mode ||
-        kind->ops->check_available == memkind_hbw_hugetlb_check_available) {
+    if (kind->ops->get_mbind_mode == memkind_preferred_get_mbind_mode) {
         log_err("memkind_get_capacity() failed. %s kind is not supported.",
                 kind->name);
         return -1;
     }
 
+    // hugetlb kinds are limited by huge pages reserved on their nodes
+    size_t huge_size = memkind_hugetlb_get_pagesize(kind);
+    if (huge_size) {
+        return memkind_hugetlb_get_capacity(kind, huge_size);
+    }
+
     int err = numa_available();
     if (err) {
         log_fatal("[%s] NUMA not available (error code:%d).", kind->name, err);
@@ -759,32 +1013,41 @@ MEMKIND_EXPORT ssize_t memkind_get_capacity(struct memkind *kind)
     } else if (kind->ops == &MEMKIND_FIXED_OPS) {
         struct memkind_fixed *fixed_priv = kind->priv;
         capacity = fixed_priv->size;
-    } else if (kind == MEMKIND_HUGETLB) {
-        size_t nr_hugepages_cached, nr_overcommit_hugepages_cached,
-            total_hugepages;
-        size_t pagesize = 2 << 20;
+    }
 
-        nodemask_t nodemask;
-        struct bitmask nodemask_bm = {NUMA_NUM_NODES, nodemask.n};
-        numa_bitmask_setall(&nodemask_bm);
+    return capacity;
+}
 
-        err = get_nr_hugepages_cached(pagesize, &nodemask_bm,
-                                      &nr_hugepages_cached);
-        if (err) {
-            log_err("Getting number of hugepages failed");
-            return -1;
-        }
-        err = get_nr_overcommit_hugepages_cached(
-            pagesize, &nr_overcommit_hugepages_cached);
-        if (err) {
-            log_err("Getting number of hugepages failed");
-            return -1;
-        }
-        total_hugepages = nr_hugepages_cached + nr_overcommit_hugepages_cached;
-        capacity = (ssize_t)total_hugepages * pagesize;
+MEMKIND_EXPORT int memkind_get_occupancy(struct memkind *kind,
+                                         unsigned *occupancy)
+{
+    struct bitmask *mask;
+    int err;
+
+    if (kind->ops == &MEMKIND_SPILL_OPS) {
+        struct memkind_spill *priv = kind->priv;
+        return memkind_nodes_occupancy(priv->preferred, occupancy);
+    }
+    if (kind == MEMKIND_DEFAULT) {
+        return memkind_nodes_occupancy(numa_all_nodes_ptr, occupancy);
+    }
+    if (!kind->ops->get_mbind_nodemask) {
+        log_err("memkind_get_occupancy() failed. %s kind is not supported.",
+                kind->name);
+        return MEMKIND_ERROR_INVALID;
     }
 
-    return capacity;
+    mask = numa_allocate_nodemask();
+    if (!mask) {
+        log_err("numa_allocate_nodemask() failed");
+        return MEMKIND_ERROR_MALLOC;
+    }
+    err = kind->ops->get_mbind_nodemask(kind, mask->maskp, mask->size);
+    if (!err) {
+        err = memkind_nodes_occupancy(mask, occupancy);
+    }
+    numa_free_nodemask(mask);
+    return err;
 }
 
 // clang-format off
@@ -908,6 +1171,12 @@ MEMKIND_EXPORT struct memkind_config *memkind_config_new(void)
 {
     struct memkind_config *cfg =
         (struct memkind_config *)malloc(sizeof(struct memkind_config));
+    if (cfg) {
+        cfg->policy = MEMKIND_MEM_USAGE_POLICY_DEFAULT;
+        cfg->arena_num = 0;
+        cfg->arena_select = MEMKIND_ARENA_SELECT_THREAD;
+        cfg->prealloc = MEMKIND_PMEM_PREALLOC_NONE;
+    }
     return cfg;
 }
 
@@ -935,8 +1204,28 @@ memkind_config_set_memory_usage_policy(struct memkind_config *cfg,
     cfg->policy = policy;
 }
 
-MEMKIND_EXPORT int memkind_create_pmem(const char *dir, size_t max_size,
-                                       struct memkind **kind)
+MEMKIND_EXPORT void memkind_config_set_arena_num(struct memkind_config *cfg,
+                                                 unsigned arena_num)
+{
+    cfg->arena_num = arena_num;
+}
+
+MEMKIND_EXPORT void memkind_config_set_arena_select(struct memkind_config *cfg,
+                                                    memkind_arena_select select)
+{
+    cfg->arena_select = select;
+}
+
+MEMKIND_EXPORT void
+memkind_config_set_pmem_prealloc(struct memkind_config *cfg,
+                                 memkind_pmem_prealloc prealloc)
+{
+    cfg->prealloc = prealloc;
+}
+
+static int memkind_create_pmem_internal(const char *dir, size_t max_size,
+                                        const struct memkind_config *cfg,
+                                        struct memkind **kind)
 {
     int oerrno;
 
@@ -962,7 +1251,7 @@ MEMKIND_EXPORT int memkind_create_pmem(const char *dir, size_t max_size,
 
     snprintf(name, sizeof(name), "pmem%08x", fd);
 
-    err = memkind_create(&MEMKIND_PMEM_OPS, name, kind);
+    err = memkind_create(&MEMKIND_PMEM_OPS, name, cfg, kind);
     if (err) {
         goto exit;
     }
@@ -973,12 +1262,23 @@ MEMKIND_EXPORT int memkind_create_pmem(const char *dir, size_t max_size,
     priv->offset = 0;
     priv->current_size = 0;
     priv->max_size = max_size;
+    priv->base = NULL;
     priv->dir = jemk_malloc(strlen(dir) + 1);
     if (!priv->dir) {
         goto exit;
     }
     memcpy(priv->dir, dir, strlen(dir));
 
+    if (cfg && cfg->prealloc != MEMKIND_PMEM_PREALLOC_NONE) {
+        err = memkind_pmem_preallocate(
+            *kind, cfg->prealloc == MEMKIND_PMEM_PREALLOC_POPULATE);
+        if (err) {
+            // file is closed with the kind
+            memkind_destroy_kind(*kind);
+            *kind = NULL;
+        }
+    }
+
     return err;
 
 exit:
@@ -990,10 +1290,28 @@ exit:
     return err;
 }
 
+MEMKIND_EXPORT int memkind_create_pmem(const char *dir, size_t max_size,
+                                       struct memkind **kind)
+{
+    return memkind_create_pmem_internal(dir, max_size, NULL, kind);
+}
+
 MEMKIND_EXPORT int memkind_create_pmem_with_config(struct memkind_config *cfg,
                                                    struct memkind **kind)
 {
-    int status = memkind_create_pmem(cfg->pmem_dir, cfg->pmem_size, kind);
+    if ((unsigned)cfg->arena_select >= MEMKIND_ARENA_SELECT_MAX_VALUE) {
+        log_err("Unrecognized arena selection strategy %d", cfg->arena_select);
+        return MEMKIND_ERROR_INVALID;
+    }
+    if ((unsigned)cfg->prealloc >= MEMKIND_PMEM_PREALLOC_MAX_VALUE ||
+        (cfg->prealloc != MEMKIND_PMEM_PREALLOC_NONE && !cfg->pmem_size)) {
+        log_err("Cannot create pmem: invalid preallocation mode %d",
+                cfg->prealloc);
+        return MEMKIND_ERROR_INVALID;
+    }
+
+    int status =
+        memkind_create_pmem_internal(cfg->pmem_dir, cfg->pmem_size, cfg, kind);
     if (MEMKIND_LIKELY(!status)) {
         status = (*kind)->ops->update_memory_usage_policy(*kind, cfg->policy);
     }
@@ -1001,13 +1319,160 @@ MEMKIND_EXPORT int memkind_create_pmem_with_config(struct memkind_config *cfg,
     return status;
 }
 
+MEMKIND_EXPORT int memkind_create_pmem_persistent(const char *path,
+                                                  size_t max_size,
+                                                  memkind_t *kind)
+{
+    int fd = -1;
+    char name[16];
+
+    if (max_size && max_size < MEMKIND_PMEM_MIN_SIZE) {
+        log_err(
+            "Cannot create persistent pmem: invalid size: %zu - size must be equal 0 or greater than or equal to MEMKIND_PMEM_MIN_SIZE",
+            max_size);
+        return MEMKIND_ERROR_INVALID;
+    }
+
+    if (max_size) {
+        max_size = roundup(max_size, MEMKIND_PMEM_CHUNK_SIZE);
+    }
+
+    int err = memkind_pmem_persistent_open_file(path, &fd);
+    if (err) {
+        return err;
+    }
+
+    snprintf(name, sizeof(name), "pmemp%08x", fd);
+
+    err = memkind_create(&MEMKIND_PMEM_PERSISTENT_OPS, name, NULL, kind);
+    if (err) {
+        (void)close(fd);
+        return err;
+    }
+
+    err = memkind_pmem_persistent_map(*kind, fd, max_size);
+    if (err) {
+        // file is closed with the kind
+        memkind_destroy_kind(*kind);
+        *kind = NULL;
+    }
+    return err;
+}
+
+MEMKIND_EXPORT void *memkind_pmem_get_root(memkind_t kind)
+{
+    if (kind->ops != &MEMKIND_PMEM_PERSISTENT_OPS) {
+        return NULL;
+    }
+    return memkind_pmem_persistent_get_root(kind);
+}
+
+MEMKIND_EXPORT int memkind_pmem_set_root(memkind_t kind, void *ptr)
+{
+    if (kind->ops != &MEMKIND_PMEM_PERSISTENT_OPS) {
+        log_err("Kind %s is not persistent PMEM kind.", kind->name);
+        return MEMKIND_ERROR_INVALID;
+    }
+    return memkind_pmem_persistent_set_root(kind, ptr);
+}
+
+MEMKIND_EXPORT int memkind_pmem_flush(memkind_t kind, const void *addr,
+                                      size_t len)
+{
+    if (kind->ops == &MEMKIND_PMEM_OPS) {
+        if (!memkind_pmem_range_mapped(kind, addr, len)) {
+            log_err("Range %p is outside of kind %s.", addr, kind->name);
+            return MEMKIND_ERROR_INVALID;
+        }
+        // file of PMEM kind is not mapped with MAP_SYNC
+        return memkind_pmem_flush_range(false, addr, len);
+    } else if (kind->ops == &MEMKIND_PMEM_PERSISTENT_OPS) {
+        return memkind_pmem_persistent_flush(kind, addr, len);
+    }
+    log_err("Kind %s is not file-backed PMEM kind.", kind->name);
+    return MEMKIND_ERROR_INVALID;
+}
+
+MEMKIND_EXPORT void memkind_pmem_drain(void)
+{
+    memkind_pmem_drain_stores();
+}
+
+MEMKIND_EXPORT int memkind_pmem_persist(memkind_t kind, const void *addr,
+                                        size_t len)
+{
+    int err = memkind_pmem_flush(kind, addr, len);
+    if (!err) {
+        memkind_pmem_drain_stores();
+    }
+    return err;
+}
+
+MEMKIND_EXPORT int memkind_create_shared(const char *name, size_t size,
+                                         memkind_t *kind)
+{
+    int fd = -1;
+    bool created;
+    char kind_name[16];
+
+    int err = memkind_shared_open(name, &fd, &created);
+    if (err) {
+        return err;
+    }
+
+    snprintf(kind_name, sizeof(kind_name), "shared%08x", fd);
+
+    err = memkind_create(&MEMKIND_SHARED_OPS, kind_name, NULL, kind);
+    if (err) {
+        (void)close(fd);
+    } else {
+        err = memkind_shared_map(*kind, fd, created, size);
+        if (err) {
+            // file is closed with the kind
+            memkind_destroy_kind(*kind);
+            *kind = NULL;
+        }
+    }
+    // heap which failed to initialize is not left for other processes
+    if (err && created) {
+        (void)shm_unlink(name);
+    }
+    return err;
+}
+
+MEMKIND_EXPORT int memkind_unlink_shared(const char *name)
+{
+    if (shm_unlink(name) != 0) {
+        log_err("Could not unlink shared memory %s: errno=%d.", name, errno);
+        return MEMKIND_ERROR_INVALID;
+    }
+    return MEMKIND_SUCCESS;
+}
+
+MEMKIND_EXPORT size_t memkind_shared_get_offset(memkind_t kind,
+                                                const void *ptr)
+{
+    if (kind->ops != &MEMKIND_SHARED_OPS) {
+        return 0;
+    }
+    return memkind_pmem_persistent_offset(kind, ptr);
+}
+
+MEMKIND_EXPORT void *memkind_shared_get_ptr(memkind_t kind, size_t offset)
+{
+    if (kind->ops != &MEMKIND_SHARED_OPS) {
+        return NULL;
+    }
+    return memkind_pmem_persistent_ptr(kind, offset);
+}
+
 MEMKIND_EXPORT int memkind_create_fixed(void *addr, size_t size,
                                         memkind_t *kind)
 {
     char name[80];
     snprintf(name, sizeof(name), "fixed%p", addr);
 
-    int err = memkind_create(&MEMKIND_FIXED_OPS, name, kind);
+    int err = memkind_create(&MEMKIND_FIXED_OPS, name, NULL, kind);
     if (err)
         return err;
 
@@ -1046,6 +1511,40 @@ MEMKIND_EXPORT void *memkind_defrag_reallocate(memkind_t kind, void *ptr)
     }
 }
 
+MEMKIND_EXPORT size_t memkind_defrag_reallocate_batch(memkind_t kind,
+                                                      void **ptrs, size_t n,
+                                                      bool *moved)
+{
+    size_t i, num_moved = 0;
+
+    for (i = 0; i < n; ++i) {
+        void *ptr_new = memkind_defrag_reallocate(kind, ptrs[i]);
+        if (ptr_new) {
+            ptrs[i] = ptr_new;
+            ++num_moved;
+        }
+        if (moved) {
+            moved[i] = ptr_new != NULL;
+        }
+    }
+    return num_moved;
+}
+
+MEMKIND_EXPORT int memkind_get_utilization(memkind_t kind, double *utilization)
+{
+    return memkind_arena_get_utilization(kind, utilization);
+}
+
+MEMKIND_EXPORT int
+memkind_set_defrag_trigger(memkind_t kind, double threshold,
+                           unsigned interval_ms,
+                           void (*defrag_cb)(memkind_t kind, void *arg),
+                           void *arg)
+{
+    return memkind_arena_set_defrag_trigger(kind, threshold, interval_ms,
+                                            defrag_cb, arg);
+}
+
 MEMKIND_EXPORT int memkind_get_stat(memkind_t kind, memkind_stat_type stat,
                                     size_t *value)
 {
@@ -1061,6 +1560,70 @@ MEMKIND_EXPORT int memkind_get_stat(memkind_t kind, memkind_stat_type stat,
     }
 }
 
+MEMKIND_EXPORT int memkind_get_stats_snapshot(memkind_t *kinds, size_t n,
+                                              struct memkind_stats *out)
+{
+    size_t i;
+    int stat;
+
+    if (m_update_cached_stats()) {
+        log_err("Cannot update cached statistics.");
+        return MEMKIND_ERROR_INVALID;
+    }
+
+    for (i = 0; i < n; ++i) {
+        for (stat = 0; stat < MEMKIND_STAT_TYPE_MAX_VALUE; ++stat) {
+            int err = kinds[i] ? kinds[i]->ops->get_stat(kinds[i], stat,
+                                                         &out[i].stat[stat])
+                               : m_get_global_stat(stat, &out[i].stat[stat]);
+            if (err) {
+                return err;
+            }
+        }
+    }
+    return MEMKIND_SUCCESS;
+}
+
+MEMKIND_EXPORT int
+memkind_get_arena_stats(memkind_t *kinds, size_t n,
+                        void (*cb)(memkind_t kind,
+                                   const struct memkind_arena_stats *stats,
+                                   void *arg),
+                        void *arg)
+{
+    size_t i;
+    int err = MEMKIND_SUCCESS;
+
+    if (memkind_arena_update_cached_stats()) {
+        log_err("Cannot update cached statistics.");
+        return MEMKIND_ERROR_INVALID;
+    }
+
+    // without kinds filter report all registered kinds, registry is locked
+    // so kinds are not destroyed meanwhile
+    if (!kinds) {
+        n = MEMKIND_MAX_KIND;
+        if (pthread_mutex_lock(&memkind_registry_g.lock) != 0)
+            assert(0 && "failed to acquire mutex");
+    }
+    for (i = 0; i < n; ++i) {
+        struct memkind *kind =
+            kinds ? kinds[i] : memkind_registry_g.partition_map[i];
+        if (!kind) {
+            continue;
+        }
+        err = memkind_arena_get_arena_stats(kind, cb, arg);
+        if (err) {
+            break;
+        }
+    }
+    if (!kinds) {
+        if (pthread_mutex_unlock(&memkind_registry_g.lock) != 0)
+            assert(0 && "failed to release mutex");
+    }
+    return err;
+}
+
 MEMKIND_EXPORT int memkind_check_dax_path(const char *pmem_dir)
 {
     return memkind_pmem_validate_dir(pmem_dir);
@@ -1083,3 +1646,20 @@ MEMKIND_EXPORT void memkind_set_allow_zero_allocs(memkind_t kind,
 {
     kind->allow_zero_allocs = allow_zero_allocs;
 }
+
+MEMKIND_EXPORT int memkind_set_prefault_pool(memkind_t kind, size_t pool_size,
+                                             size_t low_watermark)
+{
+    return memkind_arena_set_prefault_pool(kind, pool_size, low_watermark);
+}
+
+MEMKIND_EXPORT int memkind_set_decay(memkind_t kind, ssize_t dirty_decay_ms,
+                                     ssize_t muzzy_decay_ms)
+{
+    return memkind_arena_set_decay(kind, dirty_decay_ms, muzzy_decay_ms);
+}
+
+MEMKIND_EXPORT int memkind_purge(memkind_t kind)
+{
+    return memkind_arena_purge(kind);
+}
@@ -4,8 +4,11 @@
 #include <memkind.h>
 #include <memkind/internal/memkind_arena.h>
 #include <memkind/internal/memkind_default.h>
+#include <memkind/internal/memkind_hugetlb.h>
 #include <memkind/internal/memkind_log.h>
+#include <memkind/internal/memkind_memcpy.h>
 #include <memkind/internal/memkind_private.h>
+#include <memkind/internal/memkind_thp.h>
 
 #include <assert.h>
 #include <errno.h>
@@ -18,6 +21,7 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sys/mman.h>
 #include <sys/param.h>
 #include <unistd.h>
@@ -43,6 +47,18 @@ typedef struct arena_config_s arena_config_t;
 #define HUGE_PAGE_SIZE  (1ull << MEMKIND_MASK_PAGE_SIZE_2MB)
 #define PAGE_2_BYTES(x) ((x) << 12)
 
+#define VA_RESERVE_SIZE_DEFAULT (1ull << 30)
+#define VA_RESERVE_SLOTS        4
+#define VA_COMMIT_STEP          (32ull << 20)
+
+#ifndef MADV_FREE
+#define MADV_FREE 8
+#endif
+
+#ifndef MADV_POPULATE_WRITE
+#define MADV_POPULATE_WRITE 23
+#endif
+
 /* Clear bits in x, but only this specified in mask. */
 #define CLEAR_BIT(x, mask) ((x) &= (~(mask)))
 
@@ -64,8 +80,101 @@ static const struct stats_arena arena_stats[MEMKIND_STAT_TYPE_MAX_VALUE] = {
      .stats_no = 2},
 };
 
+#define STAT_MIB_MAX_LEN   8
+#define STAT_MIB_MAX_INDEX 2
+
+// Management Information Base of mallctl name, translated once to avoid
+// parsing name on every statistic read
+struct stat_mib {
+    size_t mib[STAT_MIB_MAX_LEN];
+    size_t len;
+    // positions of indexes (arena, size class) in mib, 0 - no index
+    size_t index_pos[STAT_MIB_MAX_INDEX];
+    int err; // translation of name to mib failed
+};
+
+typedef enum
+{
+    DETAIL_STAT_NBINS,
+    DETAIL_STAT_NLEXTENTS,
+    DETAIL_STAT_BIN_SIZE,
+    DETAIL_STAT_BIN_NREGS,
+    DETAIL_STAT_LEXTENT_SIZE,
+    DETAIL_STAT_PDIRTY,
+    DETAIL_STAT_PMUZZY,
+    DETAIL_STAT_RETAINED,
+    DETAIL_STAT_BIN_NMALLOC,
+    DETAIL_STAT_BIN_NDALLOC,
+    DETAIL_STAT_BIN_CURREGS,
+    DETAIL_STAT_BIN_CURSLABS,
+    DETAIL_STAT_BIN_LOCK_OPS,
+    DETAIL_STAT_BIN_LOCK_WAIT,
+    DETAIL_STAT_BIN_LOCK_WAIT_TIME,
+    DETAIL_STAT_LEXTENT_NMALLOC,
+    DETAIL_STAT_LEXTENT_NDALLOC,
+    DETAIL_STAT_LEXTENT_CUR,
+    DETAIL_STAT_EXTENT_NDIRTY,
+    DETAIL_STAT_EXTENT_NMUZZY,
+    DETAIL_STAT_EXTENT_NRETAINED,
+    DETAIL_STAT_MAX_VALUE
+} detail_stat_t;
+
+static const char *const detail_stats[DETAIL_STAT_MAX_VALUE] = {
+    [DETAIL_STAT_NBINS] = "arenas.nbins",
+    [DETAIL_STAT_NLEXTENTS] = "arenas.nlextents",
+    [DETAIL_STAT_BIN_SIZE] = "arenas.bin.%u.size",
+    [DETAIL_STAT_BIN_NREGS] = "arenas.bin.%u.nregs",
+    [DETAIL_STAT_LEXTENT_SIZE] = "arenas.lextent.%u.size",
+    [DETAIL_STAT_PDIRTY] = "stats.arenas.%u.pdirty",
+    [DETAIL_STAT_PMUZZY] = "stats.arenas.%u.pmuzzy",
+    [DETAIL_STAT_RETAINED] = "stats.arenas.%u.retained",
+    [DETAIL_STAT_BIN_NMALLOC] = "stats.arenas.%u.bins.%u.nmalloc",
+    [DETAIL_STAT_BIN_NDALLOC] = "stats.arenas.%u.bins.%u.ndalloc",
+    [DETAIL_STAT_BIN_CURREGS] = "stats.arenas.%u.bins.%u.curregs",
+    [DETAIL_STAT_BIN_CURSLABS] = "stats.arenas.%u.bins.%u.curslabs",
+    [DETAIL_STAT_BIN_LOCK_OPS] = "stats.arenas.%u.bins.%u.mutex.num_ops",
+    [DETAIL_STAT_BIN_LOCK_WAIT] = "stats.arenas.%u.bins.%u.mutex.num_wait",
+    [DETAIL_STAT_BIN_LOCK_WAIT_TIME] =
+        "stats.arenas.%u.bins.%u.mutex.total_wait_time",
+    [DETAIL_STAT_LEXTENT_NMALLOC] = "stats.arenas.%u.lextents.%u.nmalloc",
+    [DETAIL_STAT_LEXTENT_NDALLOC] = "stats.arenas.%u.lextents.%u.ndalloc",
+    [DETAIL_STAT_LEXTENT_CUR] = "stats.arenas.%u.lextents.%u.curlextents",
+    [DETAIL_STAT_EXTENT_NDIRTY] = "stats.arenas.%u.extents.%u.ndirty",
+    [DETAIL_STAT_EXTENT_NMUZZY] = "stats.arenas.%u.extents.%u.nmuzzy",
+    [DETAIL_STAT_EXTENT_NRETAINED] = "stats.arenas.%u.extents.%u.nretained",
+};
+
+// arena mutexes which contention is reported in arena statistics
+static const char *const arena_mutexes[] = {
+    "large", "extent_avail", "extents_dirty", "extents_muzzy",
+    "extents_retained", "decay_dirty", "decay_muzzy", "base", "tcache_list"};
+
+#define ARENA_MUTEX_NUM (sizeof(arena_mutexes) / sizeof(arena_mutexes[0]))
+
+typedef enum
+{
+    MUTEX_STAT_NUM_OPS,
+    MUTEX_STAT_NUM_WAIT,
+    MUTEX_STAT_TOTAL_WAIT_TIME,
+    MUTEX_STAT_MAX_VALUE
+} mutex_stat_t;
+
+static const char *const mutex_stats[MUTEX_STAT_MAX_VALUE] = {
+    "num_ops", "num_wait", "total_wait_time"};
+
+static struct stat_mib arena_stats_mib[MEMKIND_STAT_TYPE_MAX_VALUE]
+                                      [ARENA_STAT_MAX];
+static struct stat_mib global_stats_mib[MEMKIND_STAT_TYPE_MAX_VALUE];
+static struct stat_mib detail_stats_mib[DETAIL_STAT_MAX_VALUE];
+static struct stat_mib mutex_stats_mib[ARENA_MUTEX_NUM][MUTEX_STAT_MAX_VALUE];
+static struct stat_mib arena_initialized_mib;
+static struct stat_mib epoch_mib;
+static pthread_once_t stats_mib_once = PTHREAD_ONCE_INIT;
+
 static void *jemk_mallocx_check(size_t size, int flags, bool allow_zero_allocs);
 static void tcache_finalize(void *args);
+static void dynamic_tcache_destroy(unsigned partition);
+static void defrag_trigger_remove(struct memkind *kind);
 
 static unsigned integer_log2(unsigned v)
 {
@@ -82,6 +191,27 @@ static unsigned round_pow2_up(unsigned v)
     return v;
 }
 
+// NUMA node of each CPU, used by MEMKIND_ARENA_SELECT_NODE
+static int *arena_cpu_node_g;
+static int arena_cpu_node_len_g;
+static pthread_once_t arena_cpu_node_once_g = PTHREAD_ONCE_INIT;
+
+static void arena_cpu_node_init(void)
+{
+    int i, num_cpus = numa_num_configured_cpus();
+    int *cpu_node = jemk_malloc(num_cpus * sizeof(int));
+    if (!cpu_node) {
+        log_err("malloc() failed.");
+        return;
+    }
+    for (i = 0; i < num_cpus; ++i) {
+        int node = numa_node_of_cpu(i);
+        cpu_node[i] = node < 0 ? 0 : node;
+    }
+    arena_cpu_node_len_g = num_cpus;
+    arena_cpu_node_g = cpu_node;
+}
+
 MEMKIND_EXPORT int memkind_set_arena_map_len(struct memkind *kind)
 {
     if (kind->ops->get_arena == memkind_bijective_get_arena) {
@@ -89,7 +219,23 @@ MEMKIND_EXPORT int memkind_set_arena_map_len(struct memkind *kind)
     } else if (kind->ops->get_arena == memkind_thread_get_arena) {
         char *arena_num_env = memkind_get_env("MEMKIND_ARENA_NUM_PER_KIND");
 
-        if (arena_num_env) {
+        if (kind->arena_select == MEMKIND_ARENA_SELECT_NODE) {
+            pthread_once(&arena_cpu_node_once_g, arena_cpu_node_init);
+        }
+
+        if (kind->arena_select == MEMKIND_ARENA_SELECT_BIJECTIVE) {
+            kind->arena_map_len = 1;
+        } else if (kind->arena_map_len) {
+            // number of arenas set in kind configuration
+            if (kind->arena_map_len > INT_MAX) {
+                log_err("Wrong number of arenas: %u.", kind->arena_map_len);
+                return MEMKIND_ERROR_INVALID;
+            }
+        } else if (kind->arena_select == MEMKIND_ARENA_SELECT_CPU) {
+            kind->arena_map_len = numa_num_configured_cpus();
+        } else if (kind->arena_select == MEMKIND_ARENA_SELECT_NODE) {
+            kind->arena_map_len = numa_num_configured_nodes();
+        } else if (arena_num_env) {
             unsigned long int arena_num_value =
                 strtoul(arena_num_env, NULL, 10);
 
@@ -122,6 +268,25 @@ static pthread_once_t arena_config_once = PTHREAD_ONCE_INIT;
 static int arena_init_status;
 
 static pthread_key_t tcache_key;
+
+// Thread cache of kind partition, stale when epoch of partition has changed
+struct tcache_slot {
+    unsigned tcache;
+    unsigned epoch;
+};
+
+// Thread caches of dynamic kind created by all threads, which have to be
+// destroyed together with the kind, so cached allocations do not outlive
+// arenas of the kind
+struct tcache_list {
+    unsigned *tcache;
+    unsigned num;
+    unsigned capacity;
+};
+
+static unsigned tcache_epoch_g[MEMKIND_MAX_KIND];
+static struct tcache_list dynamic_tcache_g[MEMKIND_MAX_KIND];
+static pthread_mutex_t dynamic_tcache_lock = PTHREAD_MUTEX_INITIALIZER;
 static bool memkind_hog_memory;
 
 bool memkind_get_hog_memory(void)
@@ -188,6 +353,530 @@ static void *alloc_aligned_slow(size_t size, size_t alignment,
     return (void *)aligned_addr;
 }
 
+/*
+ * VA reservation layer: extents of kinds using anonymous private memory are
+ * carved from large PROT_NONE regions, which are bound (mbind) and advised
+ * (madvise) once, and committed with mprotect on demand, VA_COMMIT_STEP
+ * ahead of the carved extents. Extents are never
+ * returned by jemalloc (dalloc opts out), so simple bump allocation is used.
+ * Reservation is keyed by mbind mode, nodemask and madvise hook, as nodemask
+ * of some kinds depends on CPU of the calling thread.
+ * Reservation is off by default, it is enabled for all kinds with
+ * MEMKIND_VA_RESERVE_SIZE or for single kind when its prefault pool is set.
+ * Kinds backed by hugetlb pages larger than HUGE_PAGE_SIZE (1GB) share
+ * committed regions of whole huge pages instead, so arenas of such kind do
+ * not map a separate gigabyte for each (possibly small) extent.
+ * With prefault pool enabled for kind, background thread keeps up to
+ * prefault_size bytes ahead of carved extents populated (MADV_POPULATE_WRITE
+ * honours binding of reservation), so fresh extents do not take page faults.
+ */
+struct va_reservation {
+    uintptr_t cur;
+    uintptr_t committed;
+    uintptr_t populated;
+    uintptr_t end;
+    unsigned gen; // incremented when reservation is replaced
+    int mode;
+    nodemask_t nodemask;
+    int (*madvise)(struct memkind *kind, void *addr, size_t size);
+    bool busy; // prefault thread populates reservation without lock
+};
+
+struct va_reserve {
+    pthread_mutex_t lock;
+    pthread_cond_t idle; // signalled when prefault of reservation is done
+    unsigned num;
+    size_t size; // reservation size of kind, when not set globally
+    size_t prefault_size;
+    size_t prefault_low;
+    struct va_reservation slots[VA_RESERVE_SLOTS];
+};
+
+static size_t va_reserve_size;
+static struct va_reserve *va_reserve_g[MEMKIND_MAX_KIND];
+
+MEMKIND_EXPORT void memkind_arena_set_va_reserve_size(size_t size)
+{
+    va_reserve_size = size & ~(HUGE_PAGE_SIZE - 1);
+}
+
+static struct va_reserve *va_reserve_get(struct memkind *kind)
+{
+    struct va_reserve *reserve =
+        __atomic_load_n(&va_reserve_g[kind->partition], __ATOMIC_ACQUIRE);
+    if (MEMKIND_LIKELY(reserve)) {
+        return reserve;
+    }
+
+    // extent hooks should not call back into allocator
+    struct va_reserve *new_reserve =
+        mmap(NULL, sizeof(struct va_reserve), PROT_READ | PROT_WRITE,
+             MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (new_reserve == MAP_FAILED) {
+        return NULL;
+    }
+    pthread_mutex_init(&new_reserve->lock, NULL);
+    pthread_cond_init(&new_reserve->idle, NULL);
+    if (!__atomic_compare_exchange_n(&va_reserve_g[kind->partition], &reserve,
+                                     new_reserve, false, __ATOMIC_ACQ_REL,
+                                     __ATOMIC_ACQUIRE)) {
+        munmap(new_reserve, sizeof(struct va_reserve));
+        return reserve;
+    }
+    return new_reserve;
+}
+
+// Returns size of regions reserved for kind, 0 when kind does not use them.
+static size_t va_reserve_kind_size(struct memkind *kind)
+{
+    if (va_reserve_size) {
+        return va_reserve_size;
+    }
+    struct va_reserve *reserve =
+        __atomic_load_n(&va_reserve_g[kind->partition], __ATOMIC_ACQUIRE);
+    return reserve ? __atomic_load_n(&reserve->size, __ATOMIC_RELAXED) : 0;
+}
+
+// Returns 0 and binding of kind memory in key if kind could use reservations,
+// huge_size is set to size of hugetlb page for kinds using shared regions.
+static int va_reserve_key(struct memkind *kind, struct va_reservation *key,
+                          size_t *huge_size)
+{
+    int flags;
+
+    if (kind->ops->mmap) {
+        return -1;
+    }
+    if (kind->ops->get_mmap_flags) {
+        if (kind->ops->get_mmap_flags(kind, &flags)) {
+            return -1;
+        }
+    } else {
+        memkind_default_get_mmap_flags(kind, &flags);
+    }
+    *huge_size = 0;
+    if (flags & MAP_HUGETLB) {
+        *huge_size = memkind_hugetlb_get_pagesize(kind);
+        if (*huge_size <= HUGE_PAGE_SIZE) {
+            return -1;
+        }
+    } else if (flags != (MAP_PRIVATE | MAP_ANONYMOUS)) {
+        return -1;
+    }
+
+    memset(&key->nodemask, 0, sizeof(nodemask_t));
+    key->mode = -1;
+    key->madvise = kind->ops->madvise;
+    if (kind->ops->mbind == memkind_default_mbind) {
+        if (kind->ops->get_mbind_nodemask(kind, key->nodemask.n,
+                                          NUMA_NUM_NODES) ||
+            kind->ops->get_mbind_mode(kind, &key->mode)) {
+            return -1;
+        }
+    } else if (kind->ops->mbind) {
+        return -1;
+    }
+    return 0;
+}
+
+// Waits until prefault thread stops populating reservation, so its unused
+// part can be unmapped. Has to be called with reserve lock held.
+static void va_reserve_wait_idle(struct va_reserve *reserve,
+                                 struct va_reservation *res)
+{
+    while (res->busy) {
+        pthread_cond_wait(&reserve->idle, &reserve->lock);
+    }
+}
+
+static int va_reserve_new(struct memkind *kind, struct va_reserve *reserve,
+                          struct va_reservation *res, size_t reserve_size)
+{
+    // over-reserve to align reservation to huge page size
+    size_t len = reserve_size + HUGE_PAGE_SIZE;
+    void *ptr = mmap(NULL, len, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ptr == MAP_FAILED) {
+        return -1;
+    }
+
+    uintptr_t addr = ((uintptr_t)ptr + HUGE_PAGE_SIZE - 1) &
+        ~(uintptr_t)(HUGE_PAGE_SIZE - 1);
+    size_t head_len = addr - (uintptr_t)ptr;
+    if (head_len > 0) {
+        munmap(ptr, head_len);
+    }
+    munmap((void *)(addr + reserve_size), HUGE_PAGE_SIZE - head_len);
+
+    if (res->mode != -1 &&
+        mbind((void *)addr, reserve_size, res->mode, res->nodemask.n,
+              NUMA_NUM_NODES, 0)) {
+        log_err("syscall mbind() returned: %d", errno);
+        goto unmap;
+    }
+    if (res->madvise && res->madvise(kind, (void *)addr, reserve_size)) {
+        goto unmap;
+    }
+
+    // release not used tail of previous reservation
+    va_reserve_wait_idle(reserve, res);
+    if (res->end > res->cur) {
+        munmap((void *)res->cur, res->end - res->cur);
+    }
+    res->cur = res->committed = res->populated = addr;
+    res->end = addr + reserve_size;
+    res->gen++;
+    return 0;
+
+unmap:
+    munmap((void *)addr, reserve_size);
+    return -1;
+}
+
+// Maps new region of whole huge pages, it is bound and advised by kind_mmap().
+static int va_reserve_new_hugetlb(struct memkind *kind,
+                                  struct va_reserve *reserve,
+                                  struct va_reservation *res, size_t size,
+                                  size_t huge_size)
+{
+    size_t len = (size + huge_size - 1) & ~(huge_size - 1);
+    void *ptr = kind_mmap(kind, NULL, len);
+    if (ptr == MAP_FAILED) {
+        return -1;
+    }
+
+    // release not used huge pages of previous region
+    va_reserve_wait_idle(reserve, res);
+    uintptr_t tail = (res->cur + huge_size - 1) & ~(uintptr_t)(huge_size - 1);
+    if (res->end > tail) {
+        munmap((void *)tail, res->end - tail);
+    }
+    res->cur = res->populated = (uintptr_t)ptr;
+    res->committed = res->end = (uintptr_t)ptr + len;
+    res->gen++;
+    return 0;
+}
+
+// Returns reservation slot matching key, new slot is added if there is free
+// one. Has to be called with reserve lock held.
+static struct va_reservation *va_reserve_slot(struct va_reserve *reserve,
+                                              const struct va_reservation *key)
+{
+    struct va_reservation *res;
+    unsigned i;
+
+    for (i = 0; i < reserve->num; ++i) {
+        if (reserve->slots[i].mode == key->mode &&
+            reserve->slots[i].madvise == key->madvise &&
+            !memcmp(&reserve->slots[i].nodemask, &key->nodemask,
+                    sizeof(nodemask_t))) {
+            return &reserve->slots[i];
+        }
+    }
+    if (reserve->num == VA_RESERVE_SLOTS) {
+        return NULL;
+    }
+    res = &reserve->slots[reserve->num++];
+    res->cur = res->committed = res->populated = res->end = 0;
+    res->mode = key->mode;
+    res->nodemask = key->nodemask;
+    res->madvise = key->madvise;
+    return res;
+}
+
+// Commits reservation up to at least commit_end, in VA_COMMIT_STEP steps.
+// Has to be called with reserve lock held.
+static int va_reserve_commit(struct va_reservation *res, uintptr_t commit_end)
+{
+    if (commit_end <= res->committed) {
+        return 0;
+    }
+    commit_end = (commit_end + VA_COMMIT_STEP - 1) &
+        ~(uintptr_t)(VA_COMMIT_STEP - 1);
+    if (commit_end > res->end) {
+        commit_end = res->end;
+    }
+    if (mprotect((void *)res->committed, commit_end - res->committed,
+                 PROT_READ | PROT_WRITE)) {
+        log_err("syscall mprotect() returned: %d", errno);
+        return -1;
+    }
+    res->committed = commit_end;
+    return 0;
+}
+
+static void va_prefault_wakeup(void);
+
+// Carves committed extent from reservation. Returns NULL if extent cannot be
+// served from reservation - caller falls back to kind_mmap().
+static void *va_reserve_alloc(struct memkind *kind, void *new_addr,
+                              size_t size, size_t alignment)
+{
+    struct va_reservation key;
+    struct va_reservation *res;
+    void *addr = NULL;
+    bool refill = false;
+    size_t huge_size, reserve_size;
+
+    if (va_reserve_key(kind, &key, &huge_size)) {
+        return NULL;
+    }
+    reserve_size = huge_size ? 0 : va_reserve_kind_size(kind);
+    if (huge_size ? alignment > huge_size
+                  : reserve_size == 0 || size + alignment > reserve_size) {
+        return NULL;
+    }
+    struct va_reserve *reserve = va_reserve_get(kind);
+    if (!reserve) {
+        return NULL;
+    }
+
+    pthread_mutex_lock(&reserve->lock);
+    res = va_reserve_slot(reserve, &key);
+    if (!res) {
+        goto unlock;
+    }
+
+    uintptr_t start = (res->cur + alignment - 1) & ~(uintptr_t)(alignment - 1);
+    if (start + size > res->end || start < res->cur) {
+        if (new_addr ||
+            (huge_size
+                 ? va_reserve_new_hugetlb(kind, reserve, res, size, huge_size)
+                 : va_reserve_new(kind, reserve, res, reserve_size))) {
+            goto unlock;
+        }
+        start = (res->cur + alignment - 1) & ~(uintptr_t)(alignment - 1);
+    }
+    if (new_addr && (uintptr_t)new_addr != start) {
+        goto unlock;
+    }
+    if (va_reserve_commit(res, start + size)) {
+        goto unlock;
+    }
+    res->cur = start + size;
+    addr = (void *)start;
+    refill = reserve->prefault_size &&
+        res->populated < MIN(res->cur + reserve->prefault_low, res->end);
+
+unlock:
+    pthread_mutex_unlock(&reserve->lock);
+    if (refill) {
+        va_prefault_wakeup();
+    }
+    return addr;
+}
+
+/*
+ * Prefault pool refill thread. It is woken up when populated part of
+ * reservation ahead of carved extents drops below low watermark, and
+ * populates it back to prefault_size, VA_COMMIT_STEP at a time without
+ * holding reserve lock, so allocations are not blocked meanwhile. Reservation
+ * is marked busy while it is populated, so it is not unmapped meanwhile.
+ * Thread does not survive fork, it is started again in child process when
+ * any kind has prefault pool set.
+ */
+static pthread_mutex_t va_prefault_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t va_prefault_cond = PTHREAD_COND_INITIALIZER;
+static bool va_prefault_started;
+static bool va_prefault_atfork;
+static bool va_prefault_pending;
+static bool va_prefault_disabled;
+
+static void *va_prefault_thread(void *arg);
+static int va_prefault_start(void);
+
+static void va_prefault_atfork_child(void)
+{
+    unsigned i, j;
+    bool pool = false;
+
+    pthread_mutex_init(&va_prefault_lock, NULL);
+    pthread_cond_init(&va_prefault_cond, NULL);
+    va_prefault_started = false;
+    // prefault thread of parent process is not running in child
+    for (i = 0; i < MEMKIND_MAX_KIND; ++i) {
+        struct va_reserve *reserve = va_reserve_g[i];
+        if (!reserve) {
+            continue;
+        }
+        pthread_cond_init(&reserve->idle, NULL);
+        for (j = 0; j < reserve->num; ++j) {
+            reserve->slots[j].busy = false;
+        }
+        pool = pool || reserve->prefault_size;
+    }
+    if (pool) {
+        va_prefault_pending = true;
+        va_prefault_start();
+    }
+}
+
+// Has to be called with va_prefault_lock held (or in child after fork).
+static int va_prefault_start(void)
+{
+    pthread_t thread;
+    pthread_attr_t attr;
+    int err = MEMKIND_SUCCESS;
+
+    if (va_prefault_started) {
+        return MEMKIND_SUCCESS;
+    }
+    if (!va_prefault_atfork) {
+        if (pthread_atfork(NULL, NULL, va_prefault_atfork_child)) {
+            log_err("Cannot register prefault pool fork handler.");
+            return MEMKIND_ERROR_RUNTIME;
+        }
+        va_prefault_atfork = true;
+    }
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    if (pthread_create(&thread, &attr, va_prefault_thread, NULL)) {
+        log_err("Cannot create prefault pool thread.");
+        err = MEMKIND_ERROR_RUNTIME;
+    } else {
+        va_prefault_started = true;
+    }
+    pthread_attr_destroy(&attr);
+    return err;
+}
+
+static void va_prefault_wakeup(void)
+{
+    pthread_mutex_lock(&va_prefault_lock);
+    va_prefault_pending = true;
+    pthread_cond_signal(&va_prefault_cond);
+    pthread_mutex_unlock(&va_prefault_lock);
+}
+
+static void va_prefault_slot(struct va_reserve *reserve,
+                             struct va_reservation *res)
+{
+    while (!__atomic_load_n(&va_prefault_disabled, __ATOMIC_RELAXED)) {
+        pthread_mutex_lock(&reserve->lock);
+        uintptr_t from = MAX(res->populated, res->cur);
+        uintptr_t to = MIN(res->cur + reserve->prefault_size, res->end);
+        to = MIN(to, from + VA_COMMIT_STEP);
+        unsigned gen = res->gen;
+        if (from >= to || va_reserve_commit(res, to)) {
+            pthread_mutex_unlock(&reserve->lock);
+            return;
+        }
+        res->busy = true;
+        pthread_mutex_unlock(&reserve->lock);
+
+        // range could be carved meanwhile, populating keeps its content;
+        // reservation is not replaced while it is busy
+        int err = madvise((void *)from, to - from, MADV_POPULATE_WRITE);
+        int madvise_errno = errno;
+
+        pthread_mutex_lock(&reserve->lock);
+        res->busy = false;
+        pthread_cond_broadcast(&reserve->idle);
+        if (!err && res->gen == gen && res->populated < to) {
+            res->populated = to;
+        }
+        pthread_mutex_unlock(&reserve->lock);
+
+        if (err) {
+            if (madvise_errno == EINVAL) {
+                log_err("MADV_POPULATE_WRITE not supported, "
+                        "prefault pool disabled.");
+                __atomic_store_n(&va_prefault_disabled, true,
+                                 __ATOMIC_RELAXED);
+            }
+            return;
+        }
+    }
+}
+
+static void *va_prefault_thread(void *arg)
+{
+    unsigned i, j;
+
+    while (true) {
+        pthread_mutex_lock(&va_prefault_lock);
+        while (!va_prefault_pending) {
+            pthread_cond_wait(&va_prefault_cond, &va_prefault_lock);
+        }
+        va_prefault_pending = false;
+        pthread_mutex_unlock(&va_prefault_lock);
+
+        for (i = 0; i < MEMKIND_MAX_KIND; ++i) {
+            struct va_reserve *reserve =
+                __atomic_load_n(&va_reserve_g[i], __ATOMIC_ACQUIRE);
+            if (!reserve ||
+                !__atomic_load_n(&reserve->prefault_size, __ATOMIC_RELAXED)) {
+                continue;
+            }
+            for (j = 0; j < __atomic_load_n(&reserve->num, __ATOMIC_ACQUIRE);
+                 ++j) {
+                va_prefault_slot(reserve, &reserve->slots[j]);
+            }
+        }
+    }
+    return NULL;
+}
+
+int memkind_arena_set_prefault_pool(struct memkind *kind, size_t pool_size,
+                                    size_t low_watermark)
+{
+    struct va_reservation key;
+    struct va_reservation *res;
+    size_t huge_size;
+    int err = MEMKIND_SUCCESS;
+
+    if (low_watermark > pool_size || kind->ops->malloc != memkind_arena_malloc) {
+        return MEMKIND_ERROR_INVALID;
+    }
+    if (kind->ops->init_once) {
+        pthread_once(&kind->init_once, kind->ops->init_once);
+    }
+    if (va_reserve_key(kind, &key, &huge_size)) {
+        log_err("Kind %s does not support prefault pool.", kind->name);
+        return MEMKIND_ERROR_INVALID;
+    }
+    if (__atomic_load_n(&va_prefault_disabled, __ATOMIC_RELAXED)) {
+        return MEMKIND_ERROR_OPERATION_FAILED;
+    }
+    struct va_reserve *reserve = va_reserve_get(kind);
+    if (!reserve) {
+        return MEMKIND_ERROR_MMAP;
+    }
+
+    pthread_mutex_lock(&va_prefault_lock);
+    if (pool_size) {
+        err = va_prefault_start();
+    }
+    pthread_mutex_unlock(&va_prefault_lock);
+    if (err) {
+        return err;
+    }
+
+    // pool of calling thread binding is prepared upfront, before first
+    // allocation; pool enables reservation for kind, if it is not enabled
+    // globally
+    pthread_mutex_lock(&reserve->lock);
+    if (pool_size && !huge_size && !reserve->size) {
+        __atomic_store_n(&reserve->size, VA_RESERVE_SIZE_DEFAULT,
+                         __ATOMIC_RELAXED);
+    }
+    __atomic_store_n(&reserve->prefault_size, pool_size, __ATOMIC_RELAXED);
+    reserve->prefault_low = low_watermark;
+    res = va_reserve_slot(reserve, &key);
+    if (pool_size && res && res->cur == res->end) {
+        if (huge_size) {
+            va_reserve_new_hugetlb(kind, reserve, res, pool_size, huge_size);
+        } else {
+            va_reserve_new(kind, reserve, res, va_reserve_kind_size(kind));
+        }
+    }
+    pthread_mutex_unlock(&reserve->lock);
+
+    if (pool_size) {
+        va_prefault_wakeup();
+    }
+    return MEMKIND_SUCCESS;
+}
+
 void *arena_extent_alloc(extent_hooks_t *extent_hooks, void *new_addr,
                          size_t size, size_t alignment, bool *zero,
                          bool *commit, unsigned arena_ind)
@@ -199,7 +888,14 @@ void *arena_extent_alloc(extent_hooks_t *extent_hooks, void *new_addr,
         return NULL;
     }
 
-    void *addr = kind_mmap(kind, new_addr, size);
+    void *addr = va_reserve_alloc(kind, new_addr, size, alignment);
+    if (addr) {
+        *zero = true;
+        *commit = true;
+        return addr;
+    }
+
+    addr = kind_mmap(kind, new_addr, size);
     if (addr == MAP_FAILED) {
         return NULL;
     }
@@ -234,6 +930,56 @@ void *arena_extent_alloc_hugetlb(extent_hooks_t *extent_hooks, void *new_addr,
                               commit, arena_ind);
 }
 
+// Extents of kinds backed by hugetlb pages larger than HUGE_PAGE_SIZE are
+// carved from shared regions of whole huge pages. When region cannot be used,
+// mapping is rounded up to huge page size of kind, unused part of its last
+// huge page is never unmapped separately.
+void *arena_extent_alloc_hugetlb_1gb(extent_hooks_t *extent_hooks,
+                                     void *new_addr, size_t size,
+                                     size_t alignment, bool *zero,
+                                     bool *commit, unsigned arena_ind)
+{
+    struct memkind *kind = get_kind_by_arena(arena_ind);
+    size_t huge_size = memkind_hugetlb_get_pagesize(kind);
+
+    int err = memkind_check_available(kind);
+    if (err || alignment > huge_size) {
+        return NULL;
+    }
+
+    void *addr = va_reserve_alloc(kind, new_addr, size, alignment);
+    if (!addr) {
+        size_t len = (size + huge_size - 1) & ~(huge_size - 1);
+        addr = kind_mmap(kind, new_addr, len);
+        if (addr == MAP_FAILED) {
+            return NULL;
+        }
+        if (new_addr != NULL && addr != new_addr) {
+            /* wrong place */
+            munmap(addr, len);
+            return NULL;
+        }
+    }
+
+    *zero = true;
+    *commit = true;
+
+    return addr;
+}
+
+void *arena_extent_alloc_thp(extent_hooks_t *extent_hooks, void *new_addr,
+                             size_t size, size_t alignment, bool *zero,
+                             bool *commit, unsigned arena_ind)
+{
+    // align to huge page size, so extent starts at THP boundary; size is not
+    // rounded up, as jemalloc tracks only requested size of extent
+    if (alignment < HUGE_PAGE_SIZE) {
+        alignment = HUGE_PAGE_SIZE;
+    }
+    return arena_extent_alloc(extent_hooks, new_addr, size, alignment, zero,
+                              commit, arena_ind);
+}
+
 bool arena_extent_dalloc(extent_hooks_t *extent_hooks, void *addr, size_t size,
                          bool committed, unsigned arena_ind)
 {
@@ -267,6 +1013,80 @@ bool arena_extent_purge(extent_hooks_t *extent_hooks, void *addr, size_t size,
     return (err != 0);
 }
 
+// Lazy purge is used only when muzzy decay is enabled for kind, pages are
+// freed by kernel under memory pressure. Mappings not supporting MADV_FREE
+// (hugetlb) are purged immediately.
+bool arena_extent_purge_lazy(extent_hooks_t *extent_hooks, void *addr,
+                             size_t size, size_t offset, size_t length,
+                             unsigned arena_ind)
+{
+    int err = madvise(addr + offset, length, MADV_FREE);
+    if (err) {
+        err = madvise(addr + offset, length, MADV_DONTNEED);
+    }
+    return (err != 0);
+}
+
+bool arena_extent_purge_thp(extent_hooks_t *extent_hooks, void *addr,
+                            size_t size, size_t offset, size_t length,
+                            unsigned arena_ind)
+{
+    // purge only whole huge pages, partial purge would split THP; range without
+    // whole huge page is reported as not purged, so it stays dirty
+    uintptr_t start = ((uintptr_t)addr + offset + (HUGE_PAGE_SIZE - 1)) &
+        ~(uintptr_t)(HUGE_PAGE_SIZE - 1);
+    uintptr_t end =
+        ((uintptr_t)addr + offset + length) & ~(uintptr_t)(HUGE_PAGE_SIZE - 1);
+    if (start >= end) {
+        return true;
+    }
+    int err = madvise((void *)start, end - start, MADV_DONTNEED);
+    return (err != 0);
+}
+
+// Purges whole huge pages of kind within range, hugetlb pages cannot be
+// purged partially. Returns true if no page was purged.
+static bool arena_extent_purge_huge_pages(void *addr, size_t offset,
+                                          size_t length, unsigned arena_ind,
+                                          bool *partial)
+{
+    size_t huge_size =
+        memkind_hugetlb_get_pagesize(get_kind_by_arena(arena_ind));
+    uintptr_t first = (uintptr_t)addr + offset;
+    uintptr_t last = first + length;
+    uintptr_t start = (first + huge_size - 1) & ~(uintptr_t)(huge_size - 1);
+    uintptr_t end = last & ~(uintptr_t)(huge_size - 1);
+
+    *partial = start != first || end != last;
+    if (start >= end) {
+        return true;
+    }
+    int err = madvise((void *)start, end - start, MADV_DONTNEED);
+    return (err != 0);
+}
+
+bool arena_extent_purge_lazy_hugetlb_1gb(extent_hooks_t *extent_hooks,
+                                         void *addr, size_t size,
+                                         size_t offset, size_t length,
+                                         unsigned arena_ind)
+{
+    bool partial;
+    return arena_extent_purge_huge_pages(addr, offset, length, arena_ind,
+                                         &partial);
+}
+
+// Forced purge succeeds only when whole range is purged, as jemalloc assumes
+// purged range is zeroed.
+bool arena_extent_purge_hugetlb_1gb(extent_hooks_t *extent_hooks, void *addr,
+                                    size_t size, size_t offset, size_t length,
+                                    unsigned arena_ind)
+{
+    bool partial;
+    bool err = arena_extent_purge_huge_pages(addr, offset, length, arena_ind,
+                                             &partial);
+    return err || partial;
+}
+
 bool arena_extent_split(extent_hooks_t *extent_hooks, void *addr, size_t size,
                         size_t size_a, size_t size_b, bool committed,
                         unsigned arena_ind)
@@ -287,7 +1107,8 @@ static extent_hooks_t arena_extent_hooks = {
     .dalloc = arena_extent_dalloc,
     .commit = arena_extent_commit,
     .decommit = arena_extent_decommit,
-    .purge_lazy = arena_extent_purge,
+    .purge_lazy = arena_extent_purge_lazy,
+    .purge_forced = arena_extent_purge,
     .split = arena_extent_split,
     .merge = arena_extent_merge
 };
@@ -307,7 +1128,8 @@ static extent_hooks_t arena_extent_hooks_hugetlb = {
     .dalloc = arena_extent_dalloc,
     .commit = arena_extent_commit,
     .decommit = arena_extent_decommit,
-    .purge_lazy = arena_extent_purge,
+    .purge_lazy = arena_extent_purge_lazy,
+    .purge_forced = arena_extent_purge,
     .split = arena_extent_split,
     .merge = arena_extent_merge
 };
@@ -321,6 +1143,47 @@ static extent_hooks_t arena_extent_hooks_hugetlb_hog_memory = {
     .split = arena_extent_split,
     .merge = arena_extent_merge
 };
+
+static extent_hooks_t arena_extent_hooks_hugetlb_1gb = {
+    .alloc = arena_extent_alloc_hugetlb_1gb,
+    .dalloc = arena_extent_dalloc,
+    .commit = arena_extent_commit,
+    .decommit = arena_extent_decommit,
+    .purge_lazy = arena_extent_purge_lazy_hugetlb_1gb,
+    .purge_forced = arena_extent_purge_hugetlb_1gb,
+    .split = arena_extent_split,
+    .merge = arena_extent_merge
+};
+
+static extent_hooks_t arena_extent_hooks_hugetlb_1gb_hog_memory = {
+    .alloc = arena_extent_alloc_hugetlb_1gb,
+    .dalloc = arena_extent_dalloc,
+    .commit = arena_extent_commit,
+    .decommit = arena_extent_decommit,
+    .purge_lazy = arena_extent_purge_hog_memory,
+    .split = arena_extent_split,
+    .merge = arena_extent_merge
+};
+
+static extent_hooks_t arena_extent_hooks_thp = {
+    .alloc = arena_extent_alloc_thp,
+    .dalloc = arena_extent_dalloc,
+    .commit = arena_extent_commit,
+    .decommit = arena_extent_decommit,
+    .purge_lazy = arena_extent_purge_thp,
+    .split = arena_extent_split,
+    .merge = arena_extent_merge
+};
+
+static extent_hooks_t arena_extent_hooks_thp_hog_memory = {
+    .alloc = arena_extent_alloc_thp,
+    .dalloc = arena_extent_dalloc,
+    .commit = arena_extent_commit,
+    .decommit = arena_extent_decommit,
+    .purge_lazy = arena_extent_purge_hog_memory,
+    .split = arena_extent_split,
+    .merge = arena_extent_merge
+};
 // clang-format on
 
 extent_hooks_t *get_extent_hooks_by_kind(struct memkind *kind)
@@ -333,12 +1196,131 @@ extent_hooks_t *get_extent_hooks_by_kind(struct memkind *kind)
         }
         return &arena_extent_hooks_hugetlb;
     }
+    if (memkind_hugetlb_get_pagesize(kind) > HUGE_PAGE_SIZE) {
+        if (memkind_get_hog_memory()) {
+            return &arena_extent_hooks_hugetlb_1gb_hog_memory;
+        }
+        return &arena_extent_hooks_hugetlb_1gb;
+    }
+    if (kind->ops->madvise == memkind_thp_madvise) {
+        if (memkind_get_hog_memory()) {
+            return &arena_extent_hooks_thp_hog_memory;
+        }
+        return &arena_extent_hooks_thp;
+    }
     if (memkind_get_hog_memory()) {
         return &arena_extent_hooks_hog_memory;
     }
     return &arena_extent_hooks;
 }
 
+// Creates jemalloc arena with kind extent hooks, has to be called with
+// arena_registry_write_lock held.
+static int arena_create(struct memkind *kind, unsigned *arena_index)
+{
+    size_t unsigned_size = sizeof(unsigned int);
+    int err;
+
+    if (!kind->arena_metadata_use_hooks) {
+        arena_config_t config;
+        config.metadata_use_hooks = kind->arena_metadata_use_hooks;
+        config.extent_hooks = kind->arena_hooks;
+
+        err = jemk_mallctl("experimental.arenas_create_ext",
+                           (void *)arena_index, &unsigned_size, &config,
+                           sizeof(config));
+        if (err) {
+            log_err("Could not create arena.");
+            return MEMKIND_ERROR_ARENAS_CREATE;
+        }
+    } else {
+        err = jemk_mallctl("arenas.create", (void *)arena_index,
+                           &unsigned_size, NULL, 0);
+        if (err) {
+            log_err("Could not create arena.");
+            return MEMKIND_ERROR_ARENAS_CREATE;
+        }
+        // setup extent_hooks for newly created arena
+        char cmd[64];
+        snprintf(cmd, sizeof(cmd), "arena.%u.extent_hooks", *arena_index);
+        err = jemk_mallctl(cmd, NULL, NULL, (void *)&kind->arena_hooks,
+                           sizeof(extent_hooks_t *));
+        if (err) {
+            return err;
+        }
+    }
+    arena_registry_g[*arena_index] = kind;
+    return 0;
+}
+
+// Arena of first slot is created with kind, arenas of other slots on their
+// first use, so kinds which are used by few threads stay cheap. Arena takes
+// over decay settings of first slot arena, which could be changed since.
+// When arena cannot be created, slot stays unset, so it is retried next time.
+static int arena_create_slot(struct memkind *kind, unsigned slot,
+                             unsigned *arena)
+{
+    const char *decay_names[] = {"dirty_decay_ms", "muzzy_decay_ms"};
+    unsigned arena_index;
+    unsigned i;
+    int err = MEMKIND_SUCCESS;
+
+    if (pthread_mutex_lock(&arena_registry_write_lock) != 0)
+        assert(0 && "failed to acquire mutex");
+    arena_index = kind->arena_map[slot];
+    if (arena_index) {
+        goto exit;
+    }
+    err = arena_create(kind, &arena_index);
+    if (err) {
+        goto exit;
+    }
+    for (i = 0; i < sizeof(decay_names) / sizeof(decay_names[0]); ++i) {
+        char cmd[64];
+        ssize_t decay;
+        size_t decay_size = sizeof(decay);
+
+        snprintf(cmd, sizeof(cmd), "arena.%u.%s", kind->arena_zero,
+                 decay_names[i]);
+        if (!jemk_mallctl(cmd, &decay, &decay_size, NULL, 0)) {
+            snprintf(cmd, sizeof(cmd), "arena.%u.%s", arena_index,
+                     decay_names[i]);
+            jemk_mallctl(cmd, NULL, NULL, &decay, sizeof(decay));
+        }
+    }
+
+    __atomic_store_n(&kind->arena_map[slot], arena_index, __ATOMIC_RELEASE);
+
+exit:
+    if (pthread_mutex_unlock(&arena_registry_write_lock) != 0)
+        assert(0 && "failed to release mutex");
+    *arena = arena_index;
+    return err;
+}
+
+static inline int arena_by_slot(struct memkind *kind, unsigned slot,
+                                unsigned *arena)
+{
+    *arena = __atomic_load_n(&kind->arena_map[slot], __ATOMIC_ACQUIRE);
+    if (MEMKIND_UNLIKELY(!*arena)) {
+        return arena_create_slot(kind, slot, arena);
+    }
+    return MEMKIND_SUCCESS;
+}
+
+// Returns false if slot has no arena yet, kinds without arena map (default
+// kind) use consecutive arenas.
+static bool arena_of_slot(struct memkind *kind, unsigned slot,
+                          unsigned *arena_index)
+{
+    if (!kind->arena_map) {
+        *arena_index = kind->arena_zero + slot;
+        return true;
+    }
+    *arena_index = __atomic_load_n(&kind->arena_map[slot], __ATOMIC_ACQUIRE);
+    return *arena_index != 0;
+}
+
 MEMKIND_EXPORT int memkind_arena_create_map(struct memkind *kind,
                                             extent_hooks_t *hooks,
                                             bool metadata_use_hooks)
@@ -354,6 +1336,13 @@ MEMKIND_EXPORT int memkind_arena_create_map(struct memkind *kind,
     if (err) {
         return err;
     }
+    kind->arena_map = jemk_calloc(kind->arena_map_len, sizeof(unsigned int));
+    if (!kind->arena_map) {
+        log_err("calloc() failed.");
+        return MEMKIND_ERROR_MALLOC;
+    }
+    kind->arena_hooks = hooks;
+    kind->arena_metadata_use_hooks = metadata_use_hooks;
 #ifdef MEMKIND_TLS
     if (kind->ops->get_arena == memkind_thread_get_arena) {
         pthread_key_create(&(kind->arena_key), free);
@@ -362,54 +1351,22 @@ MEMKIND_EXPORT int memkind_arena_create_map(struct memkind *kind,
 
     if (pthread_mutex_lock(&arena_registry_write_lock) != 0)
         assert(0 && "failed to acquire mutex");
-    unsigned i;
-    size_t unsigned_size = sizeof(unsigned int);
-    kind->arena_zero = UINT_MAX;
-    for (i = 0; i < kind->arena_map_len; i++) {
-        unsigned arena_index;
-        // create new arena with consecutive index
-
-        if (!metadata_use_hooks) {
-            arena_config_t config;
-            config.metadata_use_hooks = metadata_use_hooks;
-            config.extent_hooks = hooks;
-
-            err = jemk_mallctl("experimental.arenas_create_ext",
-                               (void *)&arena_index, &unsigned_size, &config,
-                               sizeof(config));
-            if (err) {
-                log_err("Could not create arena.");
-                err = MEMKIND_ERROR_ARENAS_CREATE;
-                goto exit;
-            }
-        } else {
-            err = jemk_mallctl("arenas.create", (void *)&arena_index,
-                               &unsigned_size, NULL, 0);
-            if (err) {
-                log_err("Could not create arena.");
-                err = MEMKIND_ERROR_ARENAS_CREATE;
-                goto exit;
-            }
-            // setup extent_hooks for newly created arena
-            char cmd[64];
-            snprintf(cmd, sizeof(cmd), "arena.%u.extent_hooks", arena_index);
-            err = jemk_mallctl(cmd, NULL, NULL, (void *)&hooks,
-                               sizeof(extent_hooks_t *));
-            if (err) {
-                goto exit;
-            }
-        }
-        // store arena with lowest index (arenas could be created in
-        // descending/ascending order)
-        if (kind->arena_zero > arena_index) {
-            kind->arena_zero = arena_index;
-        }
-        arena_registry_g[arena_index] = kind;
+    err = arena_create(kind, &kind->arena_zero);
+    if (!err) {
+        kind->arena_map[0] = kind->arena_zero;
     }
-
-exit:
     if (pthread_mutex_unlock(&arena_registry_write_lock) != 0)
         assert(0 && "failed to release mutex");
+
+    if (err) {
+#ifdef MEMKIND_TLS
+        if (kind->ops->get_arena == memkind_thread_get_arena) {
+            pthread_key_delete(kind->arena_key);
+        }
+#endif
+        jemk_free(kind->arena_map);
+        kind->arena_map = NULL;
+    }
     return err;
 }
 
@@ -425,20 +1382,67 @@ MEMKIND_EXPORT int memkind_arena_create(struct memkind *kind,
     return err;
 }
 
+// Releases not used parts of reservations of destroyed kind, so kind which
+// reuses its partition starts with empty slots.
+static void va_reserve_destroy(struct memkind *kind)
+{
+    struct va_reserve *reserve =
+        __atomic_load_n(&va_reserve_g[kind->partition], __ATOMIC_ACQUIRE);
+    struct va_reservation key;
+    size_t huge_size = 0;
+    unsigned i;
+
+    if (!reserve) {
+        return;
+    }
+    if (va_reserve_key(kind, &key, &huge_size)) {
+        huge_size = 0;
+    }
+
+    pthread_mutex_lock(&reserve->lock);
+    for (i = 0; i < reserve->num; ++i) {
+        struct va_reservation *res = &reserve->slots[i];
+        va_reserve_wait_idle(reserve, res);
+        uintptr_t tail = res->cur;
+        if (huge_size) {
+            tail = (tail + huge_size - 1) & ~(uintptr_t)(huge_size - 1);
+        }
+        if (res->end > tail) {
+            munmap((void *)tail, res->end - tail);
+        }
+        res->cur = res->committed = res->populated = res->end = 0;
+        res->gen++;
+    }
+    __atomic_store_n(&reserve->num, 0, __ATOMIC_RELEASE);
+    __atomic_store_n(&reserve->size, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&reserve->prefault_size, 0, __ATOMIC_RELAXED);
+    reserve->prefault_low = 0;
+    pthread_mutex_unlock(&reserve->lock);
+}
+
 MEMKIND_EXPORT int memkind_arena_destroy(struct memkind *kind)
 {
-    if (kind->arena_map_len) {
+    defrag_trigger_remove(kind);
+    if (kind->use_tcache) {
+        dynamic_tcache_destroy(kind->partition);
+    }
+    if (kind->arena_map) {
         char cmd[128];
-        unsigned i;
+        unsigned i, arena_index;
 
         if (pthread_mutex_lock(&arena_registry_write_lock) != 0)
             assert(0 && "failed to acquire mutex");
 
         for (i = 0; i < kind->arena_map_len; ++i) {
-            snprintf(cmd, 128, "arena.%u.destroy", kind->arena_zero + i);
+            if (!arena_of_slot(kind, i, &arena_index)) {
+                continue;
+            }
+            snprintf(cmd, 128, "arena.%u.destroy", arena_index);
             jemk_mallctl(cmd, NULL, NULL, NULL, 0);
-            arena_registry_g[kind->arena_zero + i] = NULL;
+            arena_registry_g[arena_index] = NULL;
         }
+        jemk_free(kind->arena_map);
+        kind->arena_map = NULL;
 
         if (pthread_mutex_unlock(&arena_registry_write_lock) != 0)
             assert(0 && "failed to release mutex");
@@ -449,28 +1453,97 @@ MEMKIND_EXPORT int memkind_arena_destroy(struct memkind *kind)
         }
 #endif
     }
+    va_reserve_destroy(kind);
 
     return 0;
 }
 
-int memkind_arena_finalize(struct memkind *kind)
+int memkind_arena_finalize(struct memkind *kind)
+{
+    return memkind_arena_destroy(kind);
+}
+
+// max allocation size to be cached by tcache mechanism
+#define TCACHE_MAX (1 << (JEMALLOC_TCACHE_CLASS))
+
+static void tcache_finalize(void *args)
+{
+    int i;
+    struct tcache_slot *tcache_map = args;
+    for (i = 0; i < MEMKIND_MAX_KIND; i++) {
+        if (tcache_map[i].tcache == 0) {
+            continue;
+        }
+        if (i < MEMKIND_NUM_STATIC_KINDS) {
+            jemk_mallctl("tcache.destroy", NULL, NULL,
+                         (void *)&tcache_map[i].tcache, sizeof(unsigned));
+            continue;
+        }
+        if (pthread_mutex_lock(&dynamic_tcache_lock) != 0)
+            assert(0 && "failed to acquire mutex");
+        // tcache of destroyed kind was already destroyed with the kind
+        if (tcache_map[i].epoch == tcache_epoch_g[i]) {
+            struct tcache_list *list = &dynamic_tcache_g[i];
+            unsigned j;
+            for (j = 0; j < list->num; ++j) {
+                if (list->tcache[j] == tcache_map[i].tcache) {
+                    list->tcache[j] = list->tcache[--list->num];
+                    break;
+                }
+            }
+            jemk_mallctl("tcache.destroy", NULL, NULL,
+                         (void *)&tcache_map[i].tcache, sizeof(unsigned));
+        }
+        if (pthread_mutex_unlock(&dynamic_tcache_lock) != 0)
+            assert(0 && "failed to release mutex");
+    }
+}
+
+// Destroys thread caches of dynamic kind of all threads and invalidates
+// slots of the partition kept by threads
+static void dynamic_tcache_destroy(unsigned partition)
 {
-    return memkind_arena_destroy(kind);
-}
+    struct tcache_list *list = &dynamic_tcache_g[partition];
+    unsigned i;
 
-// max allocation size to be cached by tcache mechanism
-#define TCACHE_MAX (1 << (JEMALLOC_TCACHE_CLASS))
+    if (pthread_mutex_lock(&dynamic_tcache_lock) != 0)
+        assert(0 && "failed to acquire mutex");
+    for (i = 0; i < list->num; ++i) {
+        jemk_mallctl("tcache.destroy", NULL, NULL, (void *)&list->tcache[i],
+                     sizeof(unsigned));
+    }
+    jemk_free(list->tcache);
+    memset(list, 0, sizeof(*list));
+    __atomic_add_fetch(&tcache_epoch_g[partition], 1, __ATOMIC_RELEASE);
+    if (pthread_mutex_unlock(&dynamic_tcache_lock) != 0)
+        assert(0 && "failed to release mutex");
+}
 
-static void tcache_finalize(void *args)
+static int dynamic_tcache_register(unsigned partition,
+                                   struct tcache_slot *slot)
 {
-    int i;
-    unsigned *tcache_map = args;
-    for (i = 0; i < MEMKIND_NUM_STATIC_KINDS; i++) {
-        if (tcache_map[i] != 0) {
-            jemk_mallctl("tcache.destroy", NULL, NULL, (void *)&tcache_map[i],
-                         sizeof(unsigned));
+    struct tcache_list *list = &dynamic_tcache_g[partition];
+    int err = 0;
+
+    if (pthread_mutex_lock(&dynamic_tcache_lock) != 0)
+        assert(0 && "failed to acquire mutex");
+    if (list->num == list->capacity) {
+        unsigned capacity = list->capacity ? 2 * list->capacity : 16;
+        unsigned *tcache =
+            jemk_realloc(list->tcache, capacity * sizeof(unsigned));
+        if (!tcache) {
+            err = MEMKIND_ERROR_MALLOC;
+            goto exit;
         }
+        list->tcache = tcache;
+        list->capacity = capacity;
     }
+    list->tcache[list->num++] = slot->tcache;
+    slot->epoch = tcache_epoch_g[partition];
+exit:
+    if (pthread_mutex_unlock(&dynamic_tcache_lock) != 0)
+        assert(0 && "failed to release mutex");
+    return err;
 }
 
 MEMKIND_EXPORT struct memkind *memkind_arena_detect_kind(void *ptr)
@@ -486,34 +1559,47 @@ MEMKIND_EXPORT struct memkind *memkind_arena_detect_kind(void *ptr)
     return (kind) ? kind : MEMKIND_DEFAULT;
 }
 
-static inline int get_tcache_flag(unsigned partition, size_t size)
+static inline int get_tcache_flag(struct memkind *kind, size_t size)
 {
+    unsigned partition = kind->partition;
 
     // do not cache allocation larger than tcache_max nor those coming from
-    // non-static kinds
-    if (size > TCACHE_MAX || partition >= MEMKIND_NUM_STATIC_KINDS) {
+    // non-static kinds, unless the kind enabled it
+    if (size > TCACHE_MAX ||
+        (partition >= MEMKIND_NUM_STATIC_KINDS && !kind->use_tcache)) {
         return MALLOCX_TCACHE_NONE;
     }
 
-    unsigned *tcache_map = pthread_getspecific(tcache_key);
+    struct tcache_slot *tcache_map = pthread_getspecific(tcache_key);
     if (tcache_map == NULL) {
-        tcache_map = jemk_calloc(MEMKIND_NUM_STATIC_KINDS, sizeof(unsigned));
+        tcache_map = jemk_calloc(MEMKIND_MAX_KIND, sizeof(struct tcache_slot));
         if (tcache_map == NULL) {
             return MALLOCX_TCACHE_NONE;
         }
         pthread_setspecific(tcache_key, (void *)tcache_map);
     }
 
-    if (MEMKIND_UNLIKELY(tcache_map[partition] == 0)) {
+    struct tcache_slot *slot = &tcache_map[partition];
+    unsigned epoch =
+        __atomic_load_n(&tcache_epoch_g[partition], __ATOMIC_ACQUIRE);
+    if (MEMKIND_UNLIKELY(slot->tcache == 0 || slot->epoch != epoch)) {
         size_t unsigned_size = sizeof(unsigned);
-        int err = jemk_mallctl("tcache.create", (void *)&tcache_map[partition],
+        int err = jemk_mallctl("tcache.create", (void *)&slot->tcache,
                                &unsigned_size, NULL, 0);
         if (err) {
             log_err("Could not acquire tcache, err=%d", err);
+            slot->tcache = 0;
+            return MALLOCX_TCACHE_NONE;
+        }
+        if (partition >= MEMKIND_NUM_STATIC_KINDS &&
+            dynamic_tcache_register(partition, slot)) {
+            jemk_mallctl("tcache.destroy", NULL, NULL, (void *)&slot->tcache,
+                         sizeof(unsigned));
+            slot->tcache = 0;
             return MALLOCX_TCACHE_NONE;
         }
     }
-    return MALLOCX_TCACHE(tcache_map[partition]);
+    return MALLOCX_TCACHE(slot->tcache);
 }
 
 MEMKIND_EXPORT void *memkind_arena_malloc(struct memkind *kind, size_t size)
@@ -524,7 +1610,7 @@ MEMKIND_EXPORT void *memkind_arena_malloc(struct memkind *kind, size_t size)
     int err = kind->ops->get_arena(kind, &arena, size);
     if (MEMKIND_LIKELY(!err)) {
         return jemk_mallocx_check(
-            size, MALLOCX_ARENA(arena) | get_tcache_flag(kind->partition, size),
+            size, MALLOCX_ARENA(arena) | get_tcache_flag(kind, size),
             kind->allow_zero_allocs);
     }
     return NULL;
@@ -552,7 +1638,7 @@ MEMKIND_EXPORT void memkind_arena_free(struct memkind *kind, void *ptr)
         jemk_free(ptr);
     } else if (ptr != NULL) {
         pthread_once(&kind->init_once, kind->ops->init_once);
-        jemk_dallocx(ptr, get_tcache_flag(kind->partition, 0));
+        jemk_dallocx(ptr, get_tcache_flag(kind, 0));
     }
 }
 
@@ -561,6 +1647,27 @@ MEMKIND_EXPORT void memkind_arena_free_with_kind_detect(void *ptr)
     memkind_arena_free(memkind_arena_detect_kind(ptr), ptr);
 }
 
+// Moves allocation to slow tier kind with non-temporal stores, instead of
+// memcpy() done by rallocx(), which pollutes CPU caches with moved data
+static void *arena_realloc_nt(struct memkind *kind, void *ptr, size_t size,
+                              unsigned arena)
+{
+    int flags = MALLOCX_ARENA(arena) | get_tcache_flag(kind, size);
+    size_t old_size = jemk_malloc_usable_size(ptr);
+
+    if (jemk_xallocx(ptr, size, 0, flags) >= size) {
+        return ptr;
+    }
+    void *ptr_new = jemk_mallocx(size, flags);
+    if (MEMKIND_UNLIKELY(!ptr_new)) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    memkind_memcpy_nt(ptr_new, ptr, MIN(old_size, size));
+    jemk_dallocx(ptr, MALLOCX_TCACHE_NONE);
+    return ptr_new;
+}
+
 MEMKIND_EXPORT void *memkind_arena_realloc(struct memkind *kind, void *ptr,
                                            size_t size)
 {
@@ -568,7 +1675,7 @@ MEMKIND_EXPORT void *memkind_arena_realloc(struct memkind *kind, void *ptr,
     unsigned arena;
 
     if (size == 0 && ptr != NULL) {
-        jemk_dallocx(ptr, get_tcache_flag(kind->partition, 0));
+        jemk_dallocx(ptr, get_tcache_flag(kind, 0));
     } else {
         int err = kind->ops->get_arena(kind, &arena, size);
         if (MEMKIND_LIKELY(!err)) {
@@ -576,14 +1683,16 @@ MEMKIND_EXPORT void *memkind_arena_realloc(struct memkind *kind, void *ptr,
                 return jemk_mallocx_check(
                     size,
                     MALLOCX_ARENA(arena) |
-                        get_tcache_flag(kind->partition, size),
+                        get_tcache_flag(kind, size),
                     kind->allow_zero_allocs);
             } else if (!kind->allow_zero_allocs && MEMKIND_UNLIKELY(!size)) {
                 return NULL;
+            } else if (memkind_memcpy_nt_enabled(kind, size)) {
+                return arena_realloc_nt(kind, ptr, size, arena);
             } else {
                 ptr = jemk_rallocx(ptr, size,
                                    MALLOCX_ARENA(arena) |
-                                       get_tcache_flag(kind->partition, size));
+                                       get_tcache_flag(kind, size));
                 if (MEMKIND_UNLIKELY(!ptr))
                     errno = ENOMEM;
                 return ptr;
@@ -593,10 +1702,81 @@ MEMKIND_EXPORT void *memkind_arena_realloc(struct memkind *kind, void *ptr,
     return NULL;
 }
 
+// fmt may contain up to STAT_MIB_MAX_INDEX "%u" components
+static int stat_mib_init(const char *fmt, struct stat_mib *m)
+{
+    char cmd[128];
+    const char *c;
+    size_t pos = 0;
+    unsigned idx = 0;
+
+    memset(m->index_pos, 0, sizeof(m->index_pos));
+    for (c = fmt; *c; ++c) {
+        if (*c == '.') {
+            ++pos;
+        } else if (c[0] == '%' && c[1] == 'u' && idx < STAT_MIB_MAX_INDEX) {
+            m->index_pos[idx++] = pos;
+        }
+    }
+    snprintf(cmd, sizeof(cmd), fmt, 0, 0);
+    m->len = STAT_MIB_MAX_LEN;
+    m->err = jemk_mallctlnametomib(cmd, m->mib, &m->len);
+    if (m->err) {
+        log_err("Error on translating statistic %s to MIB.", cmd);
+    }
+    return m->err;
+}
+
+// Failed translation of a name makes only statistics using it unavailable.
+static void stats_mib_init(void)
+{
+    unsigned i, j;
+    char fmt[128];
+
+    stat_mib_init("epoch", &epoch_mib);
+    stat_mib_init("arena.%u.initialized", &arena_initialized_mib);
+    for (i = 0; i < MEMKIND_STAT_TYPE_MAX_VALUE; ++i) {
+        stat_mib_init(global_stats[i], &global_stats_mib[i]);
+        for (j = 0; j < arena_stats[i].stats_no; ++j) {
+            stat_mib_init(arena_stats[i].stats[j], &arena_stats_mib[i][j]);
+        }
+    }
+    for (i = 0; i < DETAIL_STAT_MAX_VALUE; ++i) {
+        stat_mib_init(detail_stats[i], &detail_stats_mib[i]);
+    }
+    for (i = 0; i < ARENA_MUTEX_NUM; ++i) {
+        for (j = 0; j < MUTEX_STAT_MAX_VALUE; ++j) {
+            snprintf(fmt, sizeof(fmt), "stats.arenas.%%u.mutexes.%s.%s",
+                     arena_mutexes[i], mutex_stats[j]);
+            stat_mib_init(fmt, &mutex_stats_mib[i][j]);
+        }
+    }
+}
+
+// i and j replace first and second index of mib
+static int stat_mib_ctl(const struct stat_mib *m, unsigned i, unsigned j,
+                        void *oldp, size_t *oldlenp, void *newp, size_t newlen)
+{
+    size_t mib[STAT_MIB_MAX_LEN];
+
+    pthread_once(&stats_mib_once, stats_mib_init);
+    if (MEMKIND_UNLIKELY(m->err)) {
+        return MEMKIND_ERROR_INVALID;
+    }
+    memcpy(mib, m->mib, m->len * sizeof(size_t));
+    if (m->index_pos[0]) {
+        mib[m->index_pos[0]] = i;
+    }
+    if (m->index_pos[1]) {
+        mib[m->index_pos[1]] = j;
+    }
+    return jemk_mallctlbymib(mib, m->len, oldp, oldlenp, newp, newlen);
+}
+
 int memkind_arena_update_cached_stats(void)
 {
     uint64_t epoch = 1;
-    return jemk_mallctl("epoch", NULL, NULL, &epoch, sizeof(epoch));
+    return stat_mib_ctl(&epoch_mib, 0, 0, NULL, NULL, &epoch, sizeof(epoch));
 }
 
 MEMKIND_EXPORT void *memkind_arena_realloc_with_kind_detect(void *ptr,
@@ -632,22 +1812,98 @@ memkind_arena_update_memory_usage_policy(struct memkind *kind,
             return MEMKIND_ERROR_INVALID;
     }
 
+    // serialized with creation of arenas, which copy decay of first arena
+    if (pthread_mutex_lock(&arena_registry_write_lock) != 0)
+        assert(0 && "failed to acquire mutex");
     for (i = 0; i < kind->arena_map_len; ++i) {
         char cmd[64];
+        unsigned arena_index;
 
-        snprintf(cmd, sizeof(cmd), "arena.%u.dirty_decay_ms",
-                 kind->arena_zero + i);
+        if (!arena_of_slot(kind, i, &arena_index)) {
+            continue;
+        }
+        snprintf(cmd, sizeof(cmd), "arena.%u.dirty_decay_ms", arena_index);
         err = jemk_mallctl(cmd, NULL, NULL, (void *)&dirty_decay_val,
                            sizeof(ssize_t));
         if (err) {
             log_err("Incorrect dirty_decay_ms value %zu", dirty_decay_val);
-            return MEMKIND_ERROR_INVALID;
+            err = MEMKIND_ERROR_INVALID;
+            break;
         }
     }
+    if (pthread_mutex_unlock(&arena_registry_write_lock) != 0)
+        assert(0 && "failed to release mutex");
+
+    return err;
+}
+
+int memkind_arena_set_decay(struct memkind *kind, ssize_t dirty_decay_ms,
+                            ssize_t muzzy_decay_ms)
+{
+    const char *decay_names[] = {"dirty_decay_ms", "muzzy_decay_ms"};
+    ssize_t decay_vals[] = {dirty_decay_ms, muzzy_decay_ms};
+    int err = MEMKIND_SUCCESS;
+    unsigned i, j, arena_index;
+
+    if (kind->ops->malloc != memkind_arena_malloc) {
+        return MEMKIND_ERROR_INVALID;
+    }
+    if (kind->ops->init_once) {
+        pthread_once(&kind->init_once, kind->ops->init_once);
+    }
+
+    // serialized with creation of arenas, which copy decay of first arena
+    if (pthread_mutex_lock(&arena_registry_write_lock) != 0)
+        assert(0 && "failed to acquire mutex");
+    for (i = 0; i < kind->arena_map_len && !err; ++i) {
+        if (!arena_of_slot(kind, i, &arena_index)) {
+            continue;
+        }
+        for (j = 0; j < sizeof(decay_vals) / sizeof(decay_vals[0]); ++j) {
+            char cmd[64];
 
+            snprintf(cmd, sizeof(cmd), "arena.%u.%s", arena_index,
+                     decay_names[j]);
+            if (jemk_mallctl(cmd, NULL, NULL, (void *)&decay_vals[j],
+                             sizeof(ssize_t))) {
+                log_err("Incorrect %s value %zd", decay_names[j],
+                        decay_vals[j]);
+                err = MEMKIND_ERROR_INVALID;
+                break;
+            }
+        }
+    }
+    if (pthread_mutex_unlock(&arena_registry_write_lock) != 0)
+        assert(0 && "failed to release mutex");
     return err;
 }
 
+int memkind_arena_purge(struct memkind *kind)
+{
+    unsigned i, arena_index;
+
+    if (kind->ops->malloc != memkind_arena_malloc) {
+        return MEMKIND_ERROR_INVALID;
+    }
+    if (kind->ops->init_once) {
+        pthread_once(&kind->init_once, kind->ops->init_once);
+    }
+
+    for (i = 0; i < kind->arena_map_len; ++i) {
+        char cmd[64];
+
+        if (!arena_of_slot(kind, i, &arena_index)) {
+            continue;
+        }
+        snprintf(cmd, sizeof(cmd), "arena.%u.purge", arena_index);
+        if (jemk_mallctl(cmd, NULL, NULL, NULL, 0)) {
+            log_err("Cannot purge arena %u.", arena_index);
+            return MEMKIND_ERROR_OPERATION_FAILED;
+        }
+    }
+    return MEMKIND_SUCCESS;
+}
+
 MEMKIND_EXPORT void *memkind_arena_calloc(struct memkind *kind, size_t num,
                                           size_t size)
 {
@@ -658,7 +1914,7 @@ MEMKIND_EXPORT void *memkind_arena_calloc(struct memkind *kind, size_t num,
     if (MEMKIND_LIKELY(!err)) {
         return jemk_mallocx_check(num * size,
                                   MALLOCX_ARENA(arena) | MALLOCX_ZERO |
-                                      get_tcache_flag(kind->partition, size),
+                                      get_tcache_flag(kind, size),
                                   kind->allow_zero_allocs);
     }
     return NULL;
@@ -688,7 +1944,7 @@ MEMKIND_EXPORT int memkind_arena_posix_memalign(struct memkind *kind,
         *memptr =
             jemk_mallocx_check(size,
                                MALLOCX_ALIGN(alignment) | MALLOCX_ARENA(arena) |
-                                   get_tcache_flag(kind->partition, size),
+                                   get_tcache_flag(kind, size),
                                kind->allow_zero_allocs);
         errno = errno_before;
         err = *memptr ? 0 : ENOMEM;
@@ -712,12 +1968,33 @@ static uint64_t hash64(uint64_t x)
     return x ^ (x >> 31);
 }
 
+// slot of kind with MEMKIND_ARENA_SELECT_CPU or MEMKIND_ARENA_SELECT_NODE
+// strategy
+static unsigned arena_select_slot(struct memkind *kind)
+{
+    int cpu = sched_getcpu();
+    if (MEMKIND_UNLIKELY(cpu < 0)) {
+        return 0;
+    }
+    if (kind->arena_select == MEMKIND_ARENA_SELECT_NODE) {
+        cpu = cpu < arena_cpu_node_len_g ? arena_cpu_node_g[cpu] : 0;
+    }
+    return (unsigned)cpu & kind->arena_map_mask;
+}
+
 #ifdef MEMKIND_TLS
 MEMKIND_EXPORT int memkind_thread_get_arena(struct memkind *kind,
                                             unsigned int *arena, size_t size)
 {
     int err = 0;
     unsigned int *arena_tsd;
+
+    if (kind->arena_select == MEMKIND_ARENA_SELECT_BIJECTIVE) {
+        return memkind_bijective_get_arena(kind, arena, size);
+    }
+    if (kind->arena_select != MEMKIND_ARENA_SELECT_THREAD) {
+        return arena_by_slot(kind, arena_select_slot(kind), arena);
+    }
     arena_tsd = pthread_getspecific(kind->arena_key);
 
     if (MEMKIND_UNLIKELY(arena_tsd == NULL)) {
@@ -733,8 +2010,11 @@ MEMKIND_EXPORT int memkind_thread_get_arena(struct memkind *kind,
                 : 0;
         }
     }
-    *arena = kind->arena_zero + *arena_tsd;
-    return err;
+    if (err) {
+        *arena = kind->arena_zero;
+        return err;
+    }
+    return arena_by_slot(kind, *arena_tsd, arena);
 }
 
 #else
@@ -758,9 +2038,15 @@ MEMKIND_EXPORT int memkind_thread_get_arena(struct memkind *kind,
                                             unsigned int *arena, size_t size)
 {
     unsigned int arena_idx;
+
+    if (kind->arena_select == MEMKIND_ARENA_SELECT_BIJECTIVE) {
+        return memkind_bijective_get_arena(kind, arena, size);
+    }
+    if (kind->arena_select != MEMKIND_ARENA_SELECT_THREAD) {
+        return arena_by_slot(kind, arena_select_slot(kind), arena);
+    }
     arena_idx = hash64(get_fs_base()) & kind->arena_map_mask;
-    *arena = kind->arena_zero + arena_idx;
-    return 0;
+    return arena_by_slot(kind, arena_idx, arena);
 }
 #endif // MEMKIND_TLS
 
@@ -794,16 +2080,18 @@ static int memkind_arena_get_stat(struct memkind *kind, memkind_stat_type stat,
     size_t sz = sizeof(size_t);
     size_t temp_stat;
     int err = MEMKIND_SUCCESS;
-    unsigned i, j;
-    char cmd[128];
+    unsigned i, j, arena_index;
 
     *value = 0;
     for (i = 0; i < kind->arena_map_len; ++i) {
+        if (!arena_of_slot(kind, i, &arena_index)) {
+            continue;
+        }
         if (check_init) {
             bool is_init;
             size_t sz_b_state = sizeof(is_init);
-            snprintf(cmd, 128, "arena.%u.initialized", kind->arena_zero + i);
-            err = jemk_mallctl(cmd, (void *)&is_init, &sz_b_state, NULL, 0);
+            err = stat_mib_ctl(&arena_initialized_mib, arena_index, 0,
+                               (void *)&is_init, &sz_b_state, NULL, 0);
             if (err) {
                 log_err("Error on getting initialized state of arena.");
                 return MEMKIND_ERROR_INVALID;
@@ -814,9 +2102,8 @@ static int memkind_arena_get_stat(struct memkind *kind, memkind_stat_type stat,
         }
 
         for (j = 0; j < arena_stats[stat].stats_no; ++j) {
-            snprintf(cmd, 128, arena_stats[stat].stats[j],
-                     kind->arena_zero + i);
-            err = jemk_mallctl(cmd, &temp_stat, &sz, NULL, 0);
+            err = stat_mib_ctl(&arena_stats_mib[stat][j], arena_index, 0,
+                               &temp_stat, &sz, NULL, 0);
             if (err) {
                 log_err("Error on getting arena statistic.");
                 return MEMKIND_ERROR_INVALID;
@@ -855,10 +2142,206 @@ int memkind_arena_get_kind_stat(struct memkind *kind, memkind_stat_type stat,
     return memkind_arena_get_stat_with_check_init(kind, stat, false, value);
 }
 
+static int arena_read_stat(detail_stat_t stat, unsigned i, unsigned j,
+                           void *value, size_t size)
+{
+    size_t sz = size;
+    return stat_mib_ctl(&detail_stats_mib[stat], i, j, value, &sz, NULL, 0);
+}
+
+static int arena_read_lock_stats(struct memkind_arena_stats *stats,
+                                 unsigned nbins)
+{
+    uint64_t value[MUTEX_STAT_MAX_VALUE];
+    size_t sz = sizeof(uint64_t);
+    unsigned i, j;
+    int err = 0;
+
+    for (i = 0; i < ARENA_MUTEX_NUM + nbins; ++i) {
+        for (j = 0; j < MUTEX_STAT_MAX_VALUE; ++j) {
+            // mutexes of arena are followed by mutexes of bins
+            if (i < ARENA_MUTEX_NUM) {
+                err |= stat_mib_ctl(&mutex_stats_mib[i][j], stats->arena, 0,
+                                    &value[j], &sz, NULL, 0);
+            } else {
+                err |= arena_read_stat(DETAIL_STAT_BIN_LOCK_OPS + j,
+                                       stats->arena, i - ARENA_MUTEX_NUM,
+                                       &value[j], sizeof(uint64_t));
+            }
+        }
+        stats->lock_ops += value[MUTEX_STAT_NUM_OPS];
+        stats->lock_wait += value[MUTEX_STAT_NUM_WAIT];
+        stats->lock_wait_time += value[MUTEX_STAT_TOTAL_WAIT_TIME];
+    }
+    return err;
+}
+
+static int arena_read_stats(struct memkind_arena_stats *stats,
+                            struct memkind_size_class_stats *classes,
+                            unsigned nbins, unsigned nlextents)
+{
+    unsigned a = stats->arena, j;
+    size_t sz = sizeof(size_t);
+    size_t pages[3], n[3];
+    int err;
+
+    err = stat_mib_ctl(&arena_stats_mib[MEMKIND_STAT_TYPE_ACTIVE][0], a, 0,
+                       &pages[0], &sz, NULL, 0);
+    err |= arena_read_stat(DETAIL_STAT_PDIRTY, a, 0, &pages[1], sizeof(size_t));
+    err |= arena_read_stat(DETAIL_STAT_PMUZZY, a, 0, &pages[2], sizeof(size_t));
+    err |= arena_read_stat(DETAIL_STAT_RETAINED, a, 0, &stats->retained,
+                           sizeof(size_t));
+    if (err) {
+        return err;
+    }
+    stats->active = PAGE_2_BYTES(pages[0]);
+    stats->dirty = PAGE_2_BYTES(pages[1]);
+    stats->muzzy = PAGE_2_BYTES(pages[2]);
+
+    // number of page size classes is not exposed, read until index is invalid
+    for (j = 0; !arena_read_stat(DETAIL_STAT_EXTENT_NDIRTY, a, j, &n[0],
+                                 sizeof(size_t));
+         ++j) {
+        err |= arena_read_stat(DETAIL_STAT_EXTENT_NMUZZY, a, j, &n[1],
+                               sizeof(size_t));
+        err |= arena_read_stat(DETAIL_STAT_EXTENT_NRETAINED, a, j, &n[2],
+                               sizeof(size_t));
+        stats->extents += n[0] + n[1] + n[2];
+    }
+
+    for (j = 0; j < nbins; ++j) {
+        struct memkind_size_class_stats *c = &classes[j];
+        err |= arena_read_stat(DETAIL_STAT_BIN_NMALLOC, a, j, &c->nmalloc,
+                               sizeof(uint64_t));
+        err |= arena_read_stat(DETAIL_STAT_BIN_NDALLOC, a, j, &c->ndalloc,
+                               sizeof(uint64_t));
+        err |= arena_read_stat(DETAIL_STAT_BIN_CURREGS, a, j, &c->curregs,
+                               sizeof(size_t));
+        err |= arena_read_stat(DETAIL_STAT_BIN_CURSLABS, a, j, &c->curslabs,
+                               sizeof(size_t));
+    }
+    for (j = 0; j < nlextents; ++j) {
+        struct memkind_size_class_stats *c = &classes[nbins + j];
+        err |= arena_read_stat(DETAIL_STAT_LEXTENT_NMALLOC, a, j, &c->nmalloc,
+                               sizeof(uint64_t));
+        err |= arena_read_stat(DETAIL_STAT_LEXTENT_NDALLOC, a, j, &c->ndalloc,
+                               sizeof(uint64_t));
+        err |= arena_read_stat(DETAIL_STAT_LEXTENT_CUR, a, j, &c->curregs,
+                               sizeof(size_t));
+    }
+
+    return err | arena_read_lock_stats(stats, nbins);
+}
+
+int memkind_arena_get_arena_stats(
+    struct memkind *kind,
+    void (*cb)(memkind_t kind, const struct memkind_arena_stats *stats,
+               void *arg),
+    void *arg)
+{
+    struct memkind_size_class_stats *classes;
+    unsigned nbins, nlextents, i, j, arena_index;
+    uint32_t nregs;
+    int err;
+
+    err = arena_read_stat(DETAIL_STAT_NBINS, 0, 0, &nbins, sizeof(unsigned));
+    err |= arena_read_stat(DETAIL_STAT_NLEXTENTS, 0, 0, &nlextents,
+                           sizeof(unsigned));
+    if (err) {
+        log_err("Error on getting number of size classes.");
+        return MEMKIND_ERROR_INVALID;
+    }
+    classes = jemk_calloc(nbins + nlextents, sizeof(*classes));
+    if (!classes) {
+        log_err("calloc() failed.");
+        return MEMKIND_ERROR_MALLOC;
+    }
+
+    for (j = 0; j < nbins; ++j) {
+        err |= arena_read_stat(DETAIL_STAT_BIN_SIZE, j, 0, &classes[j].size,
+                               sizeof(size_t));
+        err |= arena_read_stat(DETAIL_STAT_BIN_NREGS, j, 0, &nregs,
+                               sizeof(uint32_t));
+        classes[j].nregs = nregs;
+    }
+    for (j = 0; j < nlextents; ++j) {
+        err |= arena_read_stat(DETAIL_STAT_LEXTENT_SIZE, j, 0,
+                               &classes[nbins + j].size, sizeof(size_t));
+    }
+
+    for (i = 0; !err && i < kind->arena_map_len; ++i) {
+        struct memkind_arena_stats stats = {0};
+        bool is_init;
+        size_t sz = sizeof(is_init);
+
+        if (!arena_of_slot(kind, i, &arena_index)) {
+            continue;
+        }
+        err = stat_mib_ctl(&arena_initialized_mib, arena_index, 0, &is_init,
+                           &sz, NULL, 0);
+        if (err || !is_init) {
+            continue;
+        }
+        stats.arena = arena_index;
+        stats.nclasses = nbins + nlextents;
+        stats.classes = classes;
+        err = arena_read_stats(&stats, classes, nbins, nlextents);
+        if (!err) {
+            cb(kind, &stats, arg);
+        }
+    }
+    jemk_free(classes);
+
+    if (err) {
+        log_err("Error on getting arena statistic.");
+        return MEMKIND_ERROR_INVALID;
+    }
+    return MEMKIND_SUCCESS;
+}
+
+int memkind_arena_get_utilization(struct memkind *kind, double *utilization)
+{
+    unsigned nbins, i, j, arena_index;
+    size_t used = 0, capacity = 0;
+    int err;
+
+    if (kind->ops->malloc != memkind_arena_malloc) {
+        return MEMKIND_ERROR_INVALID;
+    }
+    err = arena_read_stat(DETAIL_STAT_NBINS, 0, 0, &nbins, sizeof(unsigned));
+    for (j = 0; !err && j < nbins; ++j) {
+        size_t size, curregs, curslabs;
+        uint32_t nregs;
+
+        err = arena_read_stat(DETAIL_STAT_BIN_SIZE, j, 0, &size,
+                              sizeof(size_t));
+        err |= arena_read_stat(DETAIL_STAT_BIN_NREGS, j, 0, &nregs,
+                               sizeof(uint32_t));
+        for (i = 0; !err && i < kind->arena_map_len; ++i) {
+            if (!arena_of_slot(kind, i, &arena_index)) {
+                continue;
+            }
+            err = arena_read_stat(DETAIL_STAT_BIN_CURREGS, arena_index, j,
+                                  &curregs, sizeof(size_t));
+            err |= arena_read_stat(DETAIL_STAT_BIN_CURSLABS, arena_index, j,
+                                   &curslabs, sizeof(size_t));
+            used += curregs * size;
+            capacity += curslabs * nregs * size;
+        }
+    }
+    if (err) {
+        log_err("Error on getting arena statistic.");
+        return MEMKIND_ERROR_INVALID;
+    }
+    // kind without slabs is not fragmented
+    *utilization = capacity ? (double)used / capacity : 1.0;
+    return MEMKIND_SUCCESS;
+}
+
 int memkind_arena_get_global_stat(memkind_stat_type stat, size_t *value)
 {
     size_t sz = sizeof(size_t);
-    int err = jemk_mallctl(global_stats[stat], value, &sz, NULL, 0);
+    int err = stat_mib_ctl(&global_stats_mib[stat], 0, 0, value, &sz, NULL, 0);
     if (err) {
         log_err("Error on getting global statistic.");
         return MEMKIND_ERROR_INVALID;
@@ -908,13 +2391,219 @@ void *memkind_arena_defrag_reallocate(struct memkind *kind, void *ptr)
         void *ptr_new = memkind_arena_malloc_no_tcache(kind, size);
         if (MEMKIND_UNLIKELY(!ptr_new))
             return NULL;
-        memcpy(ptr_new, ptr, size);
+        memkind_memcpy(kind, ptr_new, ptr, size);
         jemk_dallocx(ptr, MALLOCX_TCACHE_NONE);
         return ptr_new;
     }
     return NULL;
 }
 
+// Kinds for which defrag callback is triggered by background thread when
+// utilization of slabs drops below threshold, indexed by kind partition
+struct defrag_trigger {
+    struct memkind *kind;
+    double threshold;
+    unsigned interval_ms;
+    void (*cb)(memkind_t kind, void *arg);
+    void *arg;
+    struct timespec next_check;
+    // kind whose callback is running, awaited by destroy of that kind
+    struct memkind *running;
+};
+
+static struct defrag_trigger defrag_triggers_g[MEMKIND_MAX_KIND];
+static pthread_mutex_t defrag_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t defrag_cond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t defrag_idle = PTHREAD_COND_INITIALIZER;
+static bool defrag_started;
+static bool defrag_atfork;
+
+static int defrag_start(void);
+
+static void defrag_atfork_child(void)
+{
+    unsigned i;
+    bool any = false;
+
+    pthread_mutex_init(&defrag_lock, NULL);
+    pthread_cond_init(&defrag_cond, NULL);
+    pthread_cond_init(&defrag_idle, NULL);
+    defrag_started = false;
+    // defrag thread of parent process is not running in child
+    for (i = 0; i < MEMKIND_MAX_KIND; ++i) {
+        defrag_triggers_g[i].running = NULL;
+        any = any || defrag_triggers_g[i].kind;
+    }
+    if (any) {
+        defrag_start();
+    }
+}
+
+static void timespec_add_ms(struct timespec *ts, unsigned ms)
+{
+    ts->tv_sec += ms / 1000;
+    ts->tv_nsec += (long)(ms % 1000) * 1000000;
+    if (ts->tv_nsec >= 1000000000) {
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000;
+    }
+}
+
+static bool timespec_before(const struct timespec *a, const struct timespec *b)
+{
+    return a->tv_sec < b->tv_sec ||
+        (a->tv_sec == b->tv_sec && a->tv_nsec < b->tv_nsec);
+}
+
+// Has to be called with defrag_lock held, the lock is dropped for callback,
+// so a long defrag cycle does not block other kinds; destroy of kind waits
+// for running callback of that kind.
+static void defrag_trigger_run(struct defrag_trigger *t)
+{
+    struct memkind *kind = t->kind;
+    double threshold = t->threshold;
+    void (*cb)(memkind_t kind, void *arg) = t->cb;
+    void *arg = t->arg;
+    double utilization;
+
+    t->running = kind;
+    pthread_mutex_unlock(&defrag_lock);
+    memkind_arena_update_cached_stats();
+    if (!memkind_arena_get_utilization(kind, &utilization) &&
+        utilization < threshold) {
+        cb(kind, arg);
+    }
+    pthread_mutex_lock(&defrag_lock);
+    t->running = NULL;
+    pthread_cond_broadcast(&defrag_idle);
+    // trigger could be removed or replaced meanwhile
+    if (t->kind == kind) {
+        clock_gettime(CLOCK_REALTIME, &t->next_check);
+        timespec_add_ms(&t->next_check, t->interval_ms);
+    }
+}
+
+static void *defrag_thread(void *arg)
+{
+    unsigned i;
+
+    pthread_mutex_lock(&defrag_lock);
+    while (true) {
+        struct timespec now, wake;
+        bool any = false;
+
+        clock_gettime(CLOCK_REALTIME, &now);
+        for (i = 0; i < MEMKIND_MAX_KIND; ++i) {
+            struct defrag_trigger *t = &defrag_triggers_g[i];
+
+            if (!t->kind) {
+                continue;
+            }
+            if (!timespec_before(&now, &t->next_check)) {
+                defrag_trigger_run(t);
+                if (!t->kind) {
+                    continue;
+                }
+            }
+            if (!any || timespec_before(&t->next_check, &wake)) {
+                wake = t->next_check;
+                any = true;
+            }
+        }
+        if (any) {
+            pthread_cond_timedwait(&defrag_cond, &defrag_lock, &wake);
+        } else {
+            pthread_cond_wait(&defrag_cond, &defrag_lock);
+        }
+    }
+    return NULL;
+}
+
+// Has to be called with defrag_lock held (or in child after fork).
+static int defrag_start(void)
+{
+    pthread_t thread;
+    pthread_attr_t attr;
+    int err = MEMKIND_SUCCESS;
+
+    if (defrag_started) {
+        return MEMKIND_SUCCESS;
+    }
+    if (!defrag_atfork) {
+        if (pthread_atfork(NULL, NULL, defrag_atfork_child)) {
+            log_err("Cannot register defrag fork handler.");
+            return MEMKIND_ERROR_RUNTIME;
+        }
+        defrag_atfork = true;
+    }
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    if (pthread_create(&thread, &attr, defrag_thread, NULL)) {
+        log_err("Cannot create defrag thread.");
+        err = MEMKIND_ERROR_RUNTIME;
+    } else {
+        defrag_started = true;
+    }
+    pthread_attr_destroy(&attr);
+    return err;
+}
+
+static void defrag_trigger_remove(struct memkind *kind)
+{
+    if (kind->partition >= MEMKIND_MAX_KIND) {
+        return;
+    }
+    struct defrag_trigger *t = &defrag_triggers_g[kind->partition];
+    pthread_mutex_lock(&defrag_lock);
+    if (t->kind == kind) {
+        t->kind = NULL;
+    }
+    while (t->running == kind) {
+        pthread_cond_wait(&defrag_idle, &defrag_lock);
+    }
+    pthread_mutex_unlock(&defrag_lock);
+}
+
+int memkind_arena_set_defrag_trigger(struct memkind *kind, double threshold,
+                                     unsigned interval_ms,
+                                     void (*cb)(memkind_t kind, void *arg),
+                                     void *arg)
+{
+    int err = MEMKIND_SUCCESS;
+
+    if (kind->ops->malloc != memkind_arena_malloc ||
+        kind->partition >= MEMKIND_MAX_KIND || threshold < 0.0 ||
+        threshold > 1.0 || (threshold > 0.0 && (!cb || !interval_ms))) {
+        return MEMKIND_ERROR_INVALID;
+    }
+    if (kind->ops->init_once) {
+        pthread_once(&kind->init_once, kind->ops->init_once);
+    }
+
+    pthread_mutex_lock(&defrag_lock);
+    struct defrag_trigger *t = &defrag_triggers_g[kind->partition];
+    if (threshold == 0.0) {
+        t->kind = NULL;
+        goto unlock;
+    }
+    err = defrag_start();
+    if (err) {
+        goto unlock;
+    }
+    t->kind = kind;
+    t->threshold = threshold;
+    t->interval_ms = interval_ms;
+    t->cb = cb;
+    t->arg = arg;
+    clock_gettime(CLOCK_REALTIME, &t->next_check);
+    timespec_add_ms(&t->next_check, interval_ms);
+    pthread_cond_signal(&defrag_cond);
+
+unlock:
+    pthread_mutex_unlock(&defrag_lock);
+    return err;
+}
+
 static bool is_stats_print_opts_valid(memkind_stat_print_opt opts)
 {
     CLEAR_BIT(opts, MEMKIND_STAT_PRINT_JSON_FORMAT);
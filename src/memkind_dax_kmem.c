@@ -6,25 +6,16 @@
 #include <memkind/internal/memkind_bitmask.h>
 #include <memkind/internal/memkind_dax_kmem.h>
 #include <memkind/internal/memkind_default.h>
+#include <memkind/internal/memkind_hugetlb.h>
 #include <memkind/internal/memkind_log.h>
+#include <memkind/internal/memkind_thp.h>
+#include <memkind/internal/memkind_topology.h>
 
 #include "config.h"
 #include <errno.h>
 #include <numa.h>
 #include <pthread.h>
 
-struct dax_numanode_t {
-    int init_err;
-    void *numanode;
-};
-
-static struct dax_numanode_t memkind_dax_kmem_numanode_g[NODE_VARIANT_MAX_EXT];
-static pthread_once_t memkind_dax_kmem_numanode_once_g[NODE_VARIANT_MAX_EXT] = {
-    PTHREAD_ONCE_INIT};
-
-static void memkind_dax_kmem_closest_numanode_init(void);
-static void memkind_dax_kmem_preferred_closest_numanode_init(void);
-static void memkind_dax_kmem_all_numanode_init(void);
 #ifdef MEMKIND_DAXCTL_KMEM
 #include <daxctl/libdaxctl.h>
 #ifndef daxctl_region_foreach_safe
@@ -90,7 +81,7 @@ static int get_dax_kmem_nodemask(struct bitmask **bm)
 }
 #endif
 
-static int memkind_dax_kmem_get_nodemask(struct bitmask **bm)
+int memkind_dax_kmem_get_nodemask(struct bitmask **bm)
 {
     char *nodes_env = memkind_get_env("MEMKIND_DAX_KMEM_NODES");
     if (nodes_env) {
@@ -105,72 +96,47 @@ static int memkind_dax_kmem_check_available(struct memkind *kind)
     return kind->ops->get_mbind_nodemask(kind, NULL, 0);
 }
 
-static int memkind_dax_kmem_get_mbind_nodemask(struct memkind *kind,
-                                               unsigned long *nodemask,
-                                               unsigned long maxnode)
-{
-    struct dax_numanode_t *g =
-        &memkind_dax_kmem_numanode_g[NODE_VARIANT_MULTIPLE];
-    pthread_once(&memkind_dax_kmem_numanode_once_g[NODE_VARIANT_MULTIPLE],
-                 memkind_dax_kmem_closest_numanode_init);
-    if (MEMKIND_LIKELY(!g->init_err)) {
-        g->init_err =
-            set_bitmask_for_current_numanode(nodemask, maxnode, g->numanode);
-    }
-    return g->init_err;
-}
-
-static int memkind_dax_kmem_get_preferred_mbind_nodemask(
-    struct memkind *kind, unsigned long *nodemask, unsigned long maxnode)
+static int memkind_dax_kmem_thp_check_available(struct memkind *kind)
 {
-    struct dax_numanode_t *g =
-        &memkind_dax_kmem_numanode_g[NODE_VARIANT_SINGLE];
-    pthread_once(&memkind_dax_kmem_numanode_once_g[NODE_VARIANT_SINGLE],
-                 memkind_dax_kmem_preferred_closest_numanode_init);
-    if (MEMKIND_LIKELY(!g->init_err)) {
-        g->init_err =
-            set_bitmask_for_current_numanode(nodemask, maxnode, g->numanode);
+    int err = memkind_dax_kmem_check_available(kind);
+    if (!err) {
+        err = memkind_thp_check_available(kind);
     }
-    return g->init_err;
+    return err;
 }
 
-MEMKIND_EXPORT int memkind_dax_kmem_all_get_mbind_nodemask(
-    struct memkind *kind, unsigned long *nodemask, unsigned long maxnode)
+static int memkind_dax_kmem_hugetlb_1gb_check_available(struct memkind *kind)
 {
-    struct dax_numanode_t *g = &memkind_dax_kmem_numanode_g[NODE_VARIANT_ALL];
-    pthread_once(&memkind_dax_kmem_numanode_once_g[NODE_VARIANT_ALL],
-                 memkind_dax_kmem_all_numanode_init);
-    if (MEMKIND_LIKELY(!g->init_err)) {
-        g->init_err =
-            set_bitmask_for_current_numanode(nodemask, maxnode, g->numanode);
+    int err = memkind_dax_kmem_check_available(kind);
+    if (!err) {
+        err = memkind_hugetlb_check_available_1gb(kind);
     }
-    return g->init_err;
+    return err;
 }
 
-static void memkind_dax_kmem_closest_numanode_init(void)
+static int memkind_dax_kmem_get_mbind_nodemask(struct memkind *kind,
+                                               unsigned long *nodemask,
+                                               unsigned long maxnode)
 {
-    struct dax_numanode_t *g =
-        &memkind_dax_kmem_numanode_g[NODE_VARIANT_MULTIPLE];
-    g->numanode = NULL;
-    g->init_err = set_closest_numanode(memkind_dax_kmem_get_nodemask,
-                                       &g->numanode, NODE_VARIANT_MULTIPLE);
+    return memkind_topology_set_nodemask(TOPOLOGY_DAX_KMEM_CLOSEST,
+                                         NODE_VARIANT_MULTIPLE, nodemask,
+                                         maxnode);
 }
 
-static void memkind_dax_kmem_preferred_closest_numanode_init(void)
+static int memkind_dax_kmem_get_preferred_mbind_nodemask(
+    struct memkind *kind, unsigned long *nodemask, unsigned long maxnode)
 {
-    struct dax_numanode_t *g =
-        &memkind_dax_kmem_numanode_g[NODE_VARIANT_SINGLE];
-    g->numanode = NULL;
-    g->init_err = set_closest_numanode(memkind_dax_kmem_get_nodemask,
-                                       &g->numanode, NODE_VARIANT_SINGLE);
+    return memkind_topology_set_nodemask(TOPOLOGY_DAX_KMEM_CLOSEST,
+                                         NODE_VARIANT_SINGLE, nodemask,
+                                         maxnode);
 }
 
-static void memkind_dax_kmem_all_numanode_init(void)
+MEMKIND_EXPORT int memkind_dax_kmem_all_get_mbind_nodemask(
+    struct memkind *kind, unsigned long *nodemask, unsigned long maxnode)
 {
-    struct dax_numanode_t *g = &memkind_dax_kmem_numanode_g[NODE_VARIANT_ALL];
-    g->numanode = NULL;
-    g->init_err = set_closest_numanode(memkind_dax_kmem_get_nodemask,
-                                       &g->numanode, NODE_VARIANT_ALL);
+    return memkind_topology_set_nodemask(TOPOLOGY_DAX_KMEM_ALL,
+                                         NODE_VARIANT_MULTIPLE, nodemask,
+                                         maxnode);
 }
 
 static void memkind_dax_kmem_init_once(void)
@@ -193,6 +159,16 @@ static void memkind_dax_kmem_interleave_init_once(void)
     memkind_init(MEMKIND_DAX_KMEM_INTERLEAVE, true);
 }
 
+static void memkind_dax_kmem_thp_init_once(void)
+{
+    memkind_init(MEMKIND_DAX_KMEM_THP, true);
+}
+
+static void memkind_dax_kmem_hugetlb_1gb_init_once(void)
+{
+    memkind_init(MEMKIND_DAX_KMEM_HUGETLB_1GB, true);
+}
+
 MEMKIND_EXPORT struct memkind_ops MEMKIND_DAX_KMEM_OPS = {
     .create = memkind_arena_create,
     .destroy = memkind_default_destroy,
@@ -276,3 +252,46 @@ MEMKIND_EXPORT struct memkind_ops MEMKIND_DAX_KMEM_INTERLEAVE_OPS = {
     .get_stat = memkind_arena_get_kind_stat,
     .defrag_reallocate = memkind_arena_defrag_reallocate,
 };
+
+MEMKIND_EXPORT struct memkind_ops MEMKIND_DAX_KMEM_THP_OPS = {
+    .create = memkind_arena_create,
+    .destroy = memkind_default_destroy,
+    .malloc = memkind_arena_malloc,
+    .calloc = memkind_arena_calloc,
+    .posix_memalign = memkind_arena_posix_memalign,
+    .realloc = memkind_arena_realloc,
+    .free = memkind_arena_free,
+    .check_available = memkind_dax_kmem_thp_check_available,
+    .mbind = memkind_default_mbind,
+    .madvise = memkind_thp_madvise,
+    .get_mmap_flags = memkind_default_get_mmap_flags,
+    .get_mbind_mode = memkind_default_get_mbind_mode,
+    .get_mbind_nodemask = memkind_dax_kmem_get_mbind_nodemask,
+    .get_arena = memkind_thread_get_arena,
+    .init_once = memkind_dax_kmem_thp_init_once,
+    .malloc_usable_size = memkind_default_malloc_usable_size,
+    .finalize = memkind_arena_finalize,
+    .get_stat = memkind_arena_get_kind_stat,
+    .defrag_reallocate = memkind_arena_defrag_reallocate,
+};
+
+MEMKIND_EXPORT struct memkind_ops MEMKIND_DAX_KMEM_HUGETLB_1GB_OPS = {
+    .create = memkind_arena_create,
+    .destroy = memkind_default_destroy,
+    .malloc = memkind_arena_malloc,
+    .calloc = memkind_arena_calloc,
+    .posix_memalign = memkind_arena_posix_memalign,
+    .realloc = memkind_arena_realloc,
+    .free = memkind_arena_free,
+    .check_available = memkind_dax_kmem_hugetlb_1gb_check_available,
+    .mbind = memkind_default_mbind,
+    .get_mmap_flags = memkind_hugetlb_1gb_get_mmap_flags,
+    .get_mbind_mode = memkind_default_get_mbind_mode,
+    .get_mbind_nodemask = memkind_dax_kmem_get_mbind_nodemask,
+    .get_arena = memkind_thread_get_arena,
+    .init_once = memkind_dax_kmem_hugetlb_1gb_init_once,
+    .malloc_usable_size = memkind_default_malloc_usable_size,
+    .finalize = memkind_arena_finalize,
+    .get_stat = memkind_arena_get_kind_stat,
+    .defrag_reallocate = memkind_arena_defrag_reallocate,
+};
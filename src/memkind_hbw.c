@@ -8,7 +8,8 @@
 #include <memkind/internal/memkind_hbw.h>
 #include <memkind/internal/memkind_hugetlb.h>
 #include <memkind/internal/memkind_log.h>
-#include <memkind/internal/memkind_mem_attributes.h>
+#include <memkind/internal/memkind_thp.h>
+#include <memkind/internal/memkind_topology.h>
 
 #include <assert.h>
 #include <errno.h>
@@ -173,18 +174,48 @@ MEMKIND_EXPORT struct memkind_ops MEMKIND_HBW_INTERLEAVE_OPS = {
     .defrag_reallocate = memkind_arena_defrag_reallocate,
 };
 
-struct hbw_numanode_t {
-    int init_err;
-    void *numanode;
+MEMKIND_EXPORT struct memkind_ops MEMKIND_HBW_THP_OPS = {
+    .create = memkind_arena_create,
+    .destroy = memkind_default_destroy,
+    .malloc = memkind_arena_malloc,
+    .calloc = memkind_arena_calloc,
+    .posix_memalign = memkind_arena_posix_memalign,
+    .realloc = memkind_arena_realloc,
+    .free = memkind_arena_free,
+    .check_available = memkind_hbw_thp_check_available,
+    .mbind = memkind_default_mbind,
+    .madvise = memkind_thp_madvise,
+    .get_mmap_flags = memkind_default_get_mmap_flags,
+    .get_mbind_mode = memkind_default_get_mbind_mode,
+    .get_mbind_nodemask = memkind_hbw_get_mbind_nodemask,
+    .get_arena = memkind_thread_get_arena,
+    .init_once = memkind_hbw_thp_init_once,
+    .malloc_usable_size = memkind_default_malloc_usable_size,
+    .finalize = memkind_arena_finalize,
+    .get_stat = memkind_arena_get_kind_stat,
+    .defrag_reallocate = memkind_arena_defrag_reallocate,
 };
 
-static struct hbw_numanode_t memkind_hbw_numanode_g[NODE_VARIANT_MAX_EXT];
-static pthread_once_t memkind_hbw_numanode_once_g[NODE_VARIANT_MAX_EXT] = {
-    PTHREAD_ONCE_INIT};
-
-static void memkind_hbw_closest_numanode_init(void);
-static void memkind_hbw_closest_preferred_numanode_init(void);
-static void memkind_hbw_all_numanode_init(void);
+MEMKIND_EXPORT struct memkind_ops MEMKIND_HBW_HUGETLB_1GB_OPS = {
+    .create = memkind_arena_create,
+    .destroy = memkind_default_destroy,
+    .malloc = memkind_arena_malloc,
+    .calloc = memkind_arena_calloc,
+    .posix_memalign = memkind_arena_posix_memalign,
+    .realloc = memkind_arena_realloc,
+    .free = memkind_arena_free,
+    .check_available = memkind_hbw_hugetlb_1gb_check_available,
+    .mbind = memkind_default_mbind,
+    .get_mmap_flags = memkind_hugetlb_1gb_get_mmap_flags,
+    .get_mbind_mode = memkind_default_get_mbind_mode,
+    .get_mbind_nodemask = memkind_hbw_get_mbind_nodemask,
+    .get_arena = memkind_thread_get_arena,
+    .init_once = memkind_hbw_hugetlb_1gb_init_once,
+    .malloc_usable_size = memkind_default_malloc_usable_size,
+    .finalize = memkind_arena_finalize,
+    .get_stat = memkind_arena_get_kind_stat,
+    .defrag_reallocate = memkind_arena_defrag_reallocate,
+};
 
 // This declaration is necessary, cause it's missing in headers from
 // libnuma 2.0.8
@@ -204,46 +235,50 @@ MEMKIND_EXPORT int memkind_hbw_hugetlb_check_available(struct memkind *kind)
     return err;
 }
 
+MEMKIND_EXPORT int
+memkind_hbw_hugetlb_1gb_check_available(struct memkind *kind)
+{
+    int err = memkind_hbw_check_available(kind);
+    if (!err) {
+        err = memkind_hugetlb_check_available_1gb(kind);
+    }
+    return err;
+}
+
+MEMKIND_EXPORT int memkind_hbw_thp_check_available(struct memkind *kind)
+{
+    int err = memkind_hbw_check_available(kind);
+    if (!err) {
+        err = memkind_thp_check_available(kind);
+    }
+    return err;
+}
+
 MEMKIND_EXPORT int memkind_hbw_get_mbind_nodemask(struct memkind *kind,
                                                   unsigned long *nodemask,
                                                   unsigned long maxnode)
 {
-    struct hbw_numanode_t *g = &memkind_hbw_numanode_g[NODE_VARIANT_MULTIPLE];
-    pthread_once(&memkind_hbw_numanode_once_g[NODE_VARIANT_MULTIPLE],
-                 memkind_hbw_closest_numanode_init);
-    if (MEMKIND_LIKELY(!g->init_err)) {
-        g->init_err =
-            set_bitmask_for_current_numanode(nodemask, maxnode, g->numanode);
-    }
-    return g->init_err;
+    return memkind_topology_set_nodemask(TOPOLOGY_HBW_CLOSEST,
+                                         NODE_VARIANT_MULTIPLE, nodemask,
+                                         maxnode);
 }
 
 int memkind_hbw_get_preferred_mbind_nodemask(struct memkind *kind,
                                              unsigned long *nodemask,
                                              unsigned long maxnode)
 {
-    struct hbw_numanode_t *g = &memkind_hbw_numanode_g[NODE_VARIANT_SINGLE];
-    pthread_once(&memkind_hbw_numanode_once_g[NODE_VARIANT_SINGLE],
-                 memkind_hbw_closest_preferred_numanode_init);
-    if (MEMKIND_LIKELY(!g->init_err)) {
-        g->init_err =
-            set_bitmask_for_current_numanode(nodemask, maxnode, g->numanode);
-    }
-    return g->init_err;
+    return memkind_topology_set_nodemask(TOPOLOGY_HBW_CLOSEST,
+                                         NODE_VARIANT_SINGLE, nodemask,
+                                         maxnode);
 }
 
 MEMKIND_EXPORT int memkind_hbw_all_get_mbind_nodemask(struct memkind *kind,
                                                       unsigned long *nodemask,
                                                       unsigned long maxnode)
 {
-    struct hbw_numanode_t *g = &memkind_hbw_numanode_g[NODE_VARIANT_ALL];
-    pthread_once(&memkind_hbw_numanode_once_g[NODE_VARIANT_ALL],
-                 memkind_hbw_all_numanode_init);
-    if (MEMKIND_LIKELY(!g->init_err)) {
-        g->init_err =
-            set_bitmask_for_current_numanode(nodemask, maxnode, g->numanode);
-    }
-    return g->init_err;
+    return memkind_topology_set_nodemask(TOPOLOGY_HBW_ALL,
+                                         NODE_VARIANT_MULTIPLE, nodemask,
+                                         maxnode);
 }
 
 typedef struct registers_t {
@@ -346,7 +381,7 @@ static int get_legacy_hbw_nodes_mask(struct bitmask **hbw_node_mask)
     return MEMKIND_ERROR_UNAVAILABLE;
 }
 
-static int memkind_hbw_get_nodemask(struct bitmask **bm)
+int memkind_hbw_get_nodemask(struct bitmask **bm)
 {
     char *nodes_env = memkind_get_env("MEMKIND_HBW_NODES");
     if (nodes_env) {
@@ -356,52 +391,13 @@ static int memkind_hbw_get_nodemask(struct bitmask **bm)
     }
 }
 
-static bool is_hmat_supported(void)
+bool memkind_hbw_hmat_supported(void)
 {
     if (memkind_get_env("MEMKIND_HBW_NODES") || is_hbm_legacy_supported())
         return false;
     return true;
 }
 
-static void memkind_hbw_closest_numanode_init(void)
-{
-    struct hbw_numanode_t *g = &memkind_hbw_numanode_g[NODE_VARIANT_MULTIPLE];
-    g->numanode = NULL;
-    if (!is_hmat_supported()) {
-        g->init_err = set_closest_numanode(memkind_hbw_get_nodemask,
-                                           &g->numanode, NODE_VARIANT_MULTIPLE);
-    } else {
-        g->init_err =
-            set_closest_numanode_mem_attr(&g->numanode, NODE_VARIANT_MULTIPLE);
-    }
-}
-
-static void memkind_hbw_closest_preferred_numanode_init(void)
-{
-    struct hbw_numanode_t *g = &memkind_hbw_numanode_g[NODE_VARIANT_SINGLE];
-    g->numanode = NULL;
-    if (!is_hmat_supported()) {
-        g->init_err = set_closest_numanode(memkind_hbw_get_nodemask,
-                                           &g->numanode, NODE_VARIANT_SINGLE);
-    } else {
-        g->init_err =
-            set_closest_numanode_mem_attr(&g->numanode, NODE_VARIANT_SINGLE);
-    }
-}
-
-static void memkind_hbw_all_numanode_init(void)
-{
-    struct hbw_numanode_t *g = &memkind_hbw_numanode_g[NODE_VARIANT_ALL];
-    g->numanode = NULL;
-    if (!is_hmat_supported()) {
-        g->init_err = set_closest_numanode(memkind_hbw_get_nodemask,
-                                           &g->numanode, NODE_VARIANT_ALL);
-    } else {
-        g->init_err =
-            set_closest_numanode_mem_attr(&g->numanode, NODE_VARIANT_ALL);
-    }
-}
-
 MEMKIND_EXPORT void memkind_hbw_init_once(void)
 {
     memkind_init(MEMKIND_HBW, true);
@@ -436,3 +432,13 @@ MEMKIND_EXPORT void memkind_hbw_interleave_init_once(void)
 {
     memkind_init(MEMKIND_HBW_INTERLEAVE, true);
 }
+
+MEMKIND_EXPORT void memkind_hbw_hugetlb_1gb_init_once(void)
+{
+    memkind_init(MEMKIND_HBW_HUGETLB_1GB, true);
+}
+
+MEMKIND_EXPORT void memkind_hbw_thp_init_once(void)
+{
+    memkind_init(MEMKIND_HBW_THP, true);
+}
@@ -14,6 +14,15 @@
 #ifndef MAP_HUGE_2MB
 #define MAP_HUGE_2MB (21 << 26)
 #endif
+#ifndef MAP_HUGE_1GB
+#define MAP_HUGE_1GB (30 << 26)
+#endif
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+#ifndef MAP_HUGE_MASK
+#define MAP_HUGE_MASK 0x3f
+#endif
 
 #include <dirent.h>
 #include <errno.h>
@@ -38,6 +47,24 @@ MEMKIND_EXPORT struct memkind_ops MEMKIND_HUGETLB_OPS = {
     .defrag_reallocate = memkind_arena_defrag_reallocate,
 };
 
+MEMKIND_EXPORT struct memkind_ops MEMKIND_HUGETLB_1GB_OPS = {
+    .create = memkind_arena_create,
+    .destroy = memkind_default_destroy,
+    .malloc = memkind_arena_malloc,
+    .calloc = memkind_arena_calloc,
+    .posix_memalign = memkind_arena_posix_memalign,
+    .realloc = memkind_arena_realloc,
+    .free = memkind_arena_free,
+    .check_available = memkind_hugetlb_check_available_1gb,
+    .get_mmap_flags = memkind_hugetlb_1gb_get_mmap_flags,
+    .get_arena = memkind_thread_get_arena,
+    .init_once = memkind_hugetlb_1gb_init_once,
+    .malloc_usable_size = memkind_default_malloc_usable_size,
+    .finalize = memkind_arena_finalize,
+    .get_stat = memkind_arena_get_kind_stat,
+    .defrag_reallocate = memkind_arena_defrag_reallocate,
+};
+
 static int memkind_hugetlb_check_available(struct memkind *kind,
                                            size_t huge_size);
 
@@ -48,16 +75,73 @@ MEMKIND_EXPORT int memkind_hugetlb_get_mmap_flags(struct memkind *kind,
     return 0;
 }
 
+MEMKIND_EXPORT int memkind_hugetlb_1gb_get_mmap_flags(struct memkind *kind,
+                                                      int *flags)
+{
+    *flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_HUGE_1GB;
+    return 0;
+}
+
 MEMKIND_EXPORT void memkind_hugetlb_init_once(void)
 {
     memkind_init(MEMKIND_HUGETLB, true);
 }
 
+MEMKIND_EXPORT void memkind_hugetlb_1gb_init_once(void)
+{
+    memkind_init(MEMKIND_HUGETLB_1GB, true);
+}
+
 MEMKIND_EXPORT int memkind_hugetlb_check_available_2mb(struct memkind *kind)
 {
     return memkind_hugetlb_check_available(kind, 2097152);
 }
 
+MEMKIND_EXPORT int memkind_hugetlb_check_available_1gb(struct memkind *kind)
+{
+    return memkind_hugetlb_check_available(kind, 1073741824);
+}
+
+MEMKIND_EXPORT size_t memkind_hugetlb_get_pagesize(struct memkind *kind)
+{
+    int flags;
+
+    if (!kind->ops->get_mmap_flags || kind->ops->get_mmap_flags(kind, &flags) ||
+        !(flags & MAP_HUGETLB)) {
+        return 0;
+    }
+    int shift = (flags >> MAP_HUGE_SHIFT) & MAP_HUGE_MASK;
+    /* on x86_64 default huge page size is 2MB */
+    return shift ? (size_t)1 << shift : 2097152;
+}
+
+MEMKIND_EXPORT ssize_t memkind_hugetlb_get_capacity(struct memkind *kind,
+                                                    size_t huge_size)
+{
+    nodemask_t nodemask;
+    struct bitmask nodemask_bm = {NUMA_NUM_NODES, nodemask.n};
+    size_t nr_persistent_hugepages, nr_overcommit_hugepages;
+
+    if (kind->ops->get_mbind_nodemask) {
+        if (kind->ops->get_mbind_nodemask(kind, nodemask.n, NUMA_NUM_NODES)) {
+            log_err("get_mbind_nodemask() failed");
+            return -1;
+        }
+    } else {
+        numa_bitmask_setall(&nodemask_bm);
+    }
+
+    if (get_nr_hugepages_cached(huge_size, &nodemask_bm,
+                                &nr_persistent_hugepages) ||
+        get_nr_overcommit_hugepages_cached(huge_size,
+                                           &nr_overcommit_hugepages)) {
+        log_err("Getting number of hugepages failed");
+        return -1;
+    }
+    return (ssize_t)((nr_persistent_hugepages + nr_overcommit_hugepages) *
+                     huge_size);
+}
+
 /* huge_size: the huge page size in bytes */
 static int memkind_hugetlb_check_available(struct memkind *kind,
                                            size_t huge_size)
@@ -0,0 +1,178 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/* Copyright (C) 2022 Intel Corporation. */
+
+#include <memkind/internal/memkind_dax_kmem.h>
+#include <memkind/internal/memkind_memcpy.h>
+#include <memkind/internal/memkind_pmem.h>
+#include <memkind/internal/memkind_pmem_persistent.h>
+#include <memkind/internal/memkind_private.h>
+
+#include <pthread.h>
+#include <stdint.h>
+#include <string.h>
+#ifdef __x86_64__
+#include <immintrin.h>
+#endif
+
+#define NT_LINE_SIZE 64
+
+// copies and fills nlines of NT_LINE_SIZE bytes, dst is aligned to line
+static void (*memcpy_lines_g)(char *dst, const char *src, size_t nlines);
+static void (*memset_lines_g)(char *dst, int c, size_t nlines);
+static pthread_once_t memcpy_nt_once_g = PTHREAD_ONCE_INIT;
+
+#ifdef __x86_64__
+static void memcpy_lines_sse2(char *dst, const char *src, size_t nlines)
+{
+    for (; nlines; --nlines, dst += NT_LINE_SIZE, src += NT_LINE_SIZE) {
+        __m128i v0 = _mm_loadu_si128((const __m128i *)src);
+        __m128i v1 = _mm_loadu_si128((const __m128i *)(src + 16));
+        __m128i v2 = _mm_loadu_si128((const __m128i *)(src + 32));
+        __m128i v3 = _mm_loadu_si128((const __m128i *)(src + 48));
+        _mm_stream_si128((__m128i *)dst, v0);
+        _mm_stream_si128((__m128i *)(dst + 16), v1);
+        _mm_stream_si128((__m128i *)(dst + 32), v2);
+        _mm_stream_si128((__m128i *)(dst + 48), v3);
+    }
+}
+
+static void memset_lines_sse2(char *dst, int c, size_t nlines)
+{
+    __m128i v = _mm_set1_epi8((char)c);
+    for (; nlines; --nlines, dst += NT_LINE_SIZE) {
+        _mm_stream_si128((__m128i *)dst, v);
+        _mm_stream_si128((__m128i *)(dst + 16), v);
+        _mm_stream_si128((__m128i *)(dst + 32), v);
+        _mm_stream_si128((__m128i *)(dst + 48), v);
+    }
+}
+
+__attribute__((target("avx2"))) static void
+memcpy_lines_avx2(char *dst, const char *src, size_t nlines)
+{
+    for (; nlines; --nlines, dst += NT_LINE_SIZE, src += NT_LINE_SIZE) {
+        __m256i v0 = _mm256_loadu_si256((const __m256i *)src);
+        __m256i v1 = _mm256_loadu_si256((const __m256i *)(src + 32));
+        _mm256_stream_si256((__m256i *)dst, v0);
+        _mm256_stream_si256((__m256i *)(dst + 32), v1);
+    }
+}
+
+__attribute__((target("avx2"))) static void
+memset_lines_avx2(char *dst, int c, size_t nlines)
+{
+    __m256i v = _mm256_set1_epi8((char)c);
+    for (; nlines; --nlines, dst += NT_LINE_SIZE) {
+        _mm256_stream_si256((__m256i *)dst, v);
+        _mm256_stream_si256((__m256i *)(dst + 32), v);
+    }
+}
+
+__attribute__((target("avx512f"))) static void
+memcpy_lines_avx512(char *dst, const char *src, size_t nlines)
+{
+    for (; nlines; --nlines, dst += NT_LINE_SIZE, src += NT_LINE_SIZE) {
+        _mm512_stream_si512((__m512i *)dst,
+                            _mm512_loadu_si512((const void *)src));
+    }
+}
+
+__attribute__((target("avx512f"))) static void
+memset_lines_avx512(char *dst, int c, size_t nlines)
+{
+    __m512i v = _mm512_set1_epi32((uint8_t)c * 0x01010101U);
+    for (; nlines; --nlines, dst += NT_LINE_SIZE) {
+        _mm512_stream_si512((__m512i *)dst, v);
+    }
+}
+#endif
+
+static void memcpy_nt_init(void)
+{
+#ifdef __x86_64__
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        memcpy_lines_g = memcpy_lines_avx512;
+        memset_lines_g = memset_lines_avx512;
+    } else if (__builtin_cpu_supports("avx2")) {
+        memcpy_lines_g = memcpy_lines_avx2;
+        memset_lines_g = memset_lines_avx2;
+    } else {
+        memcpy_lines_g = memcpy_lines_sse2;
+        memset_lines_g = memset_lines_sse2;
+    }
+#endif
+}
+
+MEMKIND_EXPORT bool memkind_memcpy_nt_enabled(struct memkind *kind,
+                                              size_t size)
+{
+    if (size < MEMKIND_MEMCPY_NT_THRESHOLD) {
+        return false;
+    }
+    struct memkind_ops *ops = kind->ops;
+    return ops == &MEMKIND_PMEM_OPS || ops == &MEMKIND_PMEM_PERSISTENT_OPS ||
+        ops == &MEMKIND_DAX_KMEM_OPS || ops == &MEMKIND_DAX_KMEM_ALL_OPS ||
+        ops == &MEMKIND_DAX_KMEM_PREFERRED_OPS ||
+        ops == &MEMKIND_DAX_KMEM_INTERLEAVE_OPS ||
+        ops == &MEMKIND_DAX_KMEM_THP_OPS ||
+        ops == &MEMKIND_DAX_KMEM_HUGETLB_1GB_OPS;
+}
+
+MEMKIND_EXPORT void memkind_memcpy_nt(void *dst, const void *src, size_t n)
+{
+    pthread_once(&memcpy_nt_once_g, memcpy_nt_init);
+    // unaligned head and tail are copied with regular stores
+    size_t head = (-(uintptr_t)dst) & (NT_LINE_SIZE - 1);
+    if (!memcpy_lines_g || n < head + NT_LINE_SIZE) {
+        memcpy(dst, src, n);
+        return;
+    }
+    memcpy(dst, src, head);
+    size_t nlines = (n - head) / NT_LINE_SIZE;
+    size_t body = nlines * NT_LINE_SIZE;
+    memcpy_lines_g((char *)dst + head, (const char *)src + head, nlines);
+    memcpy((char *)dst + head + body, (const char *)src + head + body,
+           n - head - body);
+#ifdef __x86_64__
+    // non-temporal stores are weakly ordered
+    _mm_sfence();
+#endif
+}
+
+MEMKIND_EXPORT void memkind_memset_nt(void *s, int c, size_t n)
+{
+    pthread_once(&memcpy_nt_once_g, memcpy_nt_init);
+    size_t head = (-(uintptr_t)s) & (NT_LINE_SIZE - 1);
+    if (!memset_lines_g || n < head + NT_LINE_SIZE) {
+        memset(s, c, n);
+        return;
+    }
+    memset(s, c, head);
+    size_t nlines = (n - head) / NT_LINE_SIZE;
+    size_t body = nlines * NT_LINE_SIZE;
+    memset_lines_g((char *)s + head, c, nlines);
+    memset((char *)s + head + body, c, n - head - body);
+#ifdef __x86_64__
+    _mm_sfence();
+#endif
+}
+
+MEMKIND_EXPORT void *memkind_memcpy(memkind_t kind, void *dst, const void *src,
+                                    size_t n)
+{
+    if (kind && memkind_memcpy_nt_enabled(kind, n)) {
+        memkind_memcpy_nt(dst, src, n);
+        return dst;
+    }
+    return memcpy(dst, src, n);
+}
+
+MEMKIND_EXPORT void *memkind_memset(memkind_t kind, void *s, int c, size_t n)
+{
+    if (kind && memkind_memcpy_nt_enabled(kind, n)) {
+        memkind_memset_nt(s, c, n);
+        return s;
+    }
+    return memset(s, c, n);
+}
@@ -11,6 +11,7 @@
 #include <math.h>
 #include <stdio.h>
 #include <string.h>
+#include <sys/mman.h>
 
 #ifdef HAVE_STDATOMIC_H
 #include <stdatomic.h>
@@ -143,6 +144,8 @@ extern void memtier_kind_calloc_post(struct memkind *, size_t, size_t, void **)
 extern void memtier_kind_posix_memalign_post(struct memkind *, void **, size_t,
                                              size_t, int *)
     __attribute__((weak));
+extern void memtier_kind_realloc_pre(struct memkind *, void **, size_t *)
+    __attribute__((weak));
 extern void memtier_kind_realloc_post(struct memkind *, void *, size_t, void **)
     __attribute__((weak));
 extern void memtier_kind_free_pre(void **) __attribute__((weak));
@@ -794,6 +797,10 @@ MEMKIND_EXPORT void *memtier_kind_realloc(memkind_t kind, void *ptr,
     } else if (ptr == NULL) {
         return memtier_kind_malloc(kind, size);
     }
+#ifdef MEMKIND_DECORATION_ENABLED
+    if (memtier_kind_realloc_pre)
+        memtier_kind_realloc_pre(kind, &ptr, &size);
+#endif
     decrement_alloc_size(kind->partition, jemk_malloc_usable_size(ptr));
 
     void *n_ptr = memkind_realloc(kind, ptr, size);
@@ -854,6 +861,46 @@ MEMKIND_EXPORT void memtier_kind_free(memkind_t kind, void *ptr)
     memkind_free(kind, ptr);
 }
 
+// anonymous memory can't be placed in kinds backed by file (e.g. FS_DAX)
+static int memtier_kind_is_anonymous(memkind_t kind)
+{
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+    if (kind->ops->get_mmap_flags)
+        kind->ops->get_mmap_flags(kind, &flags);
+    return (flags & MAP_SHARED) == 0;
+}
+
+MEMKIND_EXPORT memkind_t memtier_place_region(struct memtier_memory *memory,
+                                              void *addr, size_t size)
+{
+    memkind_t kind = memory->get_kind(memory, size);
+    unsigned i;
+
+    if (!memtier_kind_is_anonymous(kind)) {
+        for (i = 0; i < memory->cfg_size; ++i) {
+            if (memtier_kind_is_anonymous(memory->cfg[i].kind))
+                break;
+        }
+        if (i == memory->cfg_size) {
+            return NULL;
+        }
+        kind = memory->cfg[i].kind;
+    }
+
+    if (kind->ops->mbind && kind->ops->mbind(kind, addr, size)) {
+        return NULL;
+    }
+    increment_alloc_size(kind->partition, size);
+    memory->update_cfg(memory);
+
+    return kind;
+}
+
+MEMKIND_EXPORT void memtier_release_region(memkind_t kind, size_t size)
+{
+    decrement_alloc_size(kind->partition, size);
+}
+
 MEMKIND_EXPORT size_t memtier_kind_allocated_size(memkind_t kind)
 {
     size_t size_ret;
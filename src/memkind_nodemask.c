@@ -0,0 +1,332 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/* Copyright (C) 2022 Intel Corporation. */
+
+#include <memkind/internal/memkind_arena.h>
+#include <memkind/internal/memkind_log.h>
+#include <memkind/internal/memkind_nodemask.h>
+#include <memkind/internal/memkind_private.h>
+#include <memkind/internal/memkind_thp.h>
+
+#include <numaif.h>
+#include <stdio.h>
+#include <unistd.h>
+
+// weights are scaled to the range used by the kernel for weighted interleave
+#define MEMKIND_WEIGHT_MAX 255
+#define WEIGHTED_INTERLEAVE_SYSFS "/sys/kernel/mm/mempolicy/weighted_interleave"
+
+extern void memtier_reset_size(unsigned id);
+
+MEMKIND_EXPORT struct memkind_ops MEMKIND_NODEMASK_OPS = {
+    .create = memkind_nodemask_create,
+    .destroy = memkind_nodemask_destroy,
+    .malloc = memkind_arena_malloc,
+    .calloc = memkind_arena_calloc,
+    .posix_memalign = memkind_arena_posix_memalign,
+    .realloc = memkind_arena_realloc,
+    .free = memkind_arena_free,
+    .mbind = memkind_default_mbind,
+    .get_mmap_flags = memkind_default_get_mmap_flags,
+    .get_mbind_mode = memkind_nodemask_get_mbind_mode,
+    .get_mbind_nodemask = memkind_nodemask_get_mbind_nodemask,
+    .get_arena = memkind_thread_get_arena,
+    .malloc_usable_size = memkind_default_malloc_usable_size,
+    .finalize = memkind_nodemask_destroy,
+    .update_memory_usage_policy = memkind_arena_update_memory_usage_policy,
+    .get_stat = memkind_arena_get_kind_stat,
+    .defrag_reallocate = memkind_arena_defrag_reallocate,
+};
+
+MEMKIND_EXPORT struct memkind_ops MEMKIND_NODEMASK_THP_OPS = {
+    .create = memkind_nodemask_create,
+    .destroy = memkind_nodemask_destroy,
+    .malloc = memkind_arena_malloc,
+    .calloc = memkind_arena_calloc,
+    .posix_memalign = memkind_arena_posix_memalign,
+    .realloc = memkind_arena_realloc,
+    .free = memkind_arena_free,
+    .check_available = memkind_thp_check_available,
+    .mbind = memkind_default_mbind,
+    .madvise = memkind_thp_madvise,
+    .get_mmap_flags = memkind_default_get_mmap_flags,
+    .get_mbind_mode = memkind_nodemask_get_mbind_mode,
+    .get_mbind_nodemask = memkind_nodemask_get_mbind_nodemask,
+    .get_arena = memkind_thread_get_arena,
+    .malloc_usable_size = memkind_default_malloc_usable_size,
+    .finalize = memkind_nodemask_destroy,
+    .update_memory_usage_policy = memkind_arena_update_memory_usage_policy,
+    .get_stat = memkind_arena_get_kind_stat,
+    .defrag_reallocate = memkind_arena_defrag_reallocate,
+};
+
+MEMKIND_EXPORT struct memkind_ops MEMKIND_WEIGHTED_INTERLEAVE_OPS = {
+    .create = memkind_nodemask_create,
+    .destroy = memkind_nodemask_destroy,
+    .malloc = memkind_arena_malloc,
+    .calloc = memkind_arena_calloc,
+    .posix_memalign = memkind_arena_posix_memalign,
+    .realloc = memkind_arena_realloc,
+    .free = memkind_arena_free,
+    .mbind = memkind_nodemask_weighted_mbind,
+    .get_mmap_flags = memkind_default_get_mmap_flags,
+    .get_mbind_mode = memkind_nodemask_get_mbind_mode,
+    .get_mbind_nodemask = memkind_nodemask_get_mbind_nodemask,
+    .get_arena = memkind_thread_get_arena,
+    .malloc_usable_size = memkind_default_malloc_usable_size,
+    .finalize = memkind_nodemask_destroy,
+    .update_memory_usage_policy = memkind_arena_update_memory_usage_policy,
+    .get_stat = memkind_arena_get_kind_stat,
+    .defrag_reallocate = memkind_arena_defrag_reallocate,
+};
+
+MEMKIND_EXPORT int memkind_nodemask_create(struct memkind *kind,
+                                           struct memkind_ops *ops,
+                                           const char *name)
+{
+    struct memkind_nodemask *priv;
+
+    priv = (struct memkind_nodemask *)jemk_malloc(
+        sizeof(struct memkind_nodemask));
+    if (!priv) {
+        log_err("malloc() failed.");
+        return MEMKIND_ERROR_MALLOC;
+    }
+    priv->nodemask = numa_allocate_nodemask();
+    priv->mode = MPOL_BIND;
+    priv->nodes = NULL;
+    priv->weights = NULL;
+    priv->num_nodes = 0;
+    priv->total_weight = 0;
+    priv->cursor = 0;
+    priv->kernel_weights = false;
+
+    // nodemask is set by the caller before the first allocation, which
+    // creates arenas of the kind
+    int err = memkind_arena_create(kind, ops, name);
+    if (err) {
+        numa_bitmask_free(priv->nodemask);
+        jemk_free(priv);
+        return err;
+    }
+    // the kind is used like static kinds, cache small allocations
+    kind->use_tcache = true;
+    kind->priv = priv;
+    return MEMKIND_SUCCESS;
+}
+
+MEMKIND_EXPORT int memkind_nodemask_destroy(struct memkind *kind)
+{
+    struct memkind_nodemask *priv = kind->priv;
+
+    memkind_arena_destroy(kind);
+    memtier_reset_size(kind->partition);
+    numa_bitmask_free(priv->nodemask);
+    jemk_free(priv->nodes);
+    jemk_free(priv->weights);
+    jemk_free(priv);
+
+    return MEMKIND_SUCCESS;
+}
+
+MEMKIND_EXPORT int memkind_nodemask_get_mbind_nodemask(struct memkind *kind,
+                                                       unsigned long *nodemask,
+                                                       unsigned long maxnode)
+{
+    struct memkind_nodemask *priv = kind->priv;
+    struct bitmask nodemask_bm = {maxnode, nodemask};
+
+    copy_bitmask_to_bitmask(priv->nodemask, &nodemask_bm);
+    return MEMKIND_SUCCESS;
+}
+
+MEMKIND_EXPORT int memkind_nodemask_get_mbind_mode(struct memkind *kind,
+                                                   int *mode)
+{
+    struct memkind_nodemask *priv = kind->priv;
+
+    *mode = priv->mode;
+    return MEMKIND_SUCCESS;
+}
+
+static unsigned gcd(unsigned a, unsigned b)
+{
+    while (b) {
+        unsigned t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+// Checks if weights set in sysfs for MPOL_WEIGHTED_INTERLEAVE give the same
+// proportions as weights of the kind, sysfs is missing on older kernels.
+static bool kernel_weights_match(const struct memkind_nodemask *priv)
+{
+    unsigned *kernel = (unsigned *)jemk_malloc(priv->num_nodes *
+                                               sizeof(unsigned));
+    unsigned divisor = 0;
+    bool match = false;
+    unsigned i;
+
+    if (!kernel) {
+        return false;
+    }
+    for (i = 0; i < priv->num_nodes; ++i) {
+        char path[128];
+        snprintf(path, sizeof(path), WEIGHTED_INTERLEAVE_SYSFS "/node%d",
+                 priv->nodes[i]);
+        FILE *f = fopen(path, "r");
+        if (!f) {
+            goto exit;
+        }
+        int ret = fscanf(f, "%u", &kernel[i]);
+        fclose(f);
+        if (ret != 1 || kernel[i] == 0) {
+            goto exit;
+        }
+        divisor = gcd(divisor, kernel[i]);
+    }
+    for (i = 0; i < priv->num_nodes; ++i) {
+        if (kernel[i] / divisor != priv->weights[i]) {
+            goto exit;
+        }
+    }
+    match = true;
+
+exit:
+    jemk_free(kernel);
+    return match;
+}
+
+MEMKIND_EXPORT int memkind_nodemask_set_weights(struct memkind *kind,
+                                                const unsigned long long *weights)
+{
+    struct memkind_nodemask *priv = kind->priv;
+    unsigned long long max_weight = 0;
+    unsigned num_nodes = numa_bitmask_weight(priv->nodemask);
+    unsigned divisor = 0;
+    unsigned i, j;
+
+    priv->nodes = (int *)jemk_malloc(num_nodes * sizeof(int));
+    priv->weights = (unsigned *)jemk_malloc(num_nodes * sizeof(unsigned));
+    if (!priv->nodes || !priv->weights) {
+        log_err("malloc() failed.");
+        return MEMKIND_ERROR_MALLOC;
+    }
+
+    for (i = 0; i < priv->nodemask->size; ++i) {
+        if (numa_bitmask_isbitset(priv->nodemask, i) &&
+            weights[i] > max_weight) {
+            max_weight = weights[i];
+        }
+    }
+    if (max_weight == 0) {
+        log_err("Weights of all nodes are zero.");
+        return MEMKIND_ERROR_INVALID;
+    }
+
+    // bandwidth values are scaled down, so one interleave cycle is short
+    for (i = 0, j = 0; i < priv->nodemask->size; ++i) {
+        if (!numa_bitmask_isbitset(priv->nodemask, i)) {
+            continue;
+        }
+        unsigned weight = (unsigned)((double)weights[i] * MEMKIND_WEIGHT_MAX /
+                                         max_weight +
+                                     0.5);
+        priv->nodes[j] = i;
+        priv->weights[j] = weight ? weight : 1;
+        divisor = gcd(divisor, priv->weights[j]);
+        ++j;
+    }
+    priv->num_nodes = num_nodes;
+    priv->total_weight = 0;
+    for (j = 0; j < num_nodes; ++j) {
+        priv->weights[j] /= divisor;
+        priv->total_weight += priv->weights[j];
+    }
+    priv->kernel_weights = kernel_weights_match(priv);
+    log_info("Weighted interleave of %u nodes, cycle of %u pages%s.",
+             num_nodes, priv->total_weight,
+             priv->kernel_weights ? " by kernel" : "");
+
+    return MEMKIND_SUCCESS;
+}
+
+static size_t overlap(size_t begin1, size_t end1, size_t begin2, size_t end2)
+{
+    size_t begin = begin1 > begin2 ? begin1 : begin2;
+    size_t end = end1 < end2 ? end1 : end2;
+    return end > begin ? end - begin : 0;
+}
+
+// Returns how many of pages of extent go to node idx. Every full cycle of
+// pages gives weight pages to each node, remaining pages take slots of the
+// cycle starting from position pos.
+MEMKIND_EXPORT size_t
+memkind_nodemask_weighted_pages(const struct memkind_nodemask *priv,
+                                unsigned idx, size_t pages, unsigned pos)
+{
+    size_t total = priv->total_weight;
+    size_t rest = pages % total;
+    size_t begin = 0;
+    unsigned i;
+
+    for (i = 0; i < idx; ++i) {
+        begin += priv->weights[i];
+    }
+    size_t end = begin + priv->weights[idx];
+
+    size_t count = (pages / total) * priv->weights[idx];
+    count += overlap(pos, pos + rest, begin, end);
+    if (pos + rest > total) {
+        count += overlap(0, pos + rest - total, begin, end);
+    }
+    return count;
+}
+
+MEMKIND_EXPORT int memkind_nodemask_weighted_mbind(struct memkind *kind,
+                                                   void *ptr, size_t size)
+{
+    struct memkind_nodemask *priv = kind->priv;
+    int err;
+
+    if (priv->kernel_weights) {
+        err = mbind(ptr, size, MPOL_WEIGHTED_INTERLEAVE, priv->nodemask->maskp,
+                    priv->nodemask->size + 1, 0);
+        if (MEMKIND_UNLIKELY(err)) {
+            log_err("syscall mbind() returned: %d", err);
+            return MEMKIND_ERROR_MBIND;
+        }
+        return MEMKIND_SUCCESS;
+    }
+
+    // each node gets one contiguous range of the extent, so the number of
+    // mappings does not grow with the extent size
+    const size_t page_size = sysconf(_SC_PAGESIZE);
+    size_t pages = size / page_size;
+    unsigned pos = __atomic_fetch_add(&priv->cursor, pages % priv->total_weight,
+                                      __ATOMIC_RELAXED) %
+        priv->total_weight;
+    char *addr = ptr;
+    char *end = addr + size;
+    unsigned i;
+
+    for (i = 0; i < priv->num_nodes; ++i) {
+        size_t len = (i == priv->num_nodes - 1)
+            ? (size_t)(end - addr)
+            : memkind_nodemask_weighted_pages(priv, i, pages, pos) * page_size;
+        if (len == 0) {
+            continue;
+        }
+        nodemask_t nodemask;
+        nodemask_zero(&nodemask);
+        nodemask_set_compat(&nodemask, priv->nodes[i]);
+        err = mbind(addr, len, MPOL_BIND, nodemask.n, NUMA_NUM_NODES, 0);
+        if (MEMKIND_UNLIKELY(err)) {
+            log_err("syscall mbind() returned: %d", err);
+            return MEMKIND_ERROR_MBIND;
+        }
+        addr += len;
+    }
+    return MEMKIND_SUCCESS;
+}
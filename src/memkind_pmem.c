@@ -24,6 +24,19 @@ extern void memtier_reset_size(unsigned id);
 #define MAP_SHARED_VALIDATE 0x03
 #endif
 
+#ifndef MAP_POPULATE
+#define MAP_POPULATE 0x08000
+#endif
+
+#define PMEM_CACHE_LINE 64
+
+// writes back cache lines of range, NULL - no instruction is available
+static void (*pmem_flush_cache_g)(const void *addr, size_t len);
+static pthread_once_t pmem_flush_once_g = PTHREAD_ONCE_INIT;
+
+static void pmem_ranges_remove(struct memkind_pmem *priv, uintptr_t start,
+                               uintptr_t end);
+
 MEMKIND_EXPORT struct memkind_ops MEMKIND_PMEM_OPS = {
     .create = memkind_pmem_create,
     .destroy = memkind_pmem_destroy,
@@ -42,6 +55,29 @@ MEMKIND_EXPORT struct memkind_ops MEMKIND_PMEM_OPS = {
     .defrag_reallocate = memkind_arena_defrag_reallocate,
 };
 
+// Carves extent from mapping of preallocated file, no system call is needed
+static void *pmem_prealloc_carve(struct memkind_pmem *priv, size_t size,
+                                 size_t alignment, bool *zero, bool *commit)
+{
+    uintptr_t base = (uintptr_t)priv->base;
+    void *addr = NULL;
+
+    if (pthread_mutex_lock(&priv->pmem_lock) != 0)
+        assert(0 && "failed to acquire mutex");
+    uintptr_t start =
+        (base + priv->offset + alignment - 1) & ~(uintptr_t)(alignment - 1);
+    if (start + size <= base + priv->max_size && start >= base) {
+        priv->offset = start + size - base;
+        priv->current_size += size;
+        addr = (void *)start;
+        *zero = true;
+        *commit = true;
+    }
+    if (pthread_mutex_unlock(&priv->pmem_lock) != 0)
+        assert(0 && "failed to release mutex");
+    return addr;
+}
+
 void *pmem_extent_alloc(extent_hooks_t *extent_hooks, void *new_addr,
                         size_t size, size_t alignment, bool *zero, bool *commit,
                         unsigned arena_ind)
@@ -64,6 +100,11 @@ void *pmem_extent_alloc(extent_hooks_t *extent_hooks, void *new_addr,
         goto exit;
     }
 
+    struct memkind_pmem *priv = kind->priv;
+    if (priv->base) {
+        return pmem_prealloc_carve(priv, size, alignment, zero, commit);
+    }
+
     addr = memkind_pmem_mmap(kind, new_addr, size);
 
     if (addr != MAP_FAILED) {
@@ -88,6 +129,14 @@ bool pmem_extent_dalloc_hog_memory(extent_hooks_t *extent_hooks, void *addr,
 bool pmem_extent_dalloc(extent_hooks_t *extent_hooks, void *addr, size_t size,
                         bool committed, unsigned arena_ind)
 {
+    struct memkind *kind = get_kind_by_arena(arena_ind);
+
+    // extent of preallocated file is retained by jemalloc for reuse, its
+    // space is released only by purge
+    if (((struct memkind_pmem *)kind->priv)->base) {
+        return true;
+    }
+
     // if madvise fail, it means that addr isn't mapped shared (doesn't come
     // from pmem) and it should be also unmapped to avoid space exhaustion when
     // calling large number of operations like memkind_create_pmem and
@@ -95,7 +144,6 @@ bool pmem_extent_dalloc(extent_hooks_t *extent_hooks, void *addr, size_t size,
     errno = 0;
     int status = madvise(addr, size, MADV_REMOVE);
     if (!status) {
-        struct memkind *kind = get_kind_by_arena(arena_ind);
         struct memkind_pmem *priv = kind->priv;
         assert(priv->current_size >= size);
         if (pthread_mutex_lock(&priv->pmem_lock) != 0)
@@ -113,6 +161,7 @@ bool pmem_extent_dalloc(extent_hooks_t *extent_hooks, void *addr, size_t size,
         log_err("munmap failed!");
         return true;
     }
+    pmem_ranges_remove(kind->priv, (uintptr_t)addr, (uintptr_t)addr + size);
     return false;
 }
 
@@ -137,6 +186,20 @@ bool pmem_extent_purge(extent_hooks_t *extent_hooks, void *addr, size_t size,
     return true;
 }
 
+bool pmem_extent_purge_forced(extent_hooks_t *extent_hooks, void *addr,
+                              size_t size, size_t offset, size_t length,
+                              unsigned arena_ind)
+{
+    struct memkind *kind = get_kind_by_arena(arena_ind);
+
+    // punch hole in preallocated file, otherwise opt-out as extent is
+    // released by dalloc
+    if (!((struct memkind_pmem *)kind->priv)->base) {
+        return true;
+    }
+    return madvise((char *)addr + offset, length, MADV_REMOVE) != 0;
+}
+
 bool pmem_extent_split(extent_hooks_t *extent_hooks, void *addr, size_t size,
                        size_t size_a, size_t size_b, bool committed,
                        unsigned arena_ind)
@@ -156,8 +219,17 @@ bool pmem_extent_merge(extent_hooks_t *extent_hooks, void *addr_a,
 void pmem_extent_destroy(extent_hooks_t *extent_hooks, void *addr, size_t size,
                          bool committed, unsigned arena_ind)
 {
+    struct memkind *kind = get_kind_by_arena(arena_ind);
+
+    // mapping of preallocated file is unmapped with the kind
+    if (kind && ((struct memkind_pmem *)kind->priv)->base) {
+        return;
+    }
     if (munmap(addr, size) == -1) {
         log_err("munmap failed!");
+    } else if (kind) {
+        pmem_ranges_remove(kind->priv, (uintptr_t)addr,
+                           (uintptr_t)addr + size);
     }
 }
 
@@ -168,6 +240,7 @@ static extent_hooks_t pmem_extent_hooks = {
     .commit = pmem_extent_commit,
     .decommit = pmem_extent_decommit,
     .purge_lazy = pmem_extent_purge,
+    .purge_forced = pmem_extent_purge_forced,
     .split = pmem_extent_split,
     .merge = pmem_extent_merge,
     .destroy = pmem_extent_destroy
@@ -179,6 +252,7 @@ static extent_hooks_t pmem_extent_hooks_hog_memory = {
     .commit = pmem_extent_commit,
     .decommit = pmem_extent_decommit,
     .purge_lazy = pmem_extent_purge,
+    .purge_forced = pmem_extent_purge_forced,
     .split = pmem_extent_split,
     .merge = pmem_extent_merge,
     .destroy = pmem_extent_destroy
@@ -244,6 +318,9 @@ MEMKIND_EXPORT int memkind_pmem_create(struct memkind *kind,
         err = MEMKIND_ERROR_RUNTIME;
         goto exit;
     }
+    priv->ranges = NULL;
+    priv->ranges_num = 0;
+    priv->ranges_cap = 0;
 
     err = memkind_default_create(kind, ops, name);
     if (err) {
@@ -278,7 +355,12 @@ MEMKIND_EXPORT int memkind_pmem_destroy(struct memkind *kind)
     memtier_reset_size(kind->partition);
     pthread_mutex_destroy(&priv->pmem_lock);
 
+    if (priv->base) {
+        munmap(priv->base, priv->max_size);
+    }
+
     (void)close(priv->fd);
+    jemk_free(priv->ranges);
     jemk_free(priv->dir);
     jemk_free(priv);
 
@@ -304,6 +386,136 @@ exit:
     return status;
 }
 
+// Returns index of first mapping ending after addr, has to be called with
+// pmem_lock held.
+static size_t pmem_ranges_find(const struct memkind_pmem *priv, uintptr_t addr)
+{
+    size_t lo = 0, hi = priv->ranges_num;
+
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (priv->ranges[mid].end <= addr) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+// Makes room for one more mapping at index i, has to be called with
+// pmem_lock held.
+static int pmem_ranges_insert(struct memkind_pmem *priv, size_t i)
+{
+    if (priv->ranges_num == priv->ranges_cap) {
+        size_t cap = priv->ranges_cap ? 2 * priv->ranges_cap : 16;
+        struct pmem_range *ranges =
+            jemk_realloc(priv->ranges, cap * sizeof(struct pmem_range));
+        if (!ranges) {
+            log_err("realloc() failed.");
+            return -1;
+        }
+        priv->ranges = ranges;
+        priv->ranges_cap = cap;
+    }
+    memmove(&priv->ranges[i + 1], &priv->ranges[i],
+            (priv->ranges_num - i) * sizeof(struct pmem_range));
+    priv->ranges_num++;
+    return 0;
+}
+
+static void pmem_ranges_erase(struct memkind_pmem *priv, size_t i)
+{
+    memmove(&priv->ranges[i], &priv->ranges[i + 1],
+            (priv->ranges_num - i - 1) * sizeof(struct pmem_range));
+    priv->ranges_num--;
+}
+
+// Adds mapping [start, end), has to be called with pmem_lock held.
+static int pmem_ranges_add(struct memkind_pmem *priv, uintptr_t start,
+                           uintptr_t end)
+{
+    size_t i = pmem_ranges_find(priv, start);
+    bool prev = i > 0 && priv->ranges[i - 1].end == start;
+    bool next = i < priv->ranges_num && priv->ranges[i].start == end;
+
+    if (prev && next) {
+        priv->ranges[i - 1].end = priv->ranges[i].end;
+        pmem_ranges_erase(priv, i);
+    } else if (prev) {
+        priv->ranges[i - 1].end = end;
+    } else if (next) {
+        priv->ranges[i].start = start;
+    } else {
+        if (pmem_ranges_insert(priv, i)) {
+            return -1;
+        }
+        priv->ranges[i].start = start;
+        priv->ranges[i].end = end;
+    }
+    return 0;
+}
+
+// Removes unmapped range [start, end) from mappings.
+static void pmem_ranges_remove(struct memkind_pmem *priv, uintptr_t start,
+                               uintptr_t end)
+{
+    if (pthread_mutex_lock(&priv->pmem_lock) != 0)
+        assert(0 && "failed to acquire mutex");
+    size_t i = pmem_ranges_find(priv, start);
+    while (i < priv->ranges_num && priv->ranges[i].start < end) {
+        uintptr_t r_start = priv->ranges[i].start;
+        uintptr_t r_end = priv->ranges[i].end;
+
+        if (r_start < start && r_end > end) {
+            // range is split, on failure hole stays in mappings and flush of
+            // it fails in msync()
+            if (!pmem_ranges_insert(priv, i + 1)) {
+                priv->ranges[i].end = start;
+                priv->ranges[i + 1].start = end;
+                priv->ranges[i + 1].end = r_end;
+            }
+            break;
+        }
+        if (r_start < start) {
+            priv->ranges[i++].end = start;
+        } else if (r_end > end) {
+            priv->ranges[i].start = end;
+            break;
+        } else {
+            pmem_ranges_erase(priv, i);
+        }
+    }
+    if (pthread_mutex_unlock(&priv->pmem_lock) != 0)
+        assert(0 && "failed to release mutex");
+}
+
+// Returns true if range [addr, addr + len) lies inside mappings of kind.
+bool memkind_pmem_range_mapped(struct memkind *kind, const void *addr,
+                               size_t len)
+{
+    struct memkind_pmem *priv = kind->priv;
+    uintptr_t start = (uintptr_t)addr;
+    uintptr_t end = start + len;
+    bool mapped;
+
+    if (end < start) {
+        return false;
+    }
+    if (priv->base) {
+        uintptr_t base = (uintptr_t)priv->base;
+        return start >= base && end <= base + priv->max_size;
+    }
+    if (pthread_mutex_lock(&priv->pmem_lock) != 0)
+        assert(0 && "failed to acquire mutex");
+    size_t i = pmem_ranges_find(priv, start);
+    mapped = i < priv->ranges_num && priv->ranges[i].start <= start &&
+        end <= priv->ranges[i].end;
+    if (pthread_mutex_unlock(&priv->pmem_lock) != 0)
+        assert(0 && "failed to release mutex");
+    return mapped;
+}
+
 MEMKIND_EXPORT void *memkind_pmem_mmap(struct memkind *kind, void *addr,
                                        size_t size)
 {
@@ -335,8 +547,14 @@ MEMKIND_EXPORT void *memkind_pmem_mmap(struct memkind *kind, void *addr,
 
     if ((result = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, priv->fd,
                        priv->offset)) != MAP_FAILED) {
-        priv->offset += size;
-        priv->current_size += size;
+        if (pmem_ranges_add(priv, (uintptr_t)result,
+                            (uintptr_t)result + size)) {
+            munmap(result, size);
+            result = MAP_FAILED;
+        } else {
+            priv->offset += size;
+            priv->current_size += size;
+        }
     }
 
     if (pthread_mutex_unlock(&priv->pmem_lock) != 0)
@@ -345,12 +563,135 @@ MEMKIND_EXPORT void *memkind_pmem_mmap(struct memkind *kind, void *addr,
     return result;
 }
 
+int memkind_pmem_preallocate(struct memkind *kind, bool populate)
+{
+    struct memkind_pmem *priv = kind->priv;
+    int flags = MAP_SHARED | (populate ? MAP_POPULATE : 0);
+
+    if ((errno = posix_fallocate(priv->fd, 0, (off_t)priv->max_size)) != 0) {
+        log_err("Cannot preallocate file of size %zu: errno=%d.",
+                priv->max_size, errno);
+        return MEMKIND_ERROR_RUNTIME;
+    }
+    void *addr =
+        mmap(NULL, priv->max_size, PROT_READ | PROT_WRITE, flags, priv->fd, 0);
+    if (addr == MAP_FAILED) {
+        log_err("mmap() failed.");
+        return MEMKIND_ERROR_MMAP;
+    }
+    priv->base = addr;
+    return MEMKIND_SUCCESS;
+}
+
 MEMKIND_EXPORT int memkind_pmem_get_mmap_flags(struct memkind *kind, int *flags)
 {
     *flags = MAP_SHARED;
     return 0;
 }
 
+int memkind_pmem_map_flags(bool map_sync)
+{
+    // with MAP_SYNC file metadata is durable on page fault, so flush of CPU
+    // caches is enough to make stores durable
+    return map_sync ? MAP_SHARED_VALIDATE | MAP_SYNC : MAP_SHARED;
+}
+
+bool memkind_pmem_map_sync_supported(int fd)
+{
+    const size_t size = sysconf(_SC_PAGESIZE);
+
+    void *addr = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED_VALIDATE | MAP_SYNC, fd, 0);
+    if (addr == MAP_FAILED) {
+        return false;
+    }
+    munmap(addr, size);
+    return true;
+}
+
+#ifdef __x86_64__
+#define CPUID_FEATURES_LEAF     1
+#define CPUID_EXT_FEATURES_LEAF 7
+#define CPUID_CLFLUSH_BIT       (1U << 19) // EDX of leaf 1
+#define CPUID_CLFLUSHOPT_BIT    (1U << 23) // EBX of leaf 7
+#define CPUID_CLWB_BIT          (1U << 24) // EBX of leaf 7
+
+static void pmem_cpuid(uint32_t leaf, uint32_t regs[4])
+{
+    asm volatile("cpuid"
+                 : "=a"(regs[0]), "=b"(regs[1]), "=c"(regs[2]), "=d"(regs[3])
+                 : "0"(leaf), "2"(0));
+}
+
+#define PMEM_FLUSH_CACHE_FUNC(insn)                                            \
+    static void pmem_flush_cache_##insn(const void *addr, size_t len)          \
+    {                                                                          \
+        uintptr_t line = (uintptr_t)addr & ~(uintptr_t)(PMEM_CACHE_LINE - 1);  \
+        for (; line < (uintptr_t)addr + len; line += PMEM_CACHE_LINE) {        \
+            asm volatile(#insn " %0" : "+m"(*(volatile char *)line));          \
+        }                                                                      \
+    }
+
+PMEM_FLUSH_CACHE_FUNC(clwb)
+PMEM_FLUSH_CACHE_FUNC(clflushopt)
+PMEM_FLUSH_CACHE_FUNC(clflush)
+#endif
+
+static void pmem_flush_init(void)
+{
+#ifdef __x86_64__
+    uint32_t regs[4];
+
+    pmem_cpuid(0, regs);
+    if (regs[0] >= CPUID_EXT_FEATURES_LEAF) {
+        pmem_cpuid(CPUID_EXT_FEATURES_LEAF, regs);
+        // CLWB keeps the line in cache, CLFLUSHOPT evicts it
+        if (regs[1] & CPUID_CLWB_BIT) {
+            pmem_flush_cache_g = pmem_flush_cache_clwb;
+            return;
+        }
+        if (regs[1] & CPUID_CLFLUSHOPT_BIT) {
+            pmem_flush_cache_g = pmem_flush_cache_clflushopt;
+            return;
+        }
+    }
+    pmem_cpuid(CPUID_FEATURES_LEAF, regs);
+    if (regs[3] & CPUID_CLFLUSH_BIT) {
+        pmem_flush_cache_g = pmem_flush_cache_clflush;
+    }
+#endif
+}
+
+MEMKIND_EXPORT int memkind_pmem_flush_range(bool map_sync, const void *addr,
+                                            size_t len)
+{
+    if (map_sync) {
+        pthread_once(&pmem_flush_once_g, pmem_flush_init);
+        if (pmem_flush_cache_g) {
+            pmem_flush_cache_g(addr, len);
+            return MEMKIND_SUCCESS;
+        }
+    }
+
+    const uintptr_t page_mask = sysconf(_SC_PAGESIZE) - 1;
+    uintptr_t start = (uintptr_t)addr & ~page_mask;
+    if (msync((void *)start, (uintptr_t)addr + len - start, MS_SYNC) != 0) {
+        log_err("msync() failed: errno=%d.", errno);
+        return MEMKIND_ERROR_RUNTIME;
+    }
+    return MEMKIND_SUCCESS;
+}
+
+MEMKIND_EXPORT void memkind_pmem_drain_stores(void)
+{
+#ifdef __x86_64__
+    // orders weakly ordered CLWB and CLFLUSHOPT before following stores
+    asm volatile("sfence" ::: "memory");
+#else
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+#endif
+}
+
 int memkind_pmem_validate_dir(const char *dir)
 {
     int ret = MEMKIND_SUCCESS;
@@ -368,13 +709,9 @@ int memkind_pmem_validate_dir(const char *dir)
         goto end;
     }
 
-    void *addr = mmap(NULL, size, PROT_READ | PROT_WRITE,
-                      MAP_SHARED_VALIDATE | MAP_SYNC, fd, 0);
-    if (addr == MAP_FAILED) {
+    if (!memkind_pmem_map_sync_supported(fd)) {
         ret = MEMKIND_ERROR_MMAP;
-        goto end;
     }
-    munmap(addr, size);
 
 end:
     (void)close(fd);
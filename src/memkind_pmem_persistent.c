@@ -0,0 +1,925 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/* Copyright (C) 2022 Intel Corporation. */
+
+#include <memkind/internal/memkind_arena.h>
+#include <memkind/internal/memkind_log.h>
+#include <memkind/internal/memkind_pmem.h>
+#include <memkind/internal/memkind_pmem_persistent.h>
+#include <memkind/internal/memkind_private.h>
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifndef MAP_FIXED_NOREPLACE
+#define MAP_FIXED_NOREPLACE 0x100000
+#endif
+
+/*
+ * File starts with header page, the rest of file is a heap of blocks. Every
+ * block begins with boundary tag with its size and size of the previous
+ * block, so neighbours of freed block are found without any lookup. Free
+ * blocks are linked in lists segregated by power of 2 of their size. Links
+ * are offsets from beginning of the file, file is always mapped at the same
+ * address, so pointers stored by application in its objects stay valid.
+ *
+ * Shared memory kind uses the same heap in shared memory object. It could be
+ * mapped at different addresses in cooperating processes, which exchange
+ * offsets of objects. The heap is guarded by robust process-shared mutex
+ * placed in the header, so death of process holding it does not block the
+ * others.
+ */
+#define PERSIST_VERSION   2ULL
+#define PERSIST_HDR_SIZE  4096ULL
+#define PERSIST_ALIGN     16ULL
+#define PERSIST_TAG_SIZE  (sizeof(struct persist_block))
+#define PERSIST_MIN_BLOCK (sizeof(struct persist_free))
+#define PERSIST_BINS      64
+#define PERSIST_USED      1ULL
+// attempts to find shared heap initialized by other process
+#define SHARED_ATTACH_RETRIES 1000
+
+static const char persist_magic[8] = "MEMKPHP";
+
+struct persist_header {
+    char magic[8];
+    uint64_t version;
+    uint64_t base;      // address at which file is mapped
+    uint64_t size;      // size of file
+    uint64_t root;      // offset of root object, 0 - root is not set
+    uint64_t allocated; // sum of sizes of used blocks
+    uint64_t clean;     // 1 - heap was closed, 0 - heap is open or crashed
+    uint64_t bins[PERSIST_BINS]; // heads of free lists, 0 - list is empty
+    pthread_mutex_t lock;        // heap lock of shared memory kind
+};
+
+struct persist_block {
+    uint64_t size;      // size with tag, PERSIST_USED bit marks used block
+    uint64_t prev_size; // size of previous block, 0 - first block
+};
+
+struct persist_free {
+    struct persist_block tag;
+    uint64_t next; // neighbours on free list, 0 - end of list
+    uint64_t prev;
+};
+
+MEMKIND_EXPORT struct memkind_ops MEMKIND_PMEM_PERSISTENT_OPS = {
+    .create = memkind_pmem_persistent_create,
+    .destroy = memkind_pmem_persistent_destroy,
+    .malloc = memkind_pmem_persistent_malloc,
+    .calloc = memkind_pmem_persistent_calloc,
+    .posix_memalign = memkind_pmem_persistent_posix_memalign,
+    .realloc = memkind_pmem_persistent_realloc,
+    .free = memkind_pmem_persistent_free,
+    .malloc_usable_size = memkind_pmem_persistent_malloc_usable_size,
+    .finalize = memkind_pmem_persistent_destroy,
+    .get_stat = memkind_pmem_persistent_get_stat,
+    .defrag_reallocate = memkind_pmem_persistent_defrag_reallocate,
+};
+
+MEMKIND_EXPORT struct memkind_ops MEMKIND_SHARED_OPS = {
+    .create = memkind_pmem_persistent_create,
+    .destroy = memkind_shared_destroy,
+    .malloc = memkind_pmem_persistent_malloc,
+    .calloc = memkind_pmem_persistent_calloc,
+    .posix_memalign = memkind_pmem_persistent_posix_memalign,
+    .realloc = memkind_pmem_persistent_realloc,
+    .free = memkind_pmem_persistent_free,
+    .malloc_usable_size = memkind_pmem_persistent_malloc_usable_size,
+    .finalize = memkind_shared_destroy,
+    .get_stat = memkind_pmem_persistent_get_stat,
+    .defrag_reallocate = memkind_pmem_persistent_defrag_reallocate,
+};
+
+static inline struct persist_header *
+persist_hdr(struct memkind_pmem_persistent *priv)
+{
+    return (struct persist_header *)priv->base;
+}
+
+static inline struct persist_block *
+persist_blk(struct memkind_pmem_persistent *priv, uint64_t off)
+{
+    return (struct persist_block *)(priv->base + off);
+}
+
+static inline struct persist_free *
+persist_free_blk(struct memkind_pmem_persistent *priv, uint64_t off)
+{
+    return (struct persist_free *)(priv->base + off);
+}
+
+static inline unsigned persist_bin(uint64_t size)
+{
+    return 63 - __builtin_clzll(size);
+}
+
+// size of block serving allocation of @size bytes, 0 - too big request
+static uint64_t persist_block_size(struct memkind_pmem_persistent *priv,
+                                   size_t size)
+{
+    if (size > priv->size) {
+        return 0;
+    }
+    uint64_t need =
+        (size + PERSIST_TAG_SIZE + PERSIST_ALIGN - 1) & ~(PERSIST_ALIGN - 1);
+    return need < PERSIST_MIN_BLOCK ? PERSIST_MIN_BLOCK : need;
+}
+
+static void persist_list_insert(struct memkind_pmem_persistent *priv,
+                                uint64_t off)
+{
+    struct persist_header *hdr = persist_hdr(priv);
+    struct persist_free *blk = persist_free_blk(priv, off);
+    unsigned bin = persist_bin(blk->tag.size);
+
+    blk->prev = 0;
+    blk->next = hdr->bins[bin];
+    if (blk->next) {
+        persist_free_blk(priv, blk->next)->prev = off;
+    }
+    hdr->bins[bin] = off;
+}
+
+static void persist_list_remove(struct memkind_pmem_persistent *priv,
+                                uint64_t off)
+{
+    struct persist_free *blk = persist_free_blk(priv, off);
+
+    if (blk->prev) {
+        persist_free_blk(priv, blk->prev)->next = blk->next;
+    } else {
+        persist_hdr(priv)->bins[persist_bin(blk->tag.size)] = blk->next;
+    }
+    if (blk->next) {
+        persist_free_blk(priv, blk->next)->prev = blk->prev;
+    }
+}
+
+static void persist_put_free(struct memkind_pmem_persistent *priv,
+                             uint64_t off, uint64_t size, uint64_t prev_size)
+{
+    struct persist_block *blk = persist_blk(priv, off);
+
+    blk->size = size;
+    blk->prev_size = prev_size;
+    if (off + size < priv->size) {
+        persist_blk(priv, off + size)->prev_size = size;
+    }
+    persist_list_insert(priv, off);
+}
+
+// Returns block to free lists, merging it with free neighbours
+static void persist_release(struct memkind_pmem_persistent *priv, uint64_t off,
+                            uint64_t size)
+{
+    struct persist_block *blk = persist_blk(priv, off);
+    uint64_t next = off + size;
+
+    if (next < priv->size && !(persist_blk(priv, next)->size & PERSIST_USED)) {
+        size += persist_blk(priv, next)->size;
+        persist_list_remove(priv, next);
+    }
+    if (blk->prev_size &&
+        !(persist_blk(priv, off - blk->prev_size)->size & PERSIST_USED)) {
+        off -= blk->prev_size;
+        size += persist_blk(priv, off)->size;
+        persist_list_remove(priv, off);
+    }
+    persist_put_free(priv, off, size, persist_blk(priv, off)->prev_size);
+}
+
+// Shrinks used block of @size to @need, the tail is returned to free lists
+static void persist_trim(struct memkind_pmem_persistent *priv, uint64_t off,
+                         uint64_t size, uint64_t need)
+{
+    if (size - need < PERSIST_MIN_BLOCK) {
+        return;
+    }
+    // tail tag is written before block shrinks, so heap walk stays valid
+    struct persist_block *tail = persist_blk(priv, off + need);
+    tail->size = (size - need) | PERSIST_USED;
+    tail->prev_size = need;
+    persist_blk(priv, off)->size = need | PERSIST_USED;
+    persist_hdr(priv)->allocated -= size - need;
+    persist_release(priv, off + need, size - need);
+}
+
+// Takes free block out of free lists and marks first @need bytes as used
+static void *persist_use(struct memkind_pmem_persistent *priv, uint64_t off,
+                         uint64_t need)
+{
+    struct persist_block *blk = persist_blk(priv, off);
+    uint64_t size = blk->size;
+
+    persist_list_remove(priv, off);
+    blk->size = size | PERSIST_USED;
+    persist_hdr(priv)->allocated += size;
+    persist_trim(priv, off, size, need);
+    return (char *)blk + PERSIST_TAG_SIZE;
+}
+
+static uint64_t persist_find(struct memkind_pmem_persistent *priv,
+                             uint64_t need)
+{
+    struct persist_header *hdr = persist_hdr(priv);
+    unsigned bin = persist_bin(need);
+    uint64_t off;
+
+    // only list of the request bin may contain too small blocks
+    for (off = hdr->bins[bin]; off; off = persist_free_blk(priv, off)->next) {
+        if (persist_blk(priv, off)->size >= need) {
+            return off;
+        }
+    }
+    for (++bin; bin < PERSIST_BINS; ++bin) {
+        if (hdr->bins[bin]) {
+            return hdr->bins[bin];
+        }
+    }
+    return 0;
+}
+
+// offset of used block of @ptr, 0 - @ptr was not allocated from the heap
+static uint64_t persist_offset(struct memkind_pmem_persistent *priv,
+                               const void *ptr)
+{
+    uintptr_t p = (uintptr_t)ptr;
+    uintptr_t base = (uintptr_t)priv->base;
+
+    if (p < base + PERSIST_HDR_SIZE + PERSIST_TAG_SIZE ||
+        p >= base + priv->size || (p & (PERSIST_ALIGN - 1))) {
+        return 0;
+    }
+    uint64_t off = p - PERSIST_TAG_SIZE - base;
+    return (persist_blk(priv, off)->size & PERSIST_USED) ? off : 0;
+}
+
+static int persist_init_heap(struct memkind_pmem_persistent *priv,
+                             bool shared)
+{
+    struct persist_header *hdr = persist_hdr(priv);
+    pthread_mutexattr_t attr;
+
+    memset(hdr, 0, sizeof(*hdr));
+    hdr->version = PERSIST_VERSION;
+    hdr->base = shared ? 0 : (uintptr_t)priv->base;
+    hdr->size = priv->size;
+    persist_put_free(priv, PERSIST_HDR_SIZE, priv->size - PERSIST_HDR_SIZE, 0);
+    if (shared) {
+        if (pthread_mutexattr_init(&attr) != 0) {
+            return MEMKIND_ERROR_RUNTIME;
+        }
+        int err = pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+        err |= pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+        err |= pthread_mutex_init(&hdr->lock, &attr);
+        pthread_mutexattr_destroy(&attr);
+        if (err) {
+            log_err("Cannot initialize lock of shared heap.");
+            return MEMKIND_ERROR_RUNTIME;
+        }
+        priv->lock = &hdr->lock;
+    }
+    // magic is written last, heap without it is never opened
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    memcpy(hdr->magic, persist_magic, sizeof(hdr->magic));
+    return MEMKIND_SUCCESS;
+}
+
+// Rebuilds free lists and usage of heap, which was not closed properly
+static int persist_recover_heap(struct memkind_pmem_persistent *priv)
+{
+    struct persist_header *hdr = persist_hdr(priv);
+    uint64_t off = PERSIST_HDR_SIZE;
+    uint64_t prev_size = 0;
+    uint64_t free_off = 0;
+    uint64_t free_size = 0;
+
+    memset(hdr->bins, 0, sizeof(hdr->bins));
+    hdr->allocated = 0;
+    while (off < priv->size) {
+        struct persist_block *blk = persist_blk(priv, off);
+        uint64_t size = blk->size & ~PERSIST_USED;
+
+        if (size < PERSIST_MIN_BLOCK || (size & (PERSIST_ALIGN - 1)) ||
+            size > priv->size - off) {
+            log_err("Persistent heap is corrupted at offset %" PRIu64 ".", off);
+            return MEMKIND_ERROR_RUNTIME;
+        }
+        if (blk->size & PERSIST_USED) {
+            if (free_size) {
+                persist_put_free(priv, free_off, free_size, prev_size);
+                prev_size = free_size;
+                free_size = 0;
+            }
+            blk->prev_size = prev_size;
+            hdr->allocated += size;
+            prev_size = size;
+        } else if (free_size) {
+            free_size += size;
+        } else {
+            free_off = off;
+            free_size = size;
+        }
+        off += size;
+    }
+    if (free_size) {
+        persist_put_free(priv, free_off, free_size, prev_size);
+    }
+    return MEMKIND_SUCCESS;
+}
+
+// Returns MEMKIND_SUCCESS with heap locked, or error when shared heap cannot
+// be used any more, because its state could not be recovered.
+static int persist_lock(struct memkind_pmem_persistent *priv)
+{
+    int err = pthread_mutex_lock(priv->lock);
+    // process holding lock of shared heap died in the middle of update
+    if (MEMKIND_UNLIKELY(err == EOWNERDEAD)) {
+        log_info("Owner of shared heap lock died, recovering.");
+        if (persist_recover_heap(priv)) {
+            // lock is left inconsistent, it becomes not recoverable
+            pthread_mutex_unlock(priv->lock);
+            return MEMKIND_ERROR_RUNTIME;
+        }
+        pthread_mutex_consistent(priv->lock);
+    } else if (MEMKIND_UNLIKELY(err == ENOTRECOVERABLE)) {
+        log_err("Shared heap was not recovered after death of lock owner.");
+        return MEMKIND_ERROR_RUNTIME;
+    } else if (err != 0) {
+        assert(0 && "failed to acquire mutex");
+    }
+    return MEMKIND_SUCCESS;
+}
+
+static void persist_unlock(struct memkind_pmem_persistent *priv)
+{
+    if (pthread_mutex_unlock(priv->lock) != 0)
+        assert(0 && "failed to release mutex");
+}
+
+MEMKIND_EXPORT int memkind_pmem_persistent_create(struct memkind *kind,
+                                                  struct memkind_ops *ops,
+                                                  const char *name)
+{
+    struct memkind_pmem_persistent *priv;
+    int err;
+
+    priv = (struct memkind_pmem_persistent *)jemk_malloc(
+        sizeof(struct memkind_pmem_persistent));
+    if (!priv) {
+        log_err("malloc() failed.");
+        return MEMKIND_ERROR_MALLOC;
+    }
+
+    if (pthread_mutex_init(&priv->local_lock, NULL) != 0) {
+        jemk_free(priv);
+        return MEMKIND_ERROR_RUNTIME;
+    }
+
+    err = memkind_default_create(kind, ops, name);
+    if (err) {
+        pthread_mutex_destroy(&priv->local_lock);
+        jemk_free(priv);
+        return err;
+    }
+
+    priv->lock = &priv->local_lock;
+    priv->map_sync = false;
+    priv->fd = -1;
+    priv->base = NULL;
+    priv->size = 0;
+    kind->priv = priv;
+    return 0;
+}
+
+MEMKIND_EXPORT int memkind_pmem_persistent_destroy(struct memkind *kind)
+{
+    struct memkind_pmem_persistent *priv = kind->priv;
+    int err = 0;
+
+    if (priv->base) {
+        // header is marked clean only after the heap reaches the file
+        if (msync(priv->base, priv->size, MS_SYNC) == 0) {
+            persist_hdr(priv)->clean = 1;
+            err = msync(priv->base, PERSIST_HDR_SIZE, MS_SYNC);
+        } else {
+            err = -1;
+        }
+        if (err) {
+            log_err("Cannot flush persistent heap: errno=%d.", errno);
+            err = MEMKIND_ERROR_RUNTIME;
+        }
+        munmap(priv->base, priv->size);
+    }
+    if (priv->fd != -1) {
+        (void)close(priv->fd);
+    }
+    pthread_mutex_destroy(&priv->local_lock);
+    jemk_free(priv);
+
+    return err;
+}
+
+MEMKIND_EXPORT int memkind_shared_destroy(struct memkind *kind)
+{
+    struct memkind_pmem_persistent *priv = kind->priv;
+
+    // heap stays in shared memory object for other processes
+    if (priv->base) {
+        munmap(priv->base, priv->size);
+    }
+    if (priv->fd != -1) {
+        (void)close(priv->fd);
+    }
+    pthread_mutex_destroy(&priv->local_lock);
+    jemk_free(priv);
+
+    return 0;
+}
+
+int memkind_pmem_persistent_open_file(const char *path, int *fd)
+{
+    if ((*fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0600)) < 0) {
+        log_err("Could not open file %s: errno=%d.", path, errno);
+        return MEMKIND_ERROR_INVALID;
+    }
+    // heap could be used by single kind at a time
+    if (flock(*fd, LOCK_EX | LOCK_NB) != 0) {
+        log_err("File %s is used by other persistent kind.", path);
+        (void)close(*fd);
+        *fd = -1;
+        return MEMKIND_ERROR_INVALID;
+    }
+    return MEMKIND_SUCCESS;
+}
+
+static int persist_map_existing(struct memkind_pmem_persistent *priv,
+                                size_t file_size)
+{
+    struct persist_header hdr;
+
+    if (pread(priv->fd, &hdr, sizeof(hdr), 0) != sizeof(hdr) ||
+        memcmp(hdr.magic, persist_magic, sizeof(hdr.magic)) ||
+        hdr.version != PERSIST_VERSION || !hdr.base ||
+        hdr.size != file_size) {
+        log_err("File is not a persistent heap.");
+        return MEMKIND_ERROR_INVALID;
+    }
+
+    void *addr = mmap((void *)(uintptr_t)hdr.base, hdr.size,
+                      PROT_READ | PROT_WRITE,
+                      memkind_pmem_map_flags(priv->map_sync) |
+                          MAP_FIXED_NOREPLACE,
+                      priv->fd, 0);
+    if (addr == MAP_FAILED) {
+        log_err("Cannot map persistent heap at address %p: errno=%d.",
+                (void *)(uintptr_t)hdr.base, errno);
+        return MEMKIND_ERROR_MMAP;
+    }
+    // kernels without MAP_FIXED_NOREPLACE treat address as a hint
+    if (addr != (void *)(uintptr_t)hdr.base) {
+        munmap(addr, hdr.size);
+        log_err("Cannot map persistent heap at address %p.",
+                (void *)(uintptr_t)hdr.base);
+        return MEMKIND_ERROR_MMAP;
+    }
+    priv->base = addr;
+    priv->size = hdr.size;
+
+    if (!persist_hdr(priv)->clean) {
+        log_info("Persistent heap was not closed properly, recovering.");
+        int err = persist_recover_heap(priv);
+        if (err) {
+            // corrupted heap is left untouched
+            munmap(priv->base, priv->size);
+            priv->base = NULL;
+            return err;
+        }
+    }
+    return MEMKIND_SUCCESS;
+}
+
+static int persist_map_new(struct memkind_pmem_persistent *priv, size_t size)
+{
+    if (!size) {
+        log_err("Cannot create persistent heap: size is not specified.");
+        return MEMKIND_ERROR_INVALID;
+    }
+    if ((errno = posix_fallocate(priv->fd, 0, (off_t)size)) != 0) {
+        log_err("Cannot allocate file of size %zu: errno=%d.", size, errno);
+        return MEMKIND_ERROR_RUNTIME;
+    }
+    void *addr = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                      memkind_pmem_map_flags(priv->map_sync), priv->fd, 0);
+    if (addr == MAP_FAILED) {
+        log_err("mmap() failed.");
+        return MEMKIND_ERROR_MMAP;
+    }
+    priv->base = addr;
+    priv->size = size;
+    return persist_init_heap(priv, false);
+}
+
+int memkind_pmem_persistent_map(struct memkind *kind, int fd, size_t size)
+{
+    struct memkind_pmem_persistent *priv = kind->priv;
+    struct stat st;
+    int err;
+
+    priv->fd = fd;
+    priv->map_sync = memkind_pmem_map_sync_supported(fd);
+    if (fstat(fd, &st) != 0) {
+        log_err("fstat() failed: errno=%d.", errno);
+        return MEMKIND_ERROR_RUNTIME;
+    }
+    if (st.st_size) {
+        err = persist_map_existing(priv, st.st_size);
+    } else {
+        err = persist_map_new(priv, size);
+    }
+    if (err) {
+        return err;
+    }
+
+    // heap is dirty until it is closed
+    persist_hdr(priv)->clean = 0;
+    if (msync(priv->base, PERSIST_HDR_SIZE, MS_SYNC) != 0) {
+        log_err("Cannot flush persistent heap header: errno=%d.", errno);
+        return MEMKIND_ERROR_RUNTIME;
+    }
+    return MEMKIND_SUCCESS;
+}
+
+int memkind_shared_open(const char *name, int *fd, bool *created)
+{
+    *created = true;
+    *fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (*fd < 0 && errno == EEXIST) {
+        *created = false;
+        *fd = shm_open(name, O_RDWR, 0600);
+    }
+    if (*fd < 0) {
+        log_err("Could not open shared memory %s: errno=%d.", name, errno);
+        return MEMKIND_ERROR_INVALID;
+    }
+    return MEMKIND_SUCCESS;
+}
+
+static int shared_map_new(struct memkind_pmem_persistent *priv, size_t size)
+{
+    size = (size + PERSIST_HDR_SIZE - 1) & ~(PERSIST_HDR_SIZE - 1);
+    if (size <= PERSIST_HDR_SIZE) {
+        log_err("Cannot create shared heap: invalid size: %zu.", size);
+        return MEMKIND_ERROR_INVALID;
+    }
+    if (ftruncate(priv->fd, (off_t)size) != 0) {
+        log_err("Cannot resize shared memory to %zu: errno=%d.", size, errno);
+        return MEMKIND_ERROR_RUNTIME;
+    }
+    void *addr =
+        mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, priv->fd, 0);
+    if (addr == MAP_FAILED) {
+        log_err("mmap() failed.");
+        return MEMKIND_ERROR_MMAP;
+    }
+    priv->base = addr;
+    priv->size = size;
+    return persist_init_heap(priv, true);
+}
+
+static int shared_map_existing(struct memkind_pmem_persistent *priv)
+{
+    const struct timespec wait = {0, 1000 * 1000};
+    struct persist_header hdr;
+    struct stat st;
+    unsigned i;
+
+    // creator could still initialize the heap
+    for (i = 0;; ++i) {
+        if (fstat(priv->fd, &st) != 0) {
+            log_err("fstat() failed: errno=%d.", errno);
+            return MEMKIND_ERROR_RUNTIME;
+        }
+        if ((uint64_t)st.st_size >= PERSIST_HDR_SIZE &&
+            pread(priv->fd, &hdr, sizeof(hdr), 0) == sizeof(hdr) &&
+            !memcmp(hdr.magic, persist_magic, sizeof(hdr.magic))) {
+            break;
+        }
+        if (i == SHARED_ATTACH_RETRIES) {
+            log_err("Shared memory is not a shared heap.");
+            return MEMKIND_ERROR_INVALID;
+        }
+        nanosleep(&wait, NULL);
+    }
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (hdr.version != PERSIST_VERSION || hdr.base ||
+        hdr.size != (uint64_t)st.st_size) {
+        log_err("Shared memory is not a shared heap.");
+        return MEMKIND_ERROR_INVALID;
+    }
+
+    void *addr =
+        mmap(NULL, hdr.size, PROT_READ | PROT_WRITE, MAP_SHARED, priv->fd, 0);
+    if (addr == MAP_FAILED) {
+        log_err("mmap() failed.");
+        return MEMKIND_ERROR_MMAP;
+    }
+    priv->base = addr;
+    priv->size = hdr.size;
+    priv->lock = &persist_hdr(priv)->lock;
+    return MEMKIND_SUCCESS;
+}
+
+int memkind_shared_map(struct memkind *kind, int fd, bool created, size_t size)
+{
+    struct memkind_pmem_persistent *priv = kind->priv;
+
+    priv->fd = fd;
+    return created ? shared_map_new(priv, size) : shared_map_existing(priv);
+}
+
+int memkind_pmem_persistent_flush(struct memkind *kind, const void *addr,
+                                  size_t len)
+{
+    struct memkind_pmem_persistent *priv = kind->priv;
+
+    if ((uintptr_t)addr < (uintptr_t)priv->base ||
+        (uintptr_t)addr + len > (uintptr_t)priv->base + priv->size) {
+        log_err("Range %p of %zu bytes is out of persistent heap.", addr, len);
+        return MEMKIND_ERROR_INVALID;
+    }
+    return memkind_pmem_flush_range(priv->map_sync, addr, len);
+}
+
+MEMKIND_EXPORT void *memkind_pmem_persistent_malloc(struct memkind *kind,
+                                                    size_t size)
+{
+    struct memkind_pmem_persistent *priv = kind->priv;
+    void *ptr = NULL;
+
+    if (!kind->allow_zero_allocs &&
+        MEMKIND_UNLIKELY(size_out_of_bounds(size))) {
+        return NULL;
+    }
+    uint64_t need = persist_block_size(priv, size);
+    if (MEMKIND_LIKELY(need && !persist_lock(priv))) {
+        uint64_t off = persist_find(priv, need);
+        if (off) {
+            ptr = persist_use(priv, off, need);
+        }
+        persist_unlock(priv);
+    }
+    if (MEMKIND_UNLIKELY(!ptr)) {
+        errno = ENOMEM;
+    }
+    return ptr;
+}
+
+MEMKIND_EXPORT void *memkind_pmem_persistent_calloc(struct memkind *kind,
+                                                    size_t num, size_t size)
+{
+    if (!kind->allow_zero_allocs &&
+        MEMKIND_UNLIKELY(size_out_of_bounds(num) || size_out_of_bounds(size))) {
+        return NULL;
+    }
+    if (num && size > SIZE_MAX / num) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    // freed blocks keep their content, so memory is always cleared
+    void *ptr = memkind_pmem_persistent_malloc(kind, num * size);
+    if (ptr) {
+        memset(ptr, 0, num * size);
+    }
+    return ptr;
+}
+
+MEMKIND_EXPORT int
+memkind_pmem_persistent_posix_memalign(struct memkind *kind, void **memptr,
+                                       size_t alignment, size_t size)
+{
+    struct memkind_pmem_persistent *priv = kind->priv;
+
+    *memptr = NULL;
+    int err = memkind_posix_check_alignment(kind, alignment);
+    if (err) {
+        return err;
+    }
+    if (!kind->allow_zero_allocs &&
+        MEMKIND_UNLIKELY(size_out_of_bounds(size))) {
+        return 0;
+    }
+    if (alignment <= PERSIST_ALIGN) {
+        int errno_before = errno;
+        *memptr = memkind_pmem_persistent_malloc(kind, size);
+        errno = errno_before;
+        return *memptr ? 0 : ENOMEM;
+    }
+
+    uint64_t need = persist_block_size(priv, size);
+    if (!need || alignment > priv->size || persist_lock(priv)) {
+        return ENOMEM;
+    }
+    // block is big enough to cut free block in front of aligned one
+    uint64_t off = persist_find(priv, need + alignment + PERSIST_MIN_BLOCK);
+    if (off) {
+        uintptr_t ptr = (uintptr_t)priv->base + off + PERSIST_TAG_SIZE;
+        uintptr_t aligned = (ptr + alignment - 1) & ~(uintptr_t)(alignment - 1);
+        while (aligned != ptr && aligned - ptr < PERSIST_MIN_BLOCK) {
+            aligned += alignment;
+        }
+        uint64_t gap = aligned - ptr;
+        if (gap) {
+            struct persist_block *blk = persist_blk(priv, off);
+            uint64_t size = blk->size;
+            uint64_t prev_size = blk->prev_size;
+
+            persist_list_remove(priv, off);
+            persist_put_free(priv, off + gap, size - gap, gap);
+            persist_put_free(priv, off, gap, prev_size);
+            off += gap;
+        }
+        *memptr = persist_use(priv, off, need);
+    }
+    persist_unlock(priv);
+
+    return *memptr ? 0 : ENOMEM;
+}
+
+MEMKIND_EXPORT void memkind_pmem_persistent_free(struct memkind *kind,
+                                                 void *ptr)
+{
+    struct memkind_pmem_persistent *priv = kind->priv;
+
+    if (!ptr || persist_lock(priv)) {
+        return;
+    }
+    uint64_t off = persist_offset(priv, ptr);
+    if (MEMKIND_LIKELY(off)) {
+        uint64_t size = persist_blk(priv, off)->size & ~PERSIST_USED;
+        persist_hdr(priv)->allocated -= size;
+        persist_release(priv, off, size);
+    } else {
+        log_err("Pointer %p was not allocated from persistent heap.", ptr);
+    }
+    persist_unlock(priv);
+}
+
+MEMKIND_EXPORT void *memkind_pmem_persistent_realloc(struct memkind *kind,
+                                                     void *ptr, size_t size)
+{
+    struct memkind_pmem_persistent *priv = kind->priv;
+
+    if (!ptr) {
+        return memkind_pmem_persistent_malloc(kind, size);
+    }
+    if (!kind->allow_zero_allocs &&
+        MEMKIND_UNLIKELY(size_out_of_bounds(size))) {
+        memkind_pmem_persistent_free(kind, ptr);
+        return NULL;
+    }
+    uint64_t need = persist_block_size(priv, size);
+    if (!need || persist_lock(priv)) {
+        errno = ENOMEM;
+        return NULL;
+    }
+
+    uint64_t off = persist_offset(priv, ptr);
+    uint64_t cur = off ? persist_blk(priv, off)->size & ~PERSIST_USED : 0;
+    uint64_t next = off + cur;
+    bool in_place = false;
+
+    if (off && cur < need && next < priv->size &&
+        !(persist_blk(priv, next)->size & PERSIST_USED) &&
+        cur + persist_blk(priv, next)->size >= need) {
+        // grow into the following free block
+        uint64_t next_size = persist_blk(priv, next)->size;
+        persist_list_remove(priv, next);
+        cur += next_size;
+        persist_blk(priv, off)->size = cur | PERSIST_USED;
+        if (off + cur < priv->size) {
+            persist_blk(priv, off + cur)->prev_size = cur;
+        }
+        persist_hdr(priv)->allocated += next_size;
+    }
+    if (off && cur >= need) {
+        persist_trim(priv, off, cur, need);
+        in_place = true;
+    }
+    persist_unlock(priv);
+
+    if (!off) {
+        log_err("Pointer %p was not allocated from persistent heap.", ptr);
+        errno = EINVAL;
+        return NULL;
+    }
+    if (in_place) {
+        return ptr;
+    }
+    void *new_ptr = memkind_pmem_persistent_malloc(kind, size);
+    if (new_ptr) {
+        memkind_memcpy(kind, new_ptr, ptr, cur - PERSIST_TAG_SIZE);
+        memkind_pmem_persistent_free(kind, ptr);
+    }
+    return new_ptr;
+}
+
+MEMKIND_EXPORT size_t
+memkind_pmem_persistent_malloc_usable_size(struct memkind *kind, void *ptr)
+{
+    struct memkind_pmem_persistent *priv = kind->priv;
+    uint64_t off = ptr ? persist_offset(priv, ptr) : 0;
+
+    if (!off) {
+        return 0;
+    }
+    return (persist_blk(priv, off)->size & ~PERSIST_USED) - PERSIST_TAG_SIZE;
+}
+
+MEMKIND_EXPORT int memkind_pmem_persistent_get_stat(struct memkind *kind,
+                                                    memkind_stat_type stat,
+                                                    size_t *value)
+{
+    struct memkind_pmem_persistent *priv = kind->priv;
+
+    switch (stat) {
+        case MEMKIND_STAT_TYPE_RESIDENT:
+            // whole file is allocated when the heap is created
+            *value = priv->size;
+            break;
+        case MEMKIND_STAT_TYPE_ACTIVE:
+        case MEMKIND_STAT_TYPE_ALLOCATED:
+            *value = __atomic_load_n(&persist_hdr(priv)->allocated,
+                                     __ATOMIC_RELAXED);
+            break;
+        default:
+            log_err("Unrecognized type of memory statistic %d", stat);
+            return MEMKIND_ERROR_INVALID;
+    }
+    return MEMKIND_SUCCESS;
+}
+
+MEMKIND_EXPORT void *
+memkind_pmem_persistent_defrag_reallocate(struct memkind *kind, void *ptr)
+{
+    // objects are never moved, pointers to them may be stored in the heap
+    return NULL;
+}
+
+void *memkind_pmem_persistent_get_root(struct memkind *kind)
+{
+    struct memkind_pmem_persistent *priv = kind->priv;
+    uint64_t root = persist_hdr(priv)->root;
+
+    return root ? priv->base + root : NULL;
+}
+
+int memkind_pmem_persistent_set_root(struct memkind *kind, void *ptr)
+{
+    struct memkind_pmem_persistent *priv = kind->priv;
+    uint64_t root = 0;
+
+    if (ptr) {
+        root = persist_offset(priv, ptr);
+        if (!root) {
+            log_err("Root object %p was not allocated from persistent heap.",
+                    ptr);
+            return MEMKIND_ERROR_INVALID;
+        }
+        root += PERSIST_TAG_SIZE;
+    }
+    persist_hdr(priv)->root = root;
+    return MEMKIND_SUCCESS;
+}
+
+size_t memkind_pmem_persistent_offset(struct memkind *kind, const void *ptr)
+{
+    struct memkind_pmem_persistent *priv = kind->priv;
+    uintptr_t p = (uintptr_t)ptr;
+    uintptr_t base = (uintptr_t)priv->base;
+
+    if (p < base + PERSIST_HDR_SIZE || p >= base + priv->size) {
+        return 0;
+    }
+    return p - base;
+}
+
+void *memkind_pmem_persistent_ptr(struct memkind *kind, size_t offset)
+{
+    struct memkind_pmem_persistent *priv = kind->priv;
+
+    if (offset < PERSIST_HDR_SIZE || offset >= priv->size) {
+        return NULL;
+    }
+    return priv->base + offset;
+}
@@ -0,0 +1,192 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/* Copyright (C) 2022 Intel Corporation. */
+
+#include <memkind/internal/memkind_arena.h>
+#include <memkind/internal/memkind_log.h>
+#include <memkind/internal/memkind_private.h>
+#include <memkind/internal/memkind_spill.h>
+
+#include <errno.h>
+#include <numaif.h>
+#include <time.h>
+
+extern void memtier_reset_size(unsigned id);
+
+// MPOL_PREFERRED_MANY is replaced with MPOL_PREFERRED on kernels older
+// than 5.15, which then prefer the first node of the set
+static int preferred_mode = MPOL_PREFERRED_MANY;
+
+MEMKIND_EXPORT struct memkind_ops MEMKIND_SPILL_OPS = {
+    .create = memkind_spill_create,
+    .destroy = memkind_spill_destroy,
+    .malloc = memkind_arena_malloc,
+    .calloc = memkind_arena_calloc,
+    .posix_memalign = memkind_arena_posix_memalign,
+    .realloc = memkind_arena_realloc,
+    .free = memkind_arena_free,
+    .mbind = memkind_spill_mbind,
+    .get_mmap_flags = memkind_default_get_mmap_flags,
+    .get_mbind_mode = memkind_spill_get_mbind_mode,
+    .get_mbind_nodemask = memkind_spill_get_mbind_nodemask,
+    .get_arena = memkind_thread_get_arena,
+    .malloc_usable_size = memkind_default_malloc_usable_size,
+    .finalize = memkind_spill_destroy,
+    .update_memory_usage_policy = memkind_arena_update_memory_usage_policy,
+    .get_stat = memkind_arena_get_kind_stat,
+    .defrag_reallocate = memkind_arena_defrag_reallocate,
+};
+
+MEMKIND_EXPORT int memkind_spill_create(struct memkind *kind,
+                                        struct memkind_ops *ops,
+                                        const char *name)
+{
+    struct memkind_spill *priv;
+
+    priv = (struct memkind_spill *)jemk_calloc(1, sizeof(struct memkind_spill));
+    if (!priv) {
+        log_err("calloc() failed.");
+        return MEMKIND_ERROR_MALLOC;
+    }
+    priv->preferred = numa_allocate_nodemask();
+    priv->fallback = numa_allocate_nodemask();
+    priv->watermark = 100;
+
+    // nodes and watermark are set by the caller before the first allocation
+    int err = memkind_arena_create(kind, ops, name);
+    if (err) {
+        numa_bitmask_free(priv->fallback);
+        numa_bitmask_free(priv->preferred);
+        jemk_free(priv);
+        return err;
+    }
+    kind->use_tcache = true;
+    kind->priv = priv;
+    return MEMKIND_SUCCESS;
+}
+
+MEMKIND_EXPORT int memkind_spill_destroy(struct memkind *kind)
+{
+    struct memkind_spill *priv = kind->priv;
+
+    memkind_arena_destroy(kind);
+    memtier_reset_size(kind->partition);
+    numa_bitmask_free(priv->fallback);
+    numa_bitmask_free(priv->preferred);
+    jemk_free(priv);
+
+    return MEMKIND_SUCCESS;
+}
+
+MEMKIND_EXPORT int memkind_nodes_occupancy(const struct bitmask *nodemask,
+                                           unsigned *occupancy)
+{
+    unsigned long long total = 0, used = 0;
+    unsigned i;
+
+    for (i = 0; i < nodemask->size; ++i) {
+        if (!numa_bitmask_isbitset(nodemask, i)) {
+            continue;
+        }
+        long long node_free;
+        long long node_size = numa_node_size64(i, &node_free);
+        if (node_size == -1) {
+            log_err("numa_node_size64() failed");
+            return MEMKIND_ERROR_OPERATION_FAILED;
+        }
+        total += node_size;
+        used += node_size - node_free;
+    }
+    if (total == 0) {
+        return MEMKIND_ERROR_INVALID;
+    }
+    *occupancy = used * 100 / total;
+    return MEMKIND_SUCCESS;
+}
+
+// Measures occupancy of preferred nodes when the last measurement is older
+// than MEMKIND_SPILL_CHECK_INTERVAL_NS and updates spilling state, only one
+// of concurrent callers reads node statistics.
+static void spill_update(struct memkind_spill *priv)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+    unsigned long long now =
+        (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+    unsigned long long checked =
+        __atomic_load_n(&priv->checked_ns, __ATOMIC_RELAXED);
+
+    if (checked && now - checked < MEMKIND_SPILL_CHECK_INTERVAL_NS) {
+        return;
+    }
+    if (!__atomic_compare_exchange_n(&priv->checked_ns, &checked, now, false,
+                                     __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        return;
+    }
+
+    unsigned occupancy;
+    if (memkind_nodes_occupancy(priv->preferred, &occupancy)) {
+        return;
+    }
+    __atomic_store_n(&priv->occupancy, occupancy, __ATOMIC_RELAXED);
+
+    bool spilling = __atomic_load_n(&priv->spilling, __ATOMIC_RELAXED);
+    if (!spilling && occupancy >= priv->watermark) {
+        log_info("Occupancy %u%% of preferred nodes, spilling to fallback.",
+                 occupancy);
+        __atomic_store_n(&priv->spilling, true, __ATOMIC_RELAXED);
+    } else if (spilling &&
+               occupancy + MEMKIND_SPILL_HYSTERESIS < priv->watermark) {
+        log_info("Occupancy %u%% of preferred nodes, filling them again.",
+                 occupancy);
+        __atomic_store_n(&priv->spilling, false, __ATOMIC_RELAXED);
+    }
+}
+
+MEMKIND_EXPORT int memkind_spill_mbind(struct memkind *kind, void *ptr,
+                                       size_t size)
+{
+    struct memkind_spill *priv = kind->priv;
+
+    spill_update(priv);
+    // nodes are preferred in both states, so kernel can still fall back
+    // when fallback nodes get full as well
+    struct bitmask *nodes = __atomic_load_n(&priv->spilling, __ATOMIC_RELAXED)
+        ? priv->fallback
+        : priv->preferred;
+    int mode = __atomic_load_n(&preferred_mode, __ATOMIC_RELAXED);
+    int err = mbind(ptr, size, mode, nodes->maskp, nodes->size + 1, 0);
+    if (err && errno == EINVAL && mode == MPOL_PREFERRED_MANY) {
+        __atomic_store_n(&preferred_mode, MPOL_PREFERRED, __ATOMIC_RELAXED);
+        err = mbind(ptr, size, MPOL_PREFERRED, nodes->maskp, nodes->size + 1,
+                    0);
+    }
+    if (MEMKIND_UNLIKELY(err)) {
+        log_err("syscall mbind() returned: %d", err);
+        return MEMKIND_ERROR_MBIND;
+    }
+    return MEMKIND_SUCCESS;
+}
+
+MEMKIND_EXPORT int memkind_spill_get_mbind_nodemask(struct memkind *kind,
+                                                    unsigned long *nodemask,
+                                                    unsigned long maxnode)
+{
+    struct memkind_spill *priv = kind->priv;
+    struct bitmask nodemask_bm = {maxnode, nodemask};
+    unsigned i;
+
+    numa_bitmask_clearall(&nodemask_bm);
+    for (i = 0; i < priv->preferred->size && i < maxnode; ++i) {
+        if (numa_bitmask_isbitset(priv->preferred, i) ||
+            numa_bitmask_isbitset(priv->fallback, i)) {
+            numa_bitmask_setbit(&nodemask_bm, i);
+        }
+    }
+    return MEMKIND_SUCCESS;
+}
+
+MEMKIND_EXPORT int memkind_spill_get_mbind_mode(struct memkind *kind, int *mode)
+{
+    *mode = __atomic_load_n(&preferred_mode, __ATOMIC_RELAXED);
+    return MEMKIND_SUCCESS;
+}
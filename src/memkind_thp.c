@@ -0,0 +1,79 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/* Copyright (C) 2022 Intel Corporation. */
+
+#include <memkind/internal/memkind_arena.h>
+#include <memkind/internal/memkind_default.h>
+#include <memkind/internal/memkind_log.h>
+#include <memkind/internal/memkind_private.h>
+#include <memkind/internal/memkind_thp.h>
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#define THP_ENABLED_PATH "/sys/kernel/mm/transparent_hugepage/enabled"
+
+static int thp_available_err = MEMKIND_ERROR_UNAVAILABLE;
+static pthread_once_t thp_available_once = PTHREAD_ONCE_INIT;
+
+MEMKIND_EXPORT struct memkind_ops MEMKIND_DEFAULT_THP_OPS = {
+    .create = memkind_arena_create,
+    .destroy = memkind_default_destroy,
+    .malloc = memkind_arena_malloc,
+    .calloc = memkind_arena_calloc,
+    .posix_memalign = memkind_arena_posix_memalign,
+    .realloc = memkind_arena_realloc,
+    .free = memkind_arena_free,
+    .check_available = memkind_thp_check_available,
+    .mbind = memkind_default_mbind,
+    .madvise = memkind_thp_madvise,
+    .get_mmap_flags = memkind_default_get_mmap_flags,
+    .get_mbind_mode = memkind_default_get_mbind_mode,
+    .get_mbind_nodemask = memkind_default_get_mbind_nodemask,
+    .get_arena = memkind_thread_get_arena,
+    .init_once = memkind_default_thp_init_once,
+    .malloc_usable_size = memkind_default_malloc_usable_size,
+    .finalize = memkind_arena_finalize,
+    .get_stat = memkind_arena_get_kind_stat,
+    .defrag_reallocate = memkind_arena_defrag_reallocate,
+};
+
+// THP are usable unless disabled system-wide ("never" mode)
+static void thp_available_init(void)
+{
+    char buf[128] = {0};
+    FILE *f = fopen(THP_ENABLED_PATH, "r");
+    if (!f) {
+        log_info("Transparent huge pages are not supported by kernel.");
+        return;
+    }
+    if (fgets(buf, sizeof(buf), f) && !strstr(buf, "[never]")) {
+        thp_available_err = MEMKIND_SUCCESS;
+    } else {
+        log_info("Transparent huge pages are disabled.");
+    }
+    fclose(f);
+}
+
+MEMKIND_EXPORT int memkind_thp_check_available(struct memkind *kind)
+{
+    pthread_once(&thp_available_once, thp_available_init);
+    return thp_available_err;
+}
+
+MEMKIND_EXPORT int memkind_thp_madvise(struct memkind *kind, void *addr,
+                                       size_t size)
+{
+    int err = madvise(addr, size, MADV_HUGEPAGE);
+    if (MEMKIND_UNLIKELY(err)) {
+        log_err("syscall madvise() returned: %d", errno);
+    }
+    return err;
+}
+
+MEMKIND_EXPORT void memkind_default_thp_init_once(void)
+{
+    memkind_init(MEMKIND_DEFAULT_THP, true);
+}
@@ -0,0 +1,355 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/* Copyright (C) 2022 Intel Corporation. */
+
+#include <memkind/internal/memkind_dax_kmem.h>
+#include <memkind/internal/memkind_hbw.h>
+#include <memkind/internal/memkind_log.h>
+#include <memkind/internal/memkind_mem_attributes.h>
+#include <memkind/internal/memkind_topology.h>
+
+#include "config.h"
+#include <errno.h>
+#include <limits.h>
+#include <numa.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef MEMKIND_RSEQ_SUPPORT
+#include <sys/rseq.h>
+#endif
+
+#define BITS_PER_LONG (8 * sizeof(unsigned long))
+#define BITS_TO_LONGS(bits) (((bits) + BITS_PER_LONG - 1) / BITS_PER_LONG)
+
+// CPU to node map and node distances, shared by all attributes
+struct topology_base_t {
+    int err;
+    int num_nodes;
+    unsigned num_cpus;
+    int *cpu_node;
+    int *distance;
+};
+
+static struct topology_base_t base_g;
+static pthread_once_t base_once_g = PTHREAD_ONCE_INIT;
+
+static struct memkind_topology_nodes nodes_g[TOPOLOGY_ATTR_MAX];
+static pthread_once_t nodes_once_g[TOPOLOGY_ATTR_MAX] = {PTHREAD_ONCE_INIT};
+
+static void base_init_once(void)
+{
+    struct topology_base_t *b = &base_g;
+    int num_nodes = numa_max_node() + 1;
+    unsigned num_cpus = numa_num_configured_cpus();
+    int node, dest;
+    unsigned cpu;
+
+    struct bitmask *node_cpus = numa_allocate_cpumask();
+    b->cpu_node = malloc(num_cpus * sizeof(int));
+    b->distance = malloc(num_nodes * num_nodes * sizeof(int));
+    if (MEMKIND_UNLIKELY(!node_cpus || !b->cpu_node || !b->distance)) {
+        log_err("malloc() failed.");
+        b->err = MEMKIND_ERROR_MALLOC;
+        goto exit;
+    }
+
+    for (cpu = 0; cpu < num_cpus; ++cpu) {
+        b->cpu_node[cpu] = -1;
+    }
+
+    int old_errno = errno;
+    for (node = 0; node < num_nodes; ++node) {
+        for (dest = 0; dest < num_nodes; ++dest) {
+            b->distance[node * num_nodes + dest] = numa_distance(node, dest);
+        }
+        // skip missing node and node which could not be a initiator
+        if (numa_node_to_cpus(node, node_cpus) != 0) {
+            continue;
+        }
+        for (cpu = 0; cpu < num_cpus; ++cpu) {
+            if (numa_bitmask_isbitset(node_cpus, cpu)) {
+                b->cpu_node[cpu] = node;
+            }
+        }
+    }
+    errno = old_errno;
+
+    b->num_nodes = num_nodes;
+    b->num_cpus = num_cpus;
+
+exit:
+    if (node_cpus) {
+        numa_bitmask_free(node_cpus);
+    }
+    if (b->err) {
+        free(b->cpu_node);
+        free(b->distance);
+    }
+}
+
+// Nodes of the attribute for one initiator node
+static int get_dest_nodes(memkind_topology_attr_t attr, int init_node,
+                          const struct bitmask *dest_mask,
+                          struct bitmask *nodes)
+{
+    switch (attr) {
+        case TOPOLOGY_LOCAL_CAPACITY:
+            return get_mem_attr_local_nodes(init_node, MEM_ATTR_CAPACITY,
+                                            nodes);
+        case TOPOLOGY_LOCAL_LATENCY:
+            return get_mem_attr_local_nodes(init_node, MEM_ATTR_LATENCY,
+                                            nodes);
+        case TOPOLOGY_LOCAL_BANDWIDTH:
+            return get_mem_attr_local_nodes(init_node, MEM_ATTR_BANDWIDTH,
+                                            nodes);
+        default:
+            if (!dest_mask) {
+                return get_mem_attr_hbw_nodes(init_node, nodes);
+            }
+            copy_bitmask_to_bitmask((struct bitmask *)dest_mask, nodes);
+            return MEMKIND_SUCCESS;
+    }
+}
+
+static void keep_closest_nodes(const struct topology_base_t *b, int init_node,
+                               struct bitmask *nodes)
+{
+    const int *distance = &b->distance[init_node * b->num_nodes];
+    int min_distance = INT_MAX;
+    int node;
+
+    for (node = 0; node < b->num_nodes; ++node) {
+        if (numa_bitmask_isbitset(nodes, node) &&
+            distance[node] < min_distance) {
+            min_distance = distance[node];
+        }
+    }
+    for (node = 0; node < b->num_nodes; ++node) {
+        if (numa_bitmask_isbitset(nodes, node) &&
+            distance[node] != min_distance) {
+            numa_bitmask_clearbit(nodes, node);
+        }
+    }
+}
+
+static void nodes_init(memkind_topology_attr_t attr)
+{
+    struct memkind_topology_nodes *t = &nodes_g[attr];
+    const struct topology_base_t *b = &base_g;
+    struct memkind_topology_range *node_range = NULL;
+    struct bitmask *dest_mask = NULL;
+    struct bitmask *nodes = NULL;
+    unsigned num = 0;
+    unsigned cpu;
+    int node, dest;
+
+    pthread_once(&base_once_g, base_init_once);
+    if (MEMKIND_UNLIKELY(b->err)) {
+        t->err = b->err;
+        return;
+    }
+
+    switch (attr) {
+        case TOPOLOGY_HBW_CLOSEST:
+        case TOPOLOGY_HBW_ALL:
+            // without explicit HBW nodes ask HMAT per initiator node
+            if (!memkind_hbw_hmat_supported()) {
+                t->err = memkind_hbw_get_nodemask(&dest_mask);
+            }
+            break;
+        case TOPOLOGY_DAX_KMEM_CLOSEST:
+        case TOPOLOGY_DAX_KMEM_ALL:
+            t->err = memkind_dax_kmem_get_nodemask(&dest_mask);
+            break;
+        default:
+            break;
+    }
+    if (t->err) {
+        return;
+    }
+
+    nodes = numa_bitmask_alloc(b->num_nodes);
+    node_range = calloc(b->num_nodes, sizeof(*node_range));
+    t->cpus = calloc(b->num_cpus, sizeof(*t->cpus));
+    t->nodes = malloc(b->num_nodes * b->num_nodes * sizeof(int));
+    if (MEMKIND_UNLIKELY(!nodes || !node_range || !t->cpus || !t->nodes)) {
+        log_err("malloc() failed.");
+        t->err = MEMKIND_ERROR_MALLOC;
+        goto exit;
+    }
+
+    t->single = true;
+    t->multi_node = -1;
+    for (cpu = 0; cpu < b->num_cpus; ++cpu) {
+        node = b->cpu_node[cpu];
+        if (node < 0 || node_range[node].num) {
+            continue;
+        }
+
+        numa_bitmask_clearall(nodes);
+        t->err = get_dest_nodes(attr, node, dest_mask, nodes);
+        if (t->err) {
+            goto exit;
+        }
+        if (attr == TOPOLOGY_HBW_CLOSEST || attr == TOPOLOGY_DAX_KMEM_CLOSEST) {
+            keep_closest_nodes(b, node, nodes);
+        }
+
+        node_range[node].first = num;
+        for (dest = 0; dest < b->num_nodes; ++dest) {
+            if (numa_bitmask_isbitset(nodes, dest)) {
+                t->nodes[num++] = dest;
+            }
+        }
+        node_range[node].num = num - node_range[node].first;
+        if (node_range[node].num == 0) {
+            log_err("No destination Nodes for init node %d.", node);
+            t->err = MEMKIND_ERROR_MEMTYPE_NOT_AVAILABLE;
+            goto exit;
+        }
+        if (node_range[node].num > 1 && t->single) {
+            t->single = false;
+            t->multi_node = node;
+        }
+    }
+
+    // precompute nodemask words, so binding is a copy from the CPU row
+    t->mask_words = BITS_TO_LONGS(b->num_nodes);
+    t->masks = calloc(b->num_cpus * t->mask_words, sizeof(unsigned long));
+    if (MEMKIND_UNLIKELY(!t->masks)) {
+        log_err("calloc() failed.");
+        t->err = MEMKIND_ERROR_MALLOC;
+        goto exit;
+    }
+
+    for (cpu = 0; cpu < b->num_cpus; ++cpu) {
+        if (b->cpu_node[cpu] < 0) {
+            continue;
+        }
+        t->cpus[cpu] = node_range[b->cpu_node[cpu]];
+        unsigned long *mask = &t->masks[cpu * t->mask_words];
+        unsigned i;
+        for (i = 0; i < t->cpus[cpu].num; ++i) {
+            dest = t->nodes[t->cpus[cpu].first + i];
+            mask[dest / BITS_PER_LONG] |= 1UL << (dest % BITS_PER_LONG);
+        }
+    }
+    t->num_cpus = b->num_cpus;
+
+exit:
+    if (t->err) {
+        free(t->cpus);
+        free(t->nodes);
+        free(t->masks);
+        t->cpus = NULL;
+        t->nodes = NULL;
+        t->masks = NULL;
+    }
+    free(node_range);
+    if (nodes) {
+        numa_bitmask_free(nodes);
+    }
+    if (dest_mask) {
+        numa_bitmask_free(dest_mask);
+    }
+}
+
+static void local_capacity_init_once(void)
+{
+    nodes_init(TOPOLOGY_LOCAL_CAPACITY);
+}
+
+static void local_latency_init_once(void)
+{
+    nodes_init(TOPOLOGY_LOCAL_LATENCY);
+}
+
+static void local_bandwidth_init_once(void)
+{
+    nodes_init(TOPOLOGY_LOCAL_BANDWIDTH);
+}
+
+static void hbw_closest_init_once(void)
+{
+    nodes_init(TOPOLOGY_HBW_CLOSEST);
+}
+
+static void hbw_all_init_once(void)
+{
+    nodes_init(TOPOLOGY_HBW_ALL);
+}
+
+static void dax_kmem_closest_init_once(void)
+{
+    nodes_init(TOPOLOGY_DAX_KMEM_CLOSEST);
+}
+
+static void dax_kmem_all_init_once(void)
+{
+    nodes_init(TOPOLOGY_DAX_KMEM_ALL);
+}
+
+static void (*const nodes_init_once_g[TOPOLOGY_ATTR_MAX])(void) = {
+    [TOPOLOGY_LOCAL_CAPACITY] = local_capacity_init_once,
+    [TOPOLOGY_LOCAL_LATENCY] = local_latency_init_once,
+    [TOPOLOGY_LOCAL_BANDWIDTH] = local_bandwidth_init_once,
+    [TOPOLOGY_HBW_CLOSEST] = hbw_closest_init_once,
+    [TOPOLOGY_HBW_ALL] = hbw_all_init_once,
+    [TOPOLOGY_DAX_KMEM_CLOSEST] = dax_kmem_closest_init_once,
+    [TOPOLOGY_DAX_KMEM_ALL] = dax_kmem_all_init_once,
+};
+
+// CPU of the calling thread, read from the rseq area which glibc registers
+// for each thread, sched_getcpu() (vDSO getcpu) is used without rseq
+static inline unsigned get_current_cpu(void)
+{
+#ifdef MEMKIND_RSEQ_SUPPORT
+    if (MEMKIND_LIKELY(__rseq_size)) {
+        const struct rseq *rs =
+            (const struct rseq *)((char *)__builtin_thread_pointer() +
+                                  __rseq_offset);
+        int cpu = (int)__atomic_load_n(&rs->cpu_id, __ATOMIC_RELAXED);
+        if (MEMKIND_LIKELY(cpu >= 0)) {
+            return cpu;
+        }
+    }
+#endif
+    return sched_getcpu();
+}
+
+MEMKIND_EXPORT const struct memkind_topology_nodes *
+memkind_topology_get(memkind_topology_attr_t attr)
+{
+    pthread_once(&nodes_once_g[attr], nodes_init_once_g[attr]);
+    return &nodes_g[attr];
+}
+
+MEMKIND_EXPORT int memkind_topology_set_nodemask(
+    memkind_topology_attr_t attr, memkind_node_variant_t node_variant,
+    unsigned long *nodemask, unsigned long maxnode)
+{
+    const struct memkind_topology_nodes *t = memkind_topology_get(attr);
+    if (MEMKIND_UNLIKELY(t->err)) {
+        return t->err;
+    }
+
+    // validate single NUMA Node condition
+    if (node_variant == NODE_VARIANT_SINGLE && !t->single) {
+        log_err("Invalid Numa Configuration for Node %d", t->multi_node);
+        return MEMKIND_ERROR_RUNTIME;
+    }
+
+    if (MEMKIND_LIKELY(nodemask)) {
+        unsigned long words = BITS_TO_LONGS(maxnode);
+        unsigned long copy = 0;
+        unsigned cpu = get_current_cpu();
+        if (MEMKIND_LIKELY(cpu < t->num_cpus)) {
+            copy = words < t->mask_words ? words : t->mask_words;
+            memcpy(nodemask, &t->masks[cpu * t->mask_words],
+                   copy * sizeof(unsigned long));
+        }
+        memset(nodemask + copy, 0, (words - copy) * sizeof(unsigned long));
+    }
+    return MEMKIND_SUCCESS;
+}
@@ -16,6 +16,7 @@ check_PROGRAMS += test/all_tests \
                   test/freeing_memory_segfault_test \
                   test/locality_test \
                   test/memkind_stat_test \
+                  test/memtier_init_perf_test_helper \
                   test/performance_test \
                   test/stats_print_test_helper \
                   test/trace_mechanism_test_helper \
@@ -28,7 +29,8 @@ check_PROGRAMS += test/pmem_test \
                   test/defrag_reallocate \
                   test/get_capacity_test \
                   test/memkind_memtier_dax_kmem_test \
-                  test/memkind_memtier_test
+                  test/memkind_memtier_test \
+                  test/memtier_init_perf_test
 endif
 
 TESTS += test/test.sh
@@ -68,7 +70,7 @@ test_stats_print_test_helper_LDADD = libmemkind.la
 test_trace_mechanism_test_helper_LDADD = libmemkind.la
 
 if HAVE_CXX11
-test_pmem_test_SOURCES = $(fused_gtest) test/memkind_pmem_config_tests.cpp test/memkind_pmem_long_time_tests.cpp test/memkind_pmem_tests.cpp
+test_pmem_test_SOURCES = $(fused_gtest) test/memkind_pmem_config_tests.cpp test/memkind_pmem_long_time_tests.cpp test/memkind_pmem_persistent_tests.cpp test/memkind_pmem_tests.cpp
 test_pmem_test_LDADD = libmemkind.la
 test_memkind_highcapacity_test_SOURCES = $(fused_gtest) test/memkind_highcapacity_tests.cpp
 test_memkind_highcapacity_test_LDADD = libmemkind.la
@@ -86,6 +88,8 @@ test_memkind_memtier_dax_kmem_test_SOURCES = $(fused_gtest) test/memkind_memtier
 test_memkind_memtier_dax_kmem_test_LDADD = libmemkind.la
 test_memkind_memtier_test_SOURCES = $(fused_gtest) test/memkind_memtier_test.cpp
 test_memkind_memtier_test_LDADD = libmemkind.la
+test_memtier_init_perf_test_SOURCES = $(fused_gtest) test/memtier_init_perf_test.cpp
+test_memtier_init_perf_test_LDADD = libmemkind.la
 test_get_capacity_test_SOURCES = $(fused_gtest) test/get_capacity_test.cpp
 test_get_capacity_test_LDADD = libmemkind.la
 endif
@@ -108,7 +112,10 @@ test_all_tests_SOURCES = $(fused_gtest) \
                          test/hbw_verify_function_test.cpp \
                          test/memkind_allocator_tests.cpp \
                          test/memkind_detect_kind_tests.cpp \
+                         test/memkind_nodemask_tests.cpp \
                          test/memkind_null_kind_test.cpp \
+                         test/memkind_shared_tests.cpp \
+                         test/memkind_topology_tests.cpp \
                          test/memkind_versioning_tests.cpp \
                          test/multithreaded_tests.cpp \
                          test/negative_tests.cpp \
@@ -144,6 +151,7 @@ test_environ_err_dax_kmem_malloc_positive_test_SOURCES = test/environ_err_dax_km
 test_environ_max_bg_threads_test_SOURCES = test/environ_max_bg_threads_test.cpp
 test_freeing_memory_segfault_test_SOURCES = $(fused_gtest) test/freeing_memory_segfault_test.cpp
 test_memkind_stat_test_SOURCES = $(fused_gtest) test/memkind_stat_test.cpp
+test_memtier_init_perf_test_helper_SOURCES = test/memtier_init_perf_test_helper.c
 test_stats_print_test_helper_SOURCES = test/stats_print_test_helper.c
 test_trace_mechanism_test_helper_SOURCES = test/trace_mechanism_test_helper.c
 
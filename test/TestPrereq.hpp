@@ -120,7 +120,8 @@ private:
         return (kind == MEMKIND_HBW || kind == MEMKIND_HBW_ALL ||
                 kind == MEMKIND_HBW_INTERLEAVE ||
                 kind == MEMKIND_HBW_PREFERRED ||
-                kind == MEMKIND_HBW_PREFERRED_HUGETLB);
+                kind == MEMKIND_HBW_PREFERRED_HUGETLB ||
+                kind == MEMKIND_HBW_THP);
     }
 
 public:
@@ -332,6 +333,12 @@ public:
              MEMKIND_HIGHEST_BANDWIDTH_LOCAL},
             {"MEMKIND_HIGHEST_BANDWIDTH_LOCAL_PREFERRED",
              MEMKIND_HIGHEST_BANDWIDTH_LOCAL_PREFERRED},
+            {"MEMKIND_DEFAULT_THP", MEMKIND_DEFAULT_THP},
+            {"MEMKIND_HBW_THP", MEMKIND_HBW_THP},
+            {"MEMKIND_DAX_KMEM_THP", MEMKIND_DAX_KMEM_THP},
+            {"MEMKIND_HUGETLB_1GB", MEMKIND_HUGETLB_1GB},
+            {"MEMKIND_HBW_HUGETLB_1GB", MEMKIND_HBW_HUGETLB_1GB},
+            {"MEMKIND_DAX_KMEM_HUGETLB_1GB", MEMKIND_DAX_KMEM_HUGETLB_1GB},
         };
         return kind_translate.at(kind_name);
     }
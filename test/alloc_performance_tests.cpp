@@ -5,7 +5,12 @@
 #include "allocator_perf_tool/Stats.hpp"
 #include "allocator_perf_tool/TaskFactory.hpp"
 #include "allocator_perf_tool/Thread.hpp"
+#include "allocator_perf_tool/TimerSysTime.hpp"
 #include "common.h"
+#include <algorithm>
+#include <numa.h>
+#include <numaif.h>
+#include <sched.h>
 
 class AllocPerformanceTest: public ::testing::Test
 {
@@ -1658,3 +1663,87 @@ TEST_F(AllocPerformanceTest,
     run_test(AllocatorTypes::MEMKIND_HBW_PREFERRED, FunctionCalls::REALLOC, 72,
              1572864, 10000);
 }
+
+// Fills the node of the current CPU beyond its free memory with 2 MB blocks
+// and compares latency of allocation and first touch of a block for kind
+// which prefers the node and relies on kernel fallback and kind which spills
+// to other nodes at the occupancy watermark.
+class SpillPerformanceTest: public ::testing::Test
+{
+protected:
+    const size_t block_size = 2 * MB;
+    struct bitmask *preferred;
+    struct bitmask *fallback;
+    size_t fill_size;
+
+    void SetUp()
+    {
+        if (numa_num_configured_nodes() < 2) {
+            GTEST_SKIP() << "Test requires at least 2 NUMA nodes." << std::endl;
+        }
+        int node = numa_node_of_cpu(sched_getcpu());
+        preferred = numa_allocate_nodemask();
+        numa_bitmask_setbit(preferred, node);
+        fallback = numa_allocate_nodemask();
+        copy_bitmask_to_bitmask(numa_all_nodes_ptr, fallback);
+        numa_bitmask_clearbit(fallback, node);
+        long long node_free;
+        long long node_size = numa_node_size64(node, &node_free);
+        fill_size = node_free + node_size / 10;
+    }
+
+    void TearDown()
+    {
+        if (numa_num_configured_nodes() >= 2) {
+            numa_bitmask_free(fallback);
+            numa_bitmask_free(preferred);
+        }
+    }
+
+    void record_latency(memkind_t kind, const std::string &name)
+    {
+        std::vector<void *> blocks;
+        std::vector<double> latency;
+        TimerSysTime timer;
+
+        for (size_t filled = 0; filled < fill_size; filled += block_size) {
+            timer.start();
+            void *ptr = memkind_malloc(kind, block_size);
+            ASSERT_NE(nullptr, ptr);
+            memset(ptr, 0, block_size);
+            latency.push_back(timer.getElapsedTime());
+            blocks.push_back(ptr);
+        }
+        unsigned occupancy = 0;
+        ASSERT_EQ(MEMKIND_SUCCESS, memkind_get_occupancy(kind, &occupancy));
+        for (auto const &ptr : blocks) {
+            memkind_free(kind, ptr);
+        }
+
+        std::sort(latency.begin(), latency.end());
+        size_t n = latency.size();
+        GTestAdapter::RecordProperty(name + "_p50_latency", latency[n / 2]);
+        GTestAdapter::RecordProperty(name + "_p99_latency",
+                                     latency[n * 99 / 100]);
+        GTestAdapter::RecordProperty(name + "_p999_latency",
+                                     latency[n * 999 / 1000]);
+        GTestAdapter::RecordProperty(name + "_max_latency", latency[n - 1]);
+        GTestAdapter::RecordProperty(name + "_occupancy_percent", occupancy);
+    }
+};
+
+TEST_F(SpillPerformanceTest,
+       test_TC_MEMKIND_spill_watermark_80_vs_preferred_tail_latency)
+{
+    memkind_t kind = nullptr;
+    ASSERT_EQ(MEMKIND_SUCCESS,
+              memkind_create_kind_nodemask(preferred, MPOL_PREFERRED,
+                                           memkind_bits_t(), &kind));
+    record_latency(kind, "preferred");
+    ASSERT_EQ(MEMKIND_SUCCESS, memkind_destroy_kind(kind));
+
+    ASSERT_EQ(MEMKIND_SUCCESS,
+              memkind_create_kind_spill(preferred, fallback, 80, &kind));
+    record_latency(kind, "spill");
+    ASSERT_EQ(MEMKIND_SUCCESS, memkind_destroy_kind(kind));
+}
@@ -69,6 +69,18 @@ static const char *kind_name(memkind_t kind)
         return "MEMKIND_HIGHEST_BANDWIDTH_LOCAL";
     else if (kind == MEMKIND_HIGHEST_BANDWIDTH_LOCAL_PREFERRED)
         return "MEMKIND_HIGHEST_BANDWIDTH_LOCAL_PREFERRED";
+    else if (kind == MEMKIND_DEFAULT_THP)
+        return "MEMKIND_DEFAULT_THP";
+    else if (kind == MEMKIND_HBW_THP)
+        return "MEMKIND_HBW_THP";
+    else if (kind == MEMKIND_DAX_KMEM_THP)
+        return "MEMKIND_DAX_KMEM_THP";
+    else if (kind == MEMKIND_HUGETLB_1GB)
+        return "MEMKIND_HUGETLB_1GB";
+    else if (kind == MEMKIND_HBW_HUGETLB_1GB)
+        return "MEMKIND_HBW_HUGETLB_1GB";
+    else if (kind == MEMKIND_DAX_KMEM_HUGETLB_1GB)
+        return "MEMKIND_DAX_KMEM_HUGETLB_1GB";
     else
         return "Unknown memory kind";
 }
@@ -4,7 +4,14 @@
 #include <memkind/internal/memkind_arena.h>
 
 #include <algorithm>
+#include <chrono>
+#include <fstream>
 #include <gtest/gtest.h>
+#include <numaif.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <thread>
 #include <vector>
 #ifdef _OPENMP
 #include <omp.h>
@@ -27,6 +34,70 @@ bool uint_comp(unsigned int a, unsigned int b)
     return (a < b);
 }
 
+// Returns permissions of mapping which starts at addr.
+static std::string mapping_perms(uintptr_t addr)
+{
+    std::ifstream maps("/proc/self/maps");
+    std::string line;
+    while (std::getline(maps, line)) {
+        uintptr_t start = std::stoull(line.substr(0, line.find('-')), nullptr,
+                                      16);
+        if (start == addr) {
+            return line.substr(line.find(' ') + 1, 4);
+        }
+    }
+    return "";
+}
+
+// Returns end of mapping which contains addr.
+static uintptr_t mapping_end(uintptr_t addr)
+{
+    std::ifstream maps("/proc/self/maps");
+    std::string line;
+    while (std::getline(maps, line)) {
+        size_t sep = line.find('-');
+        uintptr_t start = std::stoull(line.substr(0, sep), nullptr, 16);
+        uintptr_t end = std::stoull(line.substr(sep + 1), nullptr, 16);
+        if (addr >= start && addr < end) {
+            return end;
+        }
+    }
+    return 0;
+}
+
+// Returns true if all pages of range are resident in memory.
+static bool range_resident(void *addr, size_t size)
+{
+    const uintptr_t page_size = sysconf(_SC_PAGESIZE);
+    uintptr_t start = (uintptr_t)addr & ~(page_size - 1);
+    size += (uintptr_t)addr - start;
+    std::vector<unsigned char> vec((size + page_size - 1) / page_size);
+    if (mincore((void *)start, size, vec.data())) {
+        return false;
+    }
+    return std::all_of(vec.begin(), vec.end(),
+                       [](unsigned char v) { return v & 1; });
+}
+
+// Returns VmFlags of mapping which contains addr.
+static std::string mapping_vmflags(uintptr_t addr)
+{
+    std::ifstream smaps("/proc/self/smaps");
+    std::string line;
+    bool found = false;
+    while (std::getline(smaps, line)) {
+        size_t sep = line.find('-');
+        if (sep != std::string::npos && line.find(' ') > sep) {
+            uintptr_t start = std::stoull(line.substr(0, sep), nullptr, 16);
+            uintptr_t end = std::stoull(line.substr(sep + 1), nullptr, 16);
+            found = (addr >= start && addr < end);
+        } else if (found && line.rfind("VmFlags:", 0) == 0) {
+            return line.substr(8) + " ";
+        }
+    }
+    return "";
+}
+
 TEST_F(GetArenaTest, test_TC_MEMKIND_ThreadHash)
 {
 #ifdef _OPENMP
@@ -70,3 +141,174 @@ TEST_F(GetArenaTest, test_TC_MEMKIND_ThreadHash)
     std::cout << "[ SKIPPED ] Feature OPENMP not supported" << std::endl;
 #endif
 }
+
+// Extents of kinds with anonymous memory are carved from reserved region,
+// which is bound once and committed on demand - committed part is followed
+// by not committed (PROT_NONE) part with the same memory policy.
+TEST_F(GetArenaTest, test_TC_MEMKIND_ExtentVAReservation)
+{
+    const size_t alloc_size = 3 * 1024 * 1024;
+    int mode = -1;
+
+    // reservation is disabled by default
+    memkind_arena_set_va_reserve_size(1ull << 30);
+    void *ptr = memkind_malloc(MEMKIND_REGULAR, alloc_size);
+    memkind_arena_set_va_reserve_size(0);
+    ASSERT_NE(nullptr, ptr);
+    memset(ptr, 0, alloc_size);
+    ASSERT_EQ(0, get_mempolicy(&mode, nullptr, 0, ptr, MPOL_F_ADDR));
+    EXPECT_EQ(MPOL_BIND, mode);
+
+    uintptr_t reserved = mapping_end((uintptr_t)ptr);
+    ASSERT_NE(0U, reserved);
+    EXPECT_EQ("---p", mapping_perms(reserved));
+    mode = -1;
+    ASSERT_EQ(0, get_mempolicy(&mode, nullptr, 0, (void *)reserved,
+                               MPOL_F_ADDR));
+    EXPECT_EQ(MPOL_BIND, mode);
+
+    memkind_free(MEMKIND_REGULAR, ptr);
+}
+
+// Memory of THP kind is advised with MADV_HUGEPAGE ("hg" flag of mapping) and
+// bound to nodes of the kind.
+TEST_F(GetArenaTest, test_TC_MEMKIND_ExtentTHP)
+{
+    const size_t alloc_size = 3 * 1024 * 1024;
+    memkind_t kind = nullptr;
+
+    if (memkind_check_available(MEMKIND_DEFAULT_THP)) {
+        GTEST_SKIP() << "Transparent huge pages are required." << std::endl;
+    }
+    ASSERT_EQ(MEMKIND_SUCCESS,
+              memkind_create_kind(MEMKIND_MEMTYPE_DEFAULT,
+                                  MEMKIND_POLICY_PREFERRED_LOCAL,
+                                  MEMKIND_MASK_THP, &kind));
+    ASSERT_EQ(MEMKIND_DEFAULT_THP, kind);
+
+    void *ptr = memkind_malloc(kind, alloc_size);
+    ASSERT_NE(nullptr, ptr);
+    memset(ptr, 0, alloc_size);
+    EXPECT_NE(std::string::npos, mapping_vmflags((uintptr_t)ptr).find(" hg "));
+    int mode = -1;
+    ASSERT_EQ(0, get_mempolicy(&mode, nullptr, 0, ptr, MPOL_F_ADDR));
+    EXPECT_EQ(MPOL_BIND, mode);
+
+    memkind_free(kind, ptr);
+}
+
+// With prefault pool, extents are carved from memory populated in background,
+// so freshly allocated memory is resident before it is touched.
+TEST_F(GetArenaTest, test_TC_MEMKIND_ExtentPrefaultPool)
+{
+    const size_t alloc_size = 4 * 1024 * 1024;
+    const size_t pool_size = 128 * 1024 * 1024;
+    const int max_tries = 50;
+    std::vector<void *> ptrs;
+    bool resident = false;
+
+    int err = memkind_set_prefault_pool(MEMKIND_REGULAR, pool_size,
+                                        pool_size / 2);
+    if (err == MEMKIND_ERROR_OPERATION_FAILED) {
+        GTEST_SKIP() << "MADV_POPULATE_WRITE is required." << std::endl;
+    }
+    ASSERT_EQ(MEMKIND_SUCCESS, err);
+    // pool is populated asynchronously, allocations are kept to move
+    // forward in reservation
+    for (int i = 0; i < max_tries && !resident; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        void *ptr = memkind_malloc(MEMKIND_REGULAR, alloc_size);
+        ASSERT_NE(nullptr, ptr);
+        ptrs.push_back(ptr);
+        resident = range_resident(ptr, alloc_size);
+    }
+    EXPECT_TRUE(resident);
+
+    ASSERT_EQ(MEMKIND_SUCCESS,
+              memkind_set_prefault_pool(MEMKIND_REGULAR, 0, 0));
+    for (auto ptr : ptrs) {
+        memkind_free(MEMKIND_REGULAR, ptr);
+    }
+}
+
+// Prefault pool thread is started again in child process after fork.
+TEST_F(GetArenaTest, test_TC_MEMKIND_ExtentPrefaultPoolFork)
+{
+    const size_t alloc_size = 4 * 1024 * 1024;
+    const size_t pool_size = 128 * 1024 * 1024;
+    const int max_tries = 50;
+
+    int err = memkind_set_prefault_pool(MEMKIND_REGULAR, pool_size,
+                                        pool_size / 2);
+    if (err == MEMKIND_ERROR_OPERATION_FAILED) {
+        GTEST_SKIP() << "MADV_POPULATE_WRITE is required." << std::endl;
+    }
+    ASSERT_EQ(MEMKIND_SUCCESS, err);
+
+    pid_t pid = fork();
+    ASSERT_NE(-1, pid);
+    if (pid == 0) {
+        // consume part of pool populated by parent process
+        for (size_t i = 0; i < pool_size / alloc_size; ++i) {
+            if (!memkind_malloc(MEMKIND_REGULAR, alloc_size)) {
+                _exit(2);
+            }
+        }
+        for (int i = 0; i < max_tries; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            void *ptr = memkind_malloc(MEMKIND_REGULAR, alloc_size);
+            if (!ptr) {
+                _exit(2);
+            }
+            if (range_resident(ptr, alloc_size)) {
+                _exit(0);
+            }
+        }
+        _exit(1);
+    }
+    int status;
+    ASSERT_EQ(pid, waitpid(pid, &status, 0));
+    EXPECT_TRUE(WIFEXITED(status));
+    EXPECT_EQ(0, WEXITSTATUS(status));
+
+    ASSERT_EQ(MEMKIND_SUCCESS,
+              memkind_set_prefault_pool(MEMKIND_REGULAR, 0, 0));
+}
+
+TEST_F(GetArenaTest, test_TC_MEMKIND_ExtentPrefaultPoolInvalid)
+{
+    EXPECT_EQ(MEMKIND_ERROR_INVALID,
+              memkind_set_prefault_pool(MEMKIND_REGULAR, 1024, 2048));
+    EXPECT_EQ(MEMKIND_ERROR_INVALID,
+              memkind_set_prefault_pool(MEMKIND_DEFAULT, 1024, 512));
+}
+
+// Arenas of 1GB hugetlb kind carve their extents from shared huge page,
+// instead of mapping a separate gigabyte for each arena.
+TEST_F(GetArenaTest, test_TC_MEMKIND_ExtentHugetlb1GBShared)
+{
+    const int threads_num = 8;
+    const uintptr_t huge_page_mask = ~((uintptr_t)(1ull << 30) - 1);
+    std::vector<void *> ptrs(threads_num);
+    std::vector<std::thread> threads;
+
+    if (memkind_check_available(MEMKIND_HUGETLB_1GB)) {
+        GTEST_SKIP() << "1GB huge pages are required." << std::endl;
+    }
+    for (int i = 0; i < threads_num; ++i) {
+        threads.emplace_back([&ptrs, i]() {
+            ptrs[i] = memkind_malloc(MEMKIND_HUGETLB_1GB, 4096);
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    for (auto ptr : ptrs) {
+        ASSERT_NE(nullptr, ptr);
+        EXPECT_EQ((uintptr_t)ptrs[0] & huge_page_mask,
+                  (uintptr_t)ptr & huge_page_mask);
+    }
+    for (auto ptr : ptrs) {
+        memkind_free(MEMKIND_HUGETLB_1GB, ptr);
+    }
+}
@@ -3,6 +3,7 @@
 
 #include <memkind.h>
 #include <memkind/internal/memkind_private.h>
+#include <fstream>
 #include <sys/mman.h>
 
 #include "TestPrereq.hpp"
@@ -91,6 +92,21 @@ TEST_F(MemkindGetCapacityTests, test_tc_memkind_verify_capacity_default)
     ASSERT_EQ(capacity, memkind_get_capacity(MEMKIND_DEFAULT));
 }
 
+TEST_F(MemkindGetCapacityTests, test_tc_memkind_verify_capacity_hugetlb_1gb)
+{
+    const std::string path = "/sys/kernel/mm/hugepages/hugepages-1048576kB/";
+    std::ifstream nr_file(path + "nr_hugepages");
+    std::ifstream overcommit_file(path + "nr_overcommit_hugepages");
+    size_t nr_hugepages = 0, nr_overcommit_hugepages = 0;
+    if (!(nr_file >> nr_hugepages) ||
+        !(overcommit_file >> nr_overcommit_hugepages)) {
+        GTEST_SKIP() << "1GB huge pages are not supported." << std::endl;
+    }
+
+    ASSERT_EQ((ssize_t)((nr_hugepages + nr_overcommit_hugepages) * GB),
+              memkind_get_capacity(MEMKIND_HUGETLB_1GB));
+}
+
 TEST_F(MemkindGetCapacityTests, test_tc_memkind_verify_capacity_high_cap)
 {
     int status = numa_available();
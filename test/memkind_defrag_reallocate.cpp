@@ -4,7 +4,10 @@
 #include "common.h"
 #include "memkind.h"
 #include "vector"
+#include <memory>
 #include <stdio.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 class MemkindDefragReallocateTests: public ::testing::Test
 {
@@ -118,3 +121,156 @@ TEST_F(MemkindDefragReallocateTests,
         memkind_free(MEMKIND_REGULAR, val);
     }
 }
+
+TEST_F(MemkindDefragReallocateTests,
+       test_TC_MEMKIND_Batch_REGULAR_kind_success)
+{
+    const size_t number_of_malloc = 100000;
+    std::vector<void *> alloc_vec;
+    size_t i;
+    double utilization_before, utilization_after;
+
+    for (i = 0; i < number_of_malloc; ++i) {
+        void *ptr = memkind_malloc(MEMKIND_REGULAR, 150);
+        ASSERT_NE(ptr, nullptr);
+        memset(ptr, 'a', 150);
+        alloc_vec.push_back(ptr);
+    }
+    // free every other allocation to leave slabs half used
+    for (i = 0; i < number_of_malloc; i += 2) {
+        memkind_free(MEMKIND_REGULAR, alloc_vec.at(i));
+    }
+    std::vector<void *> live_vec;
+    for (i = 1; i < number_of_malloc; i += 2) {
+        live_vec.push_back(alloc_vec.at(i));
+    }
+
+    ASSERT_EQ(memkind_update_cached_stats(), MEMKIND_SUCCESS);
+    ASSERT_EQ(memkind_get_utilization(MEMKIND_REGULAR, &utilization_before),
+              MEMKIND_SUCCESS);
+    ASSERT_LT(utilization_before, 1.0);
+
+    std::vector<void *> old_vec(live_vec);
+    std::unique_ptr<bool[]> moved(new bool[live_vec.size()]);
+    size_t count_mem_transfer = memkind_defrag_reallocate_batch(
+        MEMKIND_REGULAR, live_vec.data(), live_vec.size(), moved.get());
+    ASSERT_NE(count_mem_transfer, 0U);
+
+    size_t count_moved = 0;
+    for (i = 0; i < live_vec.size(); ++i) {
+        ASSERT_EQ(moved[i], live_vec[i] != old_vec[i]);
+        count_moved += moved[i];
+        ASSERT_EQ(static_cast<char *>(live_vec[i])[149], 'a');
+    }
+    ASSERT_EQ(count_moved, count_mem_transfer);
+
+    ASSERT_EQ(memkind_update_cached_stats(), MEMKIND_SUCCESS);
+    ASSERT_EQ(memkind_get_utilization(MEMKIND_REGULAR, &utilization_after),
+              MEMKIND_SUCCESS);
+    ASSERT_GT(utilization_after, utilization_before);
+
+    for (auto const &val : live_vec) {
+        memkind_free(MEMKIND_REGULAR, val);
+    }
+}
+
+static void defrag_trigger_cb(memkind_t kind, void *arg)
+{
+    __atomic_store_n(static_cast<int *>(arg), 1, __ATOMIC_RELEASE);
+}
+
+TEST_F(MemkindDefragReallocateTests, test_TC_MEMKIND_Defrag_trigger)
+{
+    const size_t number_of_malloc = 10000;
+    std::vector<void *> alloc_vec;
+    int triggered = 0;
+    size_t i;
+
+    for (i = 0; i < number_of_malloc; ++i) {
+        void *ptr = memkind_malloc(MEMKIND_REGULAR, 150);
+        ASSERT_NE(ptr, nullptr);
+        alloc_vec.push_back(ptr);
+    }
+    for (i = 0; i < number_of_malloc; i += 2) {
+        memkind_free(MEMKIND_REGULAR, alloc_vec.at(i));
+        alloc_vec.at(i) = nullptr;
+    }
+
+    int err = memkind_set_defrag_trigger(MEMKIND_REGULAR, 1.0, 10,
+                                         defrag_trigger_cb, &triggered);
+    ASSERT_EQ(err, MEMKIND_SUCCESS);
+    for (i = 0; i < 200 && !__atomic_load_n(&triggered, __ATOMIC_ACQUIRE);
+         ++i) {
+        usleep(10000);
+    }
+    err = memkind_set_defrag_trigger(MEMKIND_REGULAR, 0.0, 0, nullptr, nullptr);
+    ASSERT_EQ(err, MEMKIND_SUCCESS);
+    ASSERT_EQ(triggered, 1);
+
+    for (auto const &val : alloc_vec) {
+        memkind_free(MEMKIND_REGULAR, val);
+    }
+}
+
+static void defrag_trigger_disable_cb(memkind_t kind, void *arg)
+{
+    // callback is called without internal lock held
+    int err = memkind_set_defrag_trigger(kind, 0.0, 0, nullptr, nullptr);
+    __atomic_store_n(static_cast<int *>(arg), err ? -1 : 1, __ATOMIC_RELEASE);
+}
+
+TEST_F(MemkindDefragReallocateTests, test_TC_MEMKIND_Defrag_trigger_disable_cb)
+{
+    int triggered = 0;
+    int err = memkind_set_defrag_trigger(MEMKIND_REGULAR, 1.0, 10,
+                                         defrag_trigger_disable_cb, &triggered);
+    ASSERT_EQ(err, MEMKIND_SUCCESS);
+    for (int i = 0; i < 200 && !__atomic_load_n(&triggered, __ATOMIC_ACQUIRE);
+         ++i) {
+        usleep(10000);
+    }
+    ASSERT_EQ(__atomic_load_n(&triggered, __ATOMIC_ACQUIRE), 1);
+}
+
+TEST_F(MemkindDefragReallocateTests, test_TC_MEMKIND_Defrag_trigger_fork)
+{
+    static int triggered;
+    int err = memkind_set_defrag_trigger(MEMKIND_REGULAR, 1.0, 10,
+                                         defrag_trigger_cb, &triggered);
+    ASSERT_EQ(err, MEMKIND_SUCCESS);
+
+    pid_t pid = fork();
+    ASSERT_NE(-1, pid);
+    if (pid == 0) {
+        // trigger is fired by defrag thread restarted in child process
+        __atomic_store_n(&triggered, 0, __ATOMIC_RELEASE);
+        for (int i = 0; i < 200; ++i) {
+            if (__atomic_load_n(&triggered, __ATOMIC_ACQUIRE)) {
+                _exit(0);
+            }
+            usleep(10000);
+        }
+        _exit(1);
+    }
+    int status;
+    ASSERT_EQ(pid, waitpid(pid, &status, 0));
+    EXPECT_TRUE(WIFEXITED(status));
+    EXPECT_EQ(0, WEXITSTATUS(status));
+
+    err = memkind_set_defrag_trigger(MEMKIND_REGULAR, 0.0, 0, nullptr, nullptr);
+    ASSERT_EQ(err, MEMKIND_SUCCESS);
+}
+
+TEST_F(MemkindDefragReallocateTests, test_TC_MEMKIND_Defrag_trigger_invalid)
+{
+    int triggered = 0;
+    ASSERT_EQ(memkind_set_defrag_trigger(MEMKIND_REGULAR, 1.5, 10,
+                                         defrag_trigger_cb, &triggered),
+              MEMKIND_ERROR_INVALID);
+    ASSERT_EQ(memkind_set_defrag_trigger(MEMKIND_REGULAR, 0.5, 10, nullptr,
+                                         nullptr),
+              MEMKIND_ERROR_INVALID);
+    ASSERT_EQ(memkind_set_defrag_trigger(MEMKIND_REGULAR, 0.5, 0,
+                                         defrag_trigger_cb, &triggered),
+              MEMKIND_ERROR_INVALID);
+}
@@ -4,6 +4,7 @@
 #include <memkind_memtier.h>
 
 #include <random>
+#include <sys/mman.h>
 #include <thread>
 
 #include "common.h"
@@ -596,6 +597,28 @@ TEST_F(MemkindMemtierMemoryTest, test_tier_check_size_empty_tier)
     ASSERT_EQ(0ULL, memtier_kind_allocated_size(MEMKIND_REGULAR));
 }
 
+TEST_F(MemkindMemtierMemoryTest, test_tier_place_region)
+{
+    const size_t size = 4 * 1024 * 1024;
+    void *addr = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    ASSERT_NE(MAP_FAILED, addr);
+
+    memkind_t kind = memtier_place_region(m_tier_memory, addr, size);
+    ASSERT_NE(nullptr, kind);
+    // first placement goes to the first tier with empty tiers
+    ASSERT_EQ(MEMKIND_DEFAULT, kind);
+    ASSERT_EQ(size, memtier_kind_allocated_size(kind));
+    memset(addr, 0, size);
+
+    memtier_release_region(kind, size / 2);
+    ASSERT_EQ(size / 2, memtier_kind_allocated_size(kind));
+    memtier_release_region(kind, size / 2);
+    ASSERT_EQ(0ULL, allocation_sum());
+
+    munmap(addr, size);
+}
+
 TEST_F(MemkindMemtierMemoryTest, test_tier_memory_check_size_nullptr)
 {
     const size_t test_size = 512;
@@ -0,0 +1,349 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/* Copyright (C) 2022 Intel Corporation. */
+
+#include <memkind/internal/memkind_nodemask.h>
+#include <memkind/internal/memkind_private.h>
+#include <memkind/internal/memkind_spill.h>
+
+#include "common.h"
+#include <numa.h>
+#include <numaif.h>
+#include <thread>
+#include <vector>
+
+class MemkindNodemaskTests: public ::testing::Test
+{
+protected:
+    struct bitmask *nodemask;
+    int node;
+
+    void SetUp()
+    {
+        nodemask = numa_allocate_nodemask();
+        // first node with memory
+        for (node = 0; !numa_bitmask_isbitset(numa_all_nodes_ptr, node);
+             ++node)
+            ;
+        numa_bitmask_setbit(nodemask, node);
+    }
+
+    void TearDown()
+    {
+        numa_bitmask_free(nodemask);
+    }
+};
+
+TEST_F(MemkindNodemaskTests, test_TC_MEMKIND_NodemaskPolicy)
+{
+    const size_t size = 4 * MB;
+    const int modes[] = {MPOL_BIND, MPOL_PREFERRED, MPOL_INTERLEAVE};
+
+    for (int mode : modes) {
+        memkind_t kind = nullptr;
+        ASSERT_EQ(memkind_create_kind_nodemask(nodemask, mode,
+                                               memkind_bits_t(), &kind),
+                  MEMKIND_SUCCESS);
+        char *ptr = static_cast<char *>(memkind_malloc(kind, size));
+        ASSERT_NE(ptr, nullptr);
+        memset(ptr, 0, size);
+        ASSERT_EQ(memkind_detect_kind(ptr), kind);
+
+        int policy = -1;
+        struct bitmask *ptr_nodes = numa_allocate_nodemask();
+        ASSERT_EQ(get_mempolicy(&policy, ptr_nodes->maskp, ptr_nodes->size + 1,
+                                ptr, MPOL_F_ADDR),
+                  0);
+        ASSERT_EQ(policy, mode);
+        ASSERT_TRUE(numa_bitmask_equal(ptr_nodes, nodemask));
+        numa_bitmask_free(ptr_nodes);
+        int ptr_node = -1;
+        ASSERT_EQ(get_mempolicy(&ptr_node, nullptr, 0, ptr,
+                                MPOL_F_NODE | MPOL_F_ADDR),
+                  0);
+        ASSERT_EQ(ptr_node, node);
+
+        size_t allocated = 0;
+        ASSERT_EQ(memkind_update_cached_stats(), MEMKIND_SUCCESS);
+        ASSERT_EQ(memkind_get_stat(kind, MEMKIND_STAT_TYPE_ALLOCATED,
+                                   &allocated),
+                  MEMKIND_SUCCESS);
+        ASSERT_GE(allocated, size);
+        memkind_free(kind, ptr);
+        ASSERT_EQ(memkind_destroy_kind(kind), MEMKIND_SUCCESS);
+    }
+}
+
+TEST_F(MemkindNodemaskTests, test_TC_MEMKIND_NodemaskThreadCache)
+{
+    memkind_t kind = nullptr;
+    ASSERT_EQ(memkind_create_kind_nodemask(nodemask, MPOL_BIND,
+                                           memkind_bits_t(), &kind),
+              MEMKIND_SUCCESS);
+    ASSERT_TRUE(kind->use_tcache);
+
+    // freed small allocation is reused from thread cache
+    void *ptr = memkind_malloc(kind, 64);
+    ASSERT_NE(ptr, nullptr);
+    memkind_free(kind, ptr);
+    ASSERT_EQ(memkind_malloc(kind, 64), ptr);
+    memkind_free(kind, ptr);
+
+    // thread caches of other threads are released with the kind
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([kind]() {
+            for (int i = 0; i < 1000; ++i) {
+                memkind_free(kind, memkind_malloc(kind, 32 + i % 256));
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    unsigned partition = kind->partition;
+    ASSERT_EQ(memkind_destroy_kind(kind), MEMKIND_SUCCESS);
+
+    // new kind in the same partition does not get objects cached for
+    // destroyed kind
+    ASSERT_EQ(memkind_create_kind_nodemask(nodemask, MPOL_BIND,
+                                           memkind_bits_t(), &kind),
+              MEMKIND_SUCCESS);
+    ASSERT_EQ(kind->partition, partition);
+    ptr = memkind_malloc(kind, 64);
+    ASSERT_NE(ptr, nullptr);
+    ASSERT_EQ(memkind_detect_kind(ptr), kind);
+    memkind_free(kind, ptr);
+    ASSERT_EQ(memkind_destroy_kind(kind), MEMKIND_SUCCESS);
+}
+
+TEST_F(MemkindNodemaskTests, test_TC_MEMKIND_NodemaskThp)
+{
+    memkind_t kind = nullptr;
+    int err = memkind_create_kind_nodemask(nodemask, MPOL_BIND,
+                                           MEMKIND_MASK_THP, &kind);
+    if (err == MEMKIND_ERROR_MEMTYPE_NOT_AVAILABLE) {
+        GTEST_SKIP() << "Transparent huge pages are required." << std::endl;
+    }
+    ASSERT_EQ(err, MEMKIND_SUCCESS);
+    void *ptr = memkind_malloc(kind, 4 * MB);
+    ASSERT_NE(ptr, nullptr);
+    memkind_free(kind, ptr);
+    ASSERT_EQ(memkind_destroy_kind(kind), MEMKIND_SUCCESS);
+}
+
+TEST_F(MemkindNodemaskTests, test_TC_MEMKIND_NodemaskInvalid)
+{
+    memkind_t kind = nullptr;
+    ASSERT_EQ(memkind_create_kind_nodemask(nullptr, MPOL_BIND,
+                                           memkind_bits_t(), &kind),
+              MEMKIND_ERROR_INVALID);
+    ASSERT_EQ(memkind_create_kind_nodemask(nodemask, MPOL_BIND,
+                                           memkind_bits_t(), nullptr),
+              MEMKIND_ERROR_INVALID);
+    ASSERT_EQ(memkind_create_kind_nodemask(nodemask, MPOL_LOCAL,
+                                           memkind_bits_t(), &kind),
+              MEMKIND_ERROR_INVALID);
+    ASSERT_EQ(memkind_create_kind_nodemask(nodemask, MPOL_BIND,
+                                           MEMKIND_MASK_PAGE_SIZE_2MB, &kind),
+              MEMKIND_ERROR_INVALID);
+
+    struct bitmask *empty = numa_allocate_nodemask();
+    ASSERT_EQ(memkind_create_kind_nodemask(empty, MPOL_BIND,
+                                           memkind_bits_t(), &kind),
+              MEMKIND_ERROR_INVALID);
+    // node without memory
+    numa_bitmask_setbit(empty, empty->size - 1);
+    ASSERT_EQ(memkind_create_kind_nodemask(empty, MPOL_BIND,
+                                           memkind_bits_t(), &kind),
+              MEMKIND_ERROR_MEMTYPE_NOT_AVAILABLE);
+    numa_bitmask_free(empty);
+}
+
+TEST_F(MemkindNodemaskTests, test_TC_MEMKIND_WeightedInterleavePolicy)
+{
+    const size_t size = 4 * MB;
+    std::vector<unsigned> weights(nodemask->size, 0);
+    weights[node] = 3;
+
+    for (bool kernel : {true, false}) {
+        memkind_t kind = nullptr;
+        ASSERT_EQ(memkind_create_kind_weighted_interleave(
+                      nodemask, weights.data(), &kind),
+                  MEMKIND_SUCCESS);
+        auto priv = static_cast<memkind_nodemask *>(kind->priv);
+        ASSERT_EQ(priv->num_nodes, 1U);
+        ASSERT_EQ(priv->nodes[0], node);
+        ASSERT_EQ(priv->total_weight, 1U);
+        // extents are split by memkind when kernel does not interleave
+        priv->kernel_weights = priv->kernel_weights && kernel;
+
+        char *ptr = static_cast<char *>(memkind_malloc(kind, size));
+        ASSERT_NE(ptr, nullptr);
+        memset(ptr, 0, size);
+        ASSERT_EQ(memkind_detect_kind(ptr), kind);
+        int policy = -1;
+        ASSERT_EQ(get_mempolicy(&policy, nullptr, 0, ptr, MPOL_F_ADDR), 0);
+        ASSERT_EQ(policy,
+                  priv->kernel_weights ? MPOL_WEIGHTED_INTERLEAVE : MPOL_BIND);
+        int ptr_node = -1;
+        ASSERT_EQ(get_mempolicy(&ptr_node, nullptr, 0, ptr,
+                                MPOL_F_NODE | MPOL_F_ADDR),
+                  0);
+        ASSERT_EQ(ptr_node, node);
+        memkind_free(kind, ptr);
+        ASSERT_EQ(memkind_destroy_kind(kind), MEMKIND_SUCCESS);
+    }
+}
+
+TEST_F(MemkindNodemaskTests, test_TC_MEMKIND_WeightedInterleavePages)
+{
+    int nodes[] = {0, 1, 2};
+    unsigned weights[] = {4, 1, 2};
+    memkind_nodemask priv = {};
+    priv.nodes = nodes;
+    priv.weights = weights;
+    priv.num_nodes = 3;
+    priv.total_weight = 7;
+
+    // pages of extents of any size are placed in proportion to weights
+    size_t placed[3] = {0, 0, 0};
+    size_t all = 0;
+    unsigned pos = 0;
+    for (size_t pages = 1; pages < 200; ++pages) {
+        size_t sum = 0;
+        for (unsigned i = 0; i < 3; ++i) {
+            size_t count =
+                memkind_nodemask_weighted_pages(&priv, i, pages, pos);
+            placed[i] += count;
+            sum += count;
+        }
+        ASSERT_EQ(sum, pages);
+        all += pages;
+        pos = (pos + pages % priv.total_weight) % priv.total_weight;
+        if (pos == 0) {
+            for (unsigned i = 0; i < 3; ++i) {
+                ASSERT_EQ(placed[i], all / priv.total_weight * weights[i]);
+            }
+        }
+    }
+}
+
+TEST_F(MemkindNodemaskTests, test_TC_MEMKIND_WeightedInterleaveBandwidth)
+{
+    memkind_t kind = nullptr;
+    int err = memkind_create_kind_weighted_interleave(nodemask, nullptr, &kind);
+    if (err == MEMKIND_ERROR_MEMTYPE_NOT_AVAILABLE) {
+        GTEST_SKIP() << "HMAT bandwidth of nodes is required." << std::endl;
+    }
+    ASSERT_EQ(err, MEMKIND_SUCCESS);
+    void *ptr = memkind_malloc(kind, 4 * MB);
+    ASSERT_NE(ptr, nullptr);
+    memkind_free(kind, ptr);
+    ASSERT_EQ(memkind_destroy_kind(kind), MEMKIND_SUCCESS);
+}
+
+TEST_F(MemkindNodemaskTests, test_TC_MEMKIND_WeightedInterleaveInvalid)
+{
+    memkind_t kind = nullptr;
+    std::vector<unsigned> weights(nodemask->size, 1);
+    ASSERT_EQ(memkind_create_kind_weighted_interleave(nullptr, weights.data(),
+                                                      &kind),
+              MEMKIND_ERROR_INVALID);
+    ASSERT_EQ(memkind_create_kind_weighted_interleave(nodemask, weights.data(),
+                                                      nullptr),
+              MEMKIND_ERROR_INVALID);
+    weights[node] = 0;
+    ASSERT_EQ(memkind_create_kind_weighted_interleave(nodemask, weights.data(),
+                                                      &kind),
+              MEMKIND_ERROR_INVALID);
+
+    struct bitmask *empty = numa_allocate_nodemask();
+    ASSERT_EQ(memkind_create_kind_weighted_interleave(empty, weights.data(),
+                                                      &kind),
+              MEMKIND_ERROR_INVALID);
+    numa_bitmask_free(empty);
+}
+
+TEST_F(MemkindNodemaskTests, test_TC_MEMKIND_SpillWatermark)
+{
+    const size_t size = 4 * MB;
+    memkind_t kind = nullptr;
+    ASSERT_EQ(memkind_create_kind_spill(nodemask, nodemask, 1, &kind),
+              MEMKIND_SUCCESS);
+    ASSERT_TRUE(kind->use_tcache);
+    auto priv = static_cast<memkind_spill *>(kind->priv);
+    unsigned occupancy = 0;
+    ASSERT_EQ(memkind_get_occupancy(kind, &occupancy), MEMKIND_SUCCESS);
+    if (occupancy < 1) {
+        memkind_destroy_kind(kind);
+        GTEST_SKIP() << "Preferred node has to be in use." << std::endl;
+    }
+
+    // watermark is crossed by memory already used on the node
+    void *spilled = memkind_malloc(kind, size);
+    ASSERT_NE(spilled, nullptr);
+    ASSERT_TRUE(priv->spilling);
+    ASSERT_GE(priv->occupancy, 1U);
+    int policy = -1;
+    ASSERT_EQ(get_mempolicy(&policy, nullptr, 0, spilled, MPOL_F_ADDR), 0);
+    ASSERT_TRUE(policy == MPOL_PREFERRED_MANY || policy == MPOL_PREFERRED);
+
+    // kind returns to preferred nodes when occupancy drops
+    priv->watermark = 100;
+    priv->checked_ns = 0;
+    void *filled = memkind_malloc(kind, 2 * size);
+    ASSERT_NE(filled, nullptr);
+    ASSERT_FALSE(priv->spilling);
+    memset(filled, 0, 2 * size);
+    int ptr_node = -1;
+    ASSERT_EQ(
+        get_mempolicy(&ptr_node, nullptr, 0, filled, MPOL_F_NODE | MPOL_F_ADDR),
+        0);
+    ASSERT_EQ(ptr_node, node);
+
+    memkind_free(kind, filled);
+    memkind_free(kind, spilled);
+    ASSERT_EQ(memkind_destroy_kind(kind), MEMKIND_SUCCESS);
+}
+
+TEST_F(MemkindNodemaskTests, test_TC_MEMKIND_SpillOccupancy)
+{
+    unsigned occupancy = 101;
+    ASSERT_EQ(memkind_get_occupancy(MEMKIND_DEFAULT, &occupancy),
+              MEMKIND_SUCCESS);
+    ASSERT_LE(occupancy, 100U);
+
+    memkind_t kind = nullptr;
+    ASSERT_EQ(memkind_create_kind_spill(nodemask, nodemask, 90, &kind),
+              MEMKIND_SUCCESS);
+    occupancy = 101;
+    ASSERT_EQ(memkind_get_occupancy(kind, &occupancy), MEMKIND_SUCCESS);
+    ASSERT_LE(occupancy, 100U);
+    ASSERT_EQ(memkind_get_capacity(kind), numa_node_size64(node, nullptr));
+    ASSERT_EQ(memkind_destroy_kind(kind), MEMKIND_SUCCESS);
+
+    char buf[4096];
+    ASSERT_EQ(memkind_create_fixed(buf, sizeof(buf), &kind), MEMKIND_SUCCESS);
+    ASSERT_EQ(memkind_get_occupancy(kind, &occupancy), MEMKIND_ERROR_INVALID);
+    ASSERT_EQ(memkind_destroy_kind(kind), MEMKIND_SUCCESS);
+}
+
+TEST_F(MemkindNodemaskTests, test_TC_MEMKIND_SpillInvalid)
+{
+    memkind_t kind = nullptr;
+    ASSERT_EQ(memkind_create_kind_spill(nullptr, nodemask, 80, &kind),
+              MEMKIND_ERROR_INVALID);
+    ASSERT_EQ(memkind_create_kind_spill(nodemask, nullptr, 80, &kind),
+              MEMKIND_ERROR_INVALID);
+    ASSERT_EQ(memkind_create_kind_spill(nodemask, nodemask, 80, nullptr),
+              MEMKIND_ERROR_INVALID);
+    ASSERT_EQ(memkind_create_kind_spill(nodemask, nodemask, 0, &kind),
+              MEMKIND_ERROR_INVALID);
+    ASSERT_EQ(memkind_create_kind_spill(nodemask, nodemask, 101, &kind),
+              MEMKIND_ERROR_INVALID);
+
+    struct bitmask *empty = numa_allocate_nodemask();
+    ASSERT_EQ(memkind_create_kind_spill(nodemask, empty, 80, &kind),
+              MEMKIND_ERROR_INVALID);
+    numa_bitmask_free(empty);
+}
@@ -7,8 +7,13 @@
 
 #include "common.h"
 
+#include <numa.h>
+#include <sched.h>
+#include <sys/stat.h>
 #include <sys/statfs.h>
 
+#include <vector>
+
 extern const char *PMEM_DIR;
 
 class MemkindConfigTests: public ::testing::Test
@@ -154,3 +159,165 @@ TEST_F(MemkindConfigTests,
     err = memkind_destroy_kind(pmem_kind);
     ASSERT_EQ(err, 0);
 }
+
+TEST_F(MemkindConfigTests, test_TC_MEMKIND_PmemSetArenaNum)
+{
+    memkind_t pmem_kind = nullptr;
+    memkind_config_set_path(global_test_cfg, PMEM_DIR);
+    memkind_config_set_size(global_test_cfg, 0U);
+    memkind_config_set_arena_num(global_test_cfg, 3);
+    int err = memkind_create_pmem_with_config(global_test_cfg, &pmem_kind);
+    ASSERT_EQ(err, 0);
+
+    // number of arenas is rounded up to power of 2
+    ASSERT_EQ(pmem_kind->arena_map_len, 4U);
+    // only arena of first slot is created with kind
+    ASSERT_NE(pmem_kind->arena_map[0], 0U);
+    for (unsigned i = 1; i < pmem_kind->arena_map_len; ++i) {
+        ASSERT_EQ(pmem_kind->arena_map[i], 0U);
+    }
+
+    void *ptr = memkind_malloc(pmem_kind, 1 * KB);
+    ASSERT_NE(ptr, nullptr);
+    memkind_free(pmem_kind, ptr);
+
+    err = memkind_destroy_kind(pmem_kind);
+    ASSERT_EQ(err, 0);
+}
+
+TEST_F(MemkindConfigTests, test_TC_MEMKIND_PmemArenaSelectBijective)
+{
+    memkind_t pmem_kind = nullptr;
+    memkind_config_set_path(global_test_cfg, PMEM_DIR);
+    memkind_config_set_size(global_test_cfg, 0U);
+    memkind_config_set_arena_num(global_test_cfg, 8);
+    memkind_config_set_arena_select(global_test_cfg,
+                                    MEMKIND_ARENA_SELECT_BIJECTIVE);
+    int err = memkind_create_pmem_with_config(global_test_cfg, &pmem_kind);
+    ASSERT_EQ(err, 0);
+    ASSERT_EQ(pmem_kind->arena_map_len, 1U);
+    unsigned arena;
+    ASSERT_EQ(pmem_kind->ops->get_arena(pmem_kind, &arena, 1 * KB), 0);
+    ASSERT_EQ(arena, pmem_kind->arena_zero);
+
+    void *ptr = memkind_malloc(pmem_kind, 1 * KB);
+    ASSERT_NE(ptr, nullptr);
+    memkind_free(pmem_kind, ptr);
+
+    err = memkind_destroy_kind(pmem_kind);
+    ASSERT_EQ(err, 0);
+}
+
+TEST_F(MemkindConfigTests, test_TC_MEMKIND_PmemArenaSelectCpu)
+{
+    memkind_t pmem_kind = nullptr;
+    cpu_set_t cpu_set, old_cpu_set;
+    int cpu = sched_getcpu();
+    ASSERT_GE(cpu, 0);
+    ASSERT_EQ(sched_getaffinity(0, sizeof(old_cpu_set), &old_cpu_set), 0);
+    CPU_ZERO(&cpu_set);
+    CPU_SET(cpu, &cpu_set);
+    ASSERT_EQ(sched_setaffinity(0, sizeof(cpu_set), &cpu_set), 0);
+
+    memkind_config_set_path(global_test_cfg, PMEM_DIR);
+    memkind_config_set_size(global_test_cfg, 0U);
+    memkind_config_set_arena_select(global_test_cfg, MEMKIND_ARENA_SELECT_CPU);
+    int err = memkind_create_pmem_with_config(global_test_cfg, &pmem_kind);
+    ASSERT_EQ(err, 0);
+    ASSERT_GE(pmem_kind->arena_map_len,
+              static_cast<unsigned>(numa_num_configured_cpus()));
+
+    void *ptr = memkind_malloc(pmem_kind, 1 * KB);
+    ASSERT_NE(ptr, nullptr);
+    // arena of slot of current CPU is created on first allocation
+    ASSERT_NE(pmem_kind->arena_map[cpu & pmem_kind->arena_map_mask], 0U);
+    memkind_free(pmem_kind, ptr);
+
+    err = memkind_destroy_kind(pmem_kind);
+    ASSERT_EQ(err, 0);
+    sched_setaffinity(0, sizeof(old_cpu_set), &old_cpu_set);
+}
+
+TEST_F(MemkindConfigTests, test_TC_MEMKIND_PmemArenaSelectInvalid)
+{
+    memkind_t pmem_kind = nullptr;
+    memkind_config_set_path(global_test_cfg, PMEM_DIR);
+    memkind_config_set_size(global_test_cfg, 0U);
+    memkind_config_set_arena_select(global_test_cfg,
+                                    MEMKIND_ARENA_SELECT_MAX_VALUE);
+    int err = memkind_create_pmem_with_config(global_test_cfg, &pmem_kind);
+    ASSERT_EQ(err, MEMKIND_ERROR_INVALID);
+}
+
+TEST_F(MemkindConfigTests, test_TC_MEMKIND_PmemPreallocFile)
+{
+    memkind_t pmem_kind = nullptr;
+    struct stat st;
+    const size_t pmem_size = 2 * MEMKIND_PMEM_MIN_SIZE;
+    memkind_config_set_path(global_test_cfg, PMEM_DIR);
+    memkind_config_set_size(global_test_cfg, pmem_size);
+    memkind_config_set_pmem_prealloc(global_test_cfg,
+                                     MEMKIND_PMEM_PREALLOC_FILE);
+    int err = memkind_create_pmem_with_config(global_test_cfg, &pmem_kind);
+    ASSERT_EQ(err, 0);
+
+    struct memkind_pmem *priv = static_cast<memkind_pmem *>(pmem_kind->priv);
+    ASSERT_NE(priv->base, nullptr);
+    // whole file is allocated at creation
+    ASSERT_EQ(fstat(priv->fd, &st), 0);
+    ASSERT_GE(static_cast<size_t>(st.st_blocks) * 512, priv->max_size);
+
+    // extents are carved from single mapping
+    char *base = static_cast<char *>(priv->base);
+    std::vector<void *> ptrs;
+    void *ptr;
+    while ((ptr = memkind_malloc(pmem_kind, 1 * MB))) {
+        ASSERT_GE(static_cast<char *>(ptr), base);
+        ASSERT_LE(static_cast<char *>(ptr) + 1 * MB, base + priv->max_size);
+        memset(ptr, 'a', 1 * MB);
+        ptrs.push_back(ptr);
+    }
+    ASSERT_GT(ptrs.size(), 0U);
+    ASSERT_LE(priv->current_size, priv->max_size);
+    for (auto const &p : ptrs) {
+        memkind_free(pmem_kind, p);
+    }
+
+    // space of freed extents is reused
+    ptr = memkind_malloc(pmem_kind, 1 * MB);
+    ASSERT_NE(ptr, nullptr);
+    memkind_free(pmem_kind, ptr);
+
+    err = memkind_destroy_kind(pmem_kind);
+    ASSERT_EQ(err, 0);
+}
+
+TEST_F(MemkindConfigTests, test_TC_MEMKIND_PmemPreallocPopulate)
+{
+    memkind_t pmem_kind = nullptr;
+    memkind_config_set_path(global_test_cfg, PMEM_DIR);
+    memkind_config_set_size(global_test_cfg, MEMKIND_PMEM_MIN_SIZE);
+    memkind_config_set_pmem_prealloc(global_test_cfg,
+                                     MEMKIND_PMEM_PREALLOC_POPULATE);
+    int err = memkind_create_pmem_with_config(global_test_cfg, &pmem_kind);
+    ASSERT_EQ(err, 0);
+
+    void *ptr = memkind_malloc(pmem_kind, 1 * KB);
+    ASSERT_NE(ptr, nullptr);
+    memkind_free(pmem_kind, ptr);
+    ASSERT_EQ(memkind_purge(pmem_kind), MEMKIND_SUCCESS);
+
+    err = memkind_destroy_kind(pmem_kind);
+    ASSERT_EQ(err, 0);
+}
+
+TEST_F(MemkindConfigTests, test_TC_MEMKIND_PmemPreallocWithoutSize)
+{
+    memkind_t pmem_kind = nullptr;
+    memkind_config_set_path(global_test_cfg, PMEM_DIR);
+    memkind_config_set_size(global_test_cfg, 0U);
+    memkind_config_set_pmem_prealloc(global_test_cfg,
+                                     MEMKIND_PMEM_PREALLOC_FILE);
+    int err = memkind_create_pmem_with_config(global_test_cfg, &pmem_kind);
+    ASSERT_EQ(err, MEMKIND_ERROR_INVALID);
+}
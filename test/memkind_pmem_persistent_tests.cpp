@@ -0,0 +1,269 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/* Copyright (C) 2022 Intel Corporation. */
+
+#include <memkind/internal/memkind_pmem_persistent.h>
+#include <memkind/internal/memkind_private.h>
+
+#include "common.h"
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+extern const char *PMEM_DIR;
+
+static const size_t PERSISTENT_SIZE = 2 * MEMKIND_PMEM_MIN_SIZE;
+
+struct persistent_root {
+    char *data;
+    size_t size;
+};
+
+class MemkindPmemPersistentTests: public ::testing::Test
+{
+protected:
+    std::string path;
+
+    void SetUp()
+    {
+        path = std::string(PMEM_DIR) + "/memkind_persistent." +
+            std::to_string(getpid());
+        unlink(path.c_str());
+    }
+
+    void TearDown()
+    {
+        unlink(path.c_str());
+    }
+
+    size_t allocated(memkind_t kind)
+    {
+        size_t value = 0;
+        EXPECT_EQ(kind->ops->get_stat(kind, MEMKIND_STAT_TYPE_ALLOCATED,
+                                      &value),
+                  MEMKIND_SUCCESS);
+        return value;
+    }
+
+    // builds root object pointing to data filled with pattern
+    void fill_heap(memkind_t kind)
+    {
+        auto root = static_cast<persistent_root *>(
+            memkind_malloc(kind, sizeof(persistent_root)));
+        ASSERT_NE(root, nullptr);
+        root->size = 1 * MB;
+        root->data = static_cast<char *>(memkind_malloc(kind, root->size));
+        ASSERT_NE(root->data, nullptr);
+        memset(root->data, 'p', root->size);
+        ASSERT_EQ(memkind_pmem_set_root(kind, root), MEMKIND_SUCCESS);
+    }
+
+    void check_heap(memkind_t kind)
+    {
+        auto root = static_cast<persistent_root *>(memkind_pmem_get_root(kind));
+        ASSERT_NE(root, nullptr);
+        ASSERT_EQ(root->size, 1 * MB);
+        ASSERT_GE(memkind_malloc_usable_size(kind, root->data), root->size);
+        for (size_t i = 0; i < root->size; ++i) {
+            ASSERT_EQ(root->data[i], 'p');
+        }
+    }
+};
+
+TEST_F(MemkindPmemPersistentTests, test_TC_MEMKIND_PmemPersistentReopen)
+{
+    memkind_t kind = nullptr;
+    int err =
+        memkind_create_pmem_persistent(path.c_str(), PERSISTENT_SIZE, &kind);
+    ASSERT_EQ(err, MEMKIND_SUCCESS);
+    ASSERT_EQ(memkind_pmem_get_root(kind), nullptr);
+    fill_heap(kind);
+    void *base = static_cast<memkind_pmem_persistent *>(kind->priv)->base;
+    size_t used = allocated(kind);
+    ASSERT_GT(used, 1 * MB);
+    ASSERT_EQ(memkind_destroy_kind(kind), MEMKIND_SUCCESS);
+
+    // size is ignored for existing heap
+    err = memkind_create_pmem_persistent(path.c_str(), 0, &kind);
+    ASSERT_EQ(err, MEMKIND_SUCCESS);
+    ASSERT_EQ(static_cast<memkind_pmem_persistent *>(kind->priv)->base, base);
+    ASSERT_EQ(allocated(kind), used);
+    check_heap(kind);
+
+    auto root = static_cast<persistent_root *>(memkind_pmem_get_root(kind));
+    memset(root->data, 'q', root->size);
+    ASSERT_EQ(memkind_pmem_persist(kind, root->data, root->size),
+              MEMKIND_SUCCESS);
+    int local;
+    ASSERT_EQ(memkind_pmem_persist(kind, &local, sizeof(local)),
+              MEMKIND_ERROR_INVALID);
+    memkind_free(kind, root->data);
+    memkind_free(kind, root);
+    ASSERT_EQ(memkind_pmem_set_root(kind, nullptr), MEMKIND_SUCCESS);
+    ASSERT_EQ(allocated(kind), 0U);
+    ASSERT_EQ(memkind_destroy_kind(kind), MEMKIND_SUCCESS);
+}
+
+TEST_F(MemkindPmemPersistentTests, test_TC_MEMKIND_PmemPersistentRecover)
+{
+    pid_t pid = fork();
+    ASSERT_NE(pid, -1);
+    if (pid == 0) {
+        memkind_t kind = nullptr;
+        int err = memkind_create_pmem_persistent(path.c_str(), PERSISTENT_SIZE,
+                                                 &kind);
+        if (err || !kind) {
+            _exit(1);
+        }
+        fill_heap(kind);
+        // leave some free blocks between used ones
+        void *ptrs[16];
+        for (int i = 0; i < 16; ++i) {
+            ptrs[i] = memkind_malloc(kind, (i + 1) * KB);
+        }
+        for (int i = 0; i < 16; i += 2) {
+            memkind_free(kind, ptrs[i]);
+        }
+        // heap is not closed
+        _exit(HasFailure() ? 1 : 0);
+    }
+    int status;
+    ASSERT_EQ(waitpid(pid, &status, 0), pid);
+    ASSERT_TRUE(WIFEXITED(status));
+    ASSERT_EQ(WEXITSTATUS(status), 0);
+
+    memkind_t kind = nullptr;
+    int err =
+        memkind_create_pmem_persistent(path.c_str(), PERSISTENT_SIZE, &kind);
+    ASSERT_EQ(err, MEMKIND_SUCCESS);
+    check_heap(kind);
+    size_t used = allocated(kind);
+    ASSERT_GT(used, 1 * MB);
+
+    // free lists are rebuilt
+    std::vector<void *> ptrs;
+    void *ptr;
+    while ((ptr = memkind_malloc(kind, 64 * KB))) {
+        ptrs.push_back(ptr);
+    }
+    ASSERT_GT(ptrs.size(), 0U);
+    for (auto const &p : ptrs) {
+        memkind_free(kind, p);
+    }
+    ASSERT_EQ(allocated(kind), used);
+    check_heap(kind);
+    ASSERT_EQ(memkind_destroy_kind(kind), MEMKIND_SUCCESS);
+}
+
+TEST_F(MemkindPmemPersistentTests, test_TC_MEMKIND_PmemPersistentCoalesce)
+{
+    memkind_t kind = nullptr;
+    int err =
+        memkind_create_pmem_persistent(path.c_str(), PERSISTENT_SIZE, &kind);
+    ASSERT_EQ(err, MEMKIND_SUCCESS);
+
+    std::vector<void *> ptrs;
+    for (size_t i = 0; i < 1000; ++i) {
+        void *ptr = memkind_malloc(kind, 1 + (i * 97) % (4 * KB));
+        ASSERT_NE(ptr, nullptr);
+        ptrs.push_back(ptr);
+    }
+    // free in interleaved order to merge with both neighbours
+    for (size_t i = 0; i < ptrs.size(); i += 2) {
+        memkind_free(kind, ptrs[i]);
+    }
+    for (size_t i = 1; i < ptrs.size(); i += 2) {
+        memkind_free(kind, ptrs[i]);
+    }
+    ASSERT_EQ(allocated(kind), 0U);
+
+    // whole heap is single free block again
+    void *ptr = memkind_malloc(kind, PERSISTENT_SIZE - 8 * KB);
+    ASSERT_NE(ptr, nullptr);
+    memkind_free(kind, ptr);
+    ASSERT_EQ(memkind_destroy_kind(kind), MEMKIND_SUCCESS);
+}
+
+TEST_F(MemkindPmemPersistentTests, test_TC_MEMKIND_PmemPersistentAlignRealloc)
+{
+    memkind_t kind = nullptr;
+    int err =
+        memkind_create_pmem_persistent(path.c_str(), PERSISTENT_SIZE, &kind);
+    ASSERT_EQ(err, MEMKIND_SUCCESS);
+
+    for (size_t alignment = sizeof(void *); alignment <= 1 * MB;
+         alignment *= 4) {
+        void *ptr = nullptr;
+        err = memkind_posix_memalign(kind, &ptr, alignment, 100);
+        ASSERT_EQ(err, 0);
+        ASSERT_EQ(reinterpret_cast<uintptr_t>(ptr) % alignment, 0U);
+        memkind_free(kind, ptr);
+    }
+    void *ptr = nullptr;
+    ASSERT_EQ(memkind_posix_memalign(kind, &ptr, 3, 100), EINVAL);
+
+    char *data = static_cast<char *>(memkind_malloc(kind, 100));
+    ASSERT_NE(data, nullptr);
+    memset(data, 'r', 100);
+    void *blocker = memkind_malloc(kind, 100);
+    ASSERT_NE(blocker, nullptr);
+    // grow with copy, then in place
+    data = static_cast<char *>(memkind_realloc(kind, data, 10 * KB));
+    ASSERT_NE(data, nullptr);
+    memset(data + 100, 's', 10 * KB - 100);
+    data = static_cast<char *>(memkind_realloc(kind, data, 1 * MB));
+    ASSERT_NE(data, nullptr);
+    for (size_t i = 0; i < 10 * KB; ++i) {
+        ASSERT_EQ(data[i], i < 100 ? 'r' : 's');
+    }
+    data = static_cast<char *>(memkind_realloc(kind, data, 50));
+    ASSERT_NE(data, nullptr);
+    ASSERT_EQ(data[49], 'r');
+
+    auto calloc_ptr = static_cast<char *>(memkind_calloc(kind, 1 * MB, 1));
+    ASSERT_NE(calloc_ptr, nullptr);
+    for (size_t i = 0; i < 1 * MB; ++i) {
+        ASSERT_EQ(calloc_ptr[i], 0);
+    }
+    memkind_free(kind, calloc_ptr);
+    memkind_free(kind, data);
+    memkind_free(kind, blocker);
+    ASSERT_EQ(allocated(kind), 0U);
+    ASSERT_EQ(memkind_malloc(kind, PERSISTENT_SIZE), nullptr);
+    ASSERT_EQ(memkind_destroy_kind(kind), MEMKIND_SUCCESS);
+}
+
+TEST_F(MemkindPmemPersistentTests, test_TC_MEMKIND_PmemPersistentInvalid)
+{
+    memkind_t kind = nullptr;
+    memkind_t other = nullptr;
+    int err = memkind_create_pmem_persistent(
+        path.c_str(), MEMKIND_PMEM_MIN_SIZE - 1, &kind);
+    ASSERT_EQ(err, MEMKIND_ERROR_INVALID);
+    // size of new heap is required
+    err = memkind_create_pmem_persistent(path.c_str(), 0, &kind);
+    ASSERT_EQ(err, MEMKIND_ERROR_INVALID);
+
+    err = memkind_create_pmem_persistent(path.c_str(), PERSISTENT_SIZE, &kind);
+    ASSERT_EQ(err, MEMKIND_SUCCESS);
+    // heap is used by single kind at a time
+    err = memkind_create_pmem_persistent(path.c_str(), PERSISTENT_SIZE, &other);
+    ASSERT_EQ(err, MEMKIND_ERROR_INVALID);
+    int local;
+    ASSERT_EQ(memkind_pmem_set_root(kind, &local), MEMKIND_ERROR_INVALID);
+    ASSERT_EQ(memkind_destroy_kind(kind), MEMKIND_SUCCESS);
+
+    ASSERT_EQ(memkind_pmem_get_root(MEMKIND_DEFAULT), nullptr);
+    ASSERT_EQ(memkind_pmem_set_root(MEMKIND_DEFAULT, nullptr),
+              MEMKIND_ERROR_INVALID);
+
+    // file which is not a heap
+    std::string bad = path + ".bad";
+    FILE *f = fopen(bad.c_str(), "w");
+    ASSERT_NE(f, nullptr);
+    fputs("not a heap", f);
+    fclose(f);
+    err = memkind_create_pmem_persistent(bad.c_str(), PERSISTENT_SIZE, &kind);
+    unlink(bad.c_str());
+    ASSERT_EQ(err, MEMKIND_ERROR_INVALID);
+}
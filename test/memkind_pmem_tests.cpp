@@ -2,6 +2,7 @@
 /* Copyright (C) 2015 - 2021 Intel Corporation. */
 
 #include "allocator_perf_tool/TimerSysTime.hpp"
+#include <memkind/internal/memkind_memcpy.h>
 #include <memkind/internal/memkind_pmem.h>
 #include <memkind/internal/memkind_private.h>
 
@@ -184,6 +185,84 @@ TEST_F(MemkindPmemTests, test_TC_MEMKIND_PmemMalloc)
     ASSERT_EQ(nullptr, default_str);
 }
 
+TEST_F(MemkindPmemTests, test_TC_MEMKIND_PmemPersist)
+{
+    const size_t size = 64 * KB;
+    char *ptr = static_cast<char *>(memkind_malloc(pmem_kind, size));
+    ASSERT_NE(ptr, nullptr);
+
+    memset(ptr, 'a', size);
+    // range not aligned to cache line nor page
+    ASSERT_EQ(memkind_pmem_persist(pmem_kind, ptr + 3, size - 7),
+              MEMKIND_SUCCESS);
+    ASSERT_EQ(memkind_pmem_flush(pmem_kind, ptr, 1), MEMKIND_SUCCESS);
+    memkind_pmem_drain();
+    memkind_free(pmem_kind, ptr);
+
+    ptr = static_cast<char *>(memkind_malloc(MEMKIND_DEFAULT, size));
+    ASSERT_NE(ptr, nullptr);
+    ASSERT_EQ(memkind_pmem_persist(MEMKIND_DEFAULT, ptr, size),
+              MEMKIND_ERROR_INVALID);
+    // memory outside of mappings of kind
+    ASSERT_EQ(memkind_pmem_flush(pmem_kind, ptr, size), MEMKIND_ERROR_INVALID);
+    // cache flush instructions work on any mapping
+    ASSERT_EQ(memkind_pmem_flush_range(true, ptr, size), MEMKIND_SUCCESS);
+    memkind_pmem_drain_stores();
+    memkind_free(MEMKIND_DEFAULT, ptr);
+}
+
+TEST_F(MemkindPmemTests, test_TC_MEMKIND_PmemMemcpyNonTemporal)
+{
+    const size_t size = MEMKIND_MEMCPY_NT_THRESHOLD + 4 * KB;
+    char *src = static_cast<char *>(memkind_malloc(MEMKIND_DEFAULT, size));
+    ASSERT_NE(src, nullptr);
+    char *dst = static_cast<char *>(memkind_malloc(pmem_kind, size));
+    ASSERT_NE(dst, nullptr);
+    ASSERT_TRUE(memkind_memcpy_nt_enabled(pmem_kind, size));
+    ASSERT_FALSE(memkind_memcpy_nt_enabled(MEMKIND_DEFAULT, size));
+
+    for (size_t i = 0; i < size; ++i) {
+        src[i] = static_cast<char>(i % 251);
+    }
+    // unaligned head and tail, not multiple of line size
+    const size_t off = 13;
+    const size_t n = size - 2 * off - 7;
+    memset(dst, 'z', size);
+    ASSERT_EQ(memkind_memcpy(pmem_kind, dst + off, src + off + 1, n),
+              dst + off);
+    for (size_t i = 0; i < size; ++i) {
+        if (i < off || i >= off + n) {
+            ASSERT_EQ(dst[i], 'z');
+        } else {
+            ASSERT_EQ(dst[i], src[i + 1]);
+        }
+    }
+
+    ASSERT_EQ(memkind_memset(pmem_kind, dst + off, 0xab, n), dst + off);
+    for (size_t i = 0; i < size; ++i) {
+        ASSERT_EQ(dst[i], (i < off || i >= off + n) ? 'z' : '\xab');
+    }
+
+    // small sizes fall back to regular stores
+    for (size_t len = 0; len < 200; ++len) {
+        memkind_memcpy_nt(dst + 1, src, len);
+        ASSERT_EQ(memcmp(dst + 1, src, len), 0);
+    }
+
+    // large realloc moves data with non-temporal stores
+    memcpy(dst, src, size);
+    char *moved =
+        static_cast<char *>(memkind_realloc(pmem_kind, dst, 3 * size));
+    ASSERT_NE(moved, nullptr);
+    ASSERT_EQ(memcmp(moved, src, size), 0);
+    moved = static_cast<char *>(memkind_realloc(pmem_kind, moved, size));
+    ASSERT_NE(moved, nullptr);
+    ASSERT_EQ(memcmp(moved, src, size), 0);
+
+    memkind_free(pmem_kind, moved);
+    memkind_free(MEMKIND_DEFAULT, src);
+}
+
 TEST_F(MemkindPmemTests, test_TC_MEMKIND_PmemMallocZero)
 {
     void *test1 = nullptr;
@@ -1721,3 +1800,27 @@ TEST_F(MemkindPmemTests, test_TC_MEMKINDPmemDefragreallocate_success)
     err = memkind_destroy_kind(kind);
     ASSERT_EQ(err, 0);
 }
+
+TEST_F(MemkindPmemTests, test_TC_MEMKIND_PmemSetDecayAndPurge)
+{
+    struct memkind_pmem *priv = static_cast<memkind_pmem *>(pmem_kind->priv);
+
+    ASSERT_EQ(MEMKIND_SUCCESS, memkind_set_decay(pmem_kind, -1, -1));
+    void *ptr = memkind_malloc(pmem_kind, 4 * MB);
+    ASSERT_NE(nullptr, ptr);
+    memset(ptr, 'a', 4 * MB);
+    memkind_free(pmem_kind, ptr);
+    // with decay disabled, unused memory is kept by arena until purge
+    size_t size_before_purge = priv->current_size;
+    ASSERT_GE(size_before_purge, 4 * MB);
+
+    ASSERT_EQ(MEMKIND_SUCCESS, memkind_purge(pmem_kind));
+    ASSERT_LT(priv->current_size, size_before_purge);
+}
+
+TEST_F(MemkindPmemTests, test_TC_MEMKIND_PmemSetDecayInvalid)
+{
+    ASSERT_EQ(MEMKIND_ERROR_INVALID, memkind_set_decay(pmem_kind, -2, 0));
+    ASSERT_EQ(MEMKIND_ERROR_INVALID, memkind_set_decay(MEMKIND_DEFAULT, 0, 0));
+    ASSERT_EQ(MEMKIND_ERROR_INVALID, memkind_purge(MEMKIND_DEFAULT));
+}
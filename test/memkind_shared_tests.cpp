@@ -0,0 +1,187 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/* Copyright (C) 2022 Intel Corporation. */
+
+#include <memkind/internal/memkind_pmem_persistent.h>
+#include <memkind/internal/memkind_private.h>
+
+#include "common.h"
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+
+static const size_t SHARED_SIZE = 16 * MB;
+
+struct shared_msg {
+    size_t data_offset;  // written by parent
+    size_t reply_offset; // written by child
+};
+
+class MemkindSharedTests: public ::testing::Test
+{
+protected:
+    std::string name;
+
+    void SetUp()
+    {
+        name = "/memkind_shared_test." + std::to_string(getpid());
+        memkind_unlink_shared(name.c_str());
+    }
+
+    void TearDown()
+    {
+        memkind_unlink_shared(name.c_str());
+    }
+
+    size_t allocated(memkind_t kind)
+    {
+        size_t value = 0;
+        EXPECT_EQ(kind->ops->get_stat(kind, MEMKIND_STAT_TYPE_ALLOCATED,
+                                      &value),
+                  MEMKIND_SUCCESS);
+        return value;
+    }
+
+    void wait_child(pid_t pid)
+    {
+        int status;
+        ASSERT_EQ(waitpid(pid, &status, 0), pid);
+        ASSERT_TRUE(WIFEXITED(status));
+        ASSERT_EQ(WEXITSTATUS(status), 0);
+    }
+};
+
+TEST_F(MemkindSharedTests, test_TC_MEMKIND_SharedExchangeOffsets)
+{
+    memkind_t kind = nullptr;
+    int err = memkind_create_shared(name.c_str(), SHARED_SIZE, &kind);
+    ASSERT_EQ(err, MEMKIND_SUCCESS);
+
+    auto msg =
+        static_cast<shared_msg *>(memkind_calloc(kind, 1, sizeof(shared_msg)));
+    ASSERT_NE(msg, nullptr);
+    char *data = static_cast<char *>(memkind_malloc(kind, 1 * MB));
+    ASSERT_NE(data, nullptr);
+    memset(data, 'x', 1 * MB);
+    msg->data_offset = memkind_shared_get_offset(kind, data);
+    ASSERT_NE(msg->data_offset, 0U);
+    size_t msg_offset = memkind_shared_get_offset(kind, msg);
+    size_t used = allocated(kind);
+
+    pid_t pid = fork();
+    ASSERT_NE(pid, -1);
+    if (pid == 0) {
+        memkind_t child_kind = nullptr;
+        // size is ignored for existing heap
+        if (memkind_create_shared(name.c_str(), 0, &child_kind)) {
+            _exit(1);
+        }
+        auto child_msg = static_cast<shared_msg *>(
+            memkind_shared_get_ptr(child_kind, msg_offset));
+        char *child_data = static_cast<char *>(
+            memkind_shared_get_ptr(child_kind, child_msg->data_offset));
+        for (size_t i = 0; i < 1 * MB; ++i) {
+            if (child_data[i] != 'x') {
+                _exit(2);
+            }
+        }
+        memkind_free(child_kind, child_data);
+        char *reply = static_cast<char *>(memkind_malloc(child_kind, 64));
+        if (!reply) {
+            _exit(3);
+        }
+        strcpy(reply, "reply");
+        child_msg->reply_offset = memkind_shared_get_offset(child_kind, reply);
+        memkind_destroy_kind(child_kind);
+        _exit(0);
+    }
+    wait_child(pid);
+
+    // child freed data and allocated reply
+    ASSERT_LT(allocated(kind), used);
+    char *reply =
+        static_cast<char *>(memkind_shared_get_ptr(kind, msg->reply_offset));
+    ASSERT_NE(reply, nullptr);
+    ASSERT_STREQ(reply, "reply");
+    memkind_free(kind, reply);
+    memkind_free(kind, msg);
+    ASSERT_EQ(allocated(kind), 0U);
+    ASSERT_EQ(memkind_destroy_kind(kind), MEMKIND_SUCCESS);
+}
+
+TEST_F(MemkindSharedTests, test_TC_MEMKIND_SharedLockOwnerDied)
+{
+    memkind_t kind = nullptr;
+    int err = memkind_create_shared(name.c_str(), SHARED_SIZE, &kind);
+    ASSERT_EQ(err, MEMKIND_SUCCESS);
+
+    pid_t pid = fork();
+    ASSERT_NE(pid, -1);
+    if (pid == 0) {
+        memkind_t child_kind = nullptr;
+        if (memkind_create_shared(name.c_str(), 0, &child_kind)) {
+            _exit(1);
+        }
+        auto priv = static_cast<memkind_pmem_persistent *>(child_kind->priv);
+        // process dies holding lock of the heap
+        pthread_mutex_lock(priv->lock);
+        _exit(0);
+    }
+    wait_child(pid);
+
+    void *ptr = memkind_malloc(kind, 1 * KB);
+    ASSERT_NE(ptr, nullptr);
+    memkind_free(kind, ptr);
+    ASSERT_EQ(memkind_destroy_kind(kind), MEMKIND_SUCCESS);
+}
+
+// Heap which cannot be recovered after death of lock owner is not used.
+TEST_F(MemkindSharedTests, test_TC_MEMKIND_SharedLockOwnerDiedCorrupted)
+{
+    memkind_t kind = nullptr;
+    int err = memkind_create_shared(name.c_str(), SHARED_SIZE, &kind);
+    ASSERT_EQ(err, MEMKIND_SUCCESS);
+
+    pid_t pid = fork();
+    ASSERT_NE(pid, -1);
+    if (pid == 0) {
+        memkind_t child_kind = nullptr;
+        if (memkind_create_shared(name.c_str(), 0, &child_kind)) {
+            _exit(1);
+        }
+        auto priv = static_cast<memkind_pmem_persistent *>(child_kind->priv);
+        // process dies in the middle of update, leaving invalid first block
+        pthread_mutex_lock(priv->lock);
+        *reinterpret_cast<uint64_t *>(priv->base + 4096) = 1;
+        _exit(0);
+    }
+    wait_child(pid);
+
+    ASSERT_EQ(memkind_malloc(kind, 1 * KB), nullptr);
+    // lock is not recoverable, heap stays unusable
+    ASSERT_EQ(memkind_malloc(kind, 1 * KB), nullptr);
+    ASSERT_EQ(memkind_destroy_kind(kind), MEMKIND_SUCCESS);
+}
+
+TEST_F(MemkindSharedTests, test_TC_MEMKIND_SharedInvalid)
+{
+    memkind_t kind = nullptr;
+    // size of new heap is required
+    int err = memkind_create_shared(name.c_str(), 0, &kind);
+    ASSERT_EQ(err, MEMKIND_ERROR_INVALID);
+    // failed heap is removed
+    ASSERT_EQ(memkind_unlink_shared(name.c_str()), MEMKIND_ERROR_INVALID);
+
+    err = memkind_create_shared(name.c_str(), SHARED_SIZE, &kind);
+    ASSERT_EQ(err, MEMKIND_SUCCESS);
+    int local;
+    ASSERT_EQ(memkind_shared_get_offset(kind, &local), 0U);
+    ASSERT_EQ(memkind_shared_get_ptr(kind, SHARED_SIZE), nullptr);
+    ASSERT_EQ(memkind_shared_get_ptr(kind, 0), nullptr);
+    ASSERT_EQ(memkind_destroy_kind(kind), MEMKIND_SUCCESS);
+
+    void *ptr = memkind_malloc(MEMKIND_DEFAULT, 64);
+    ASSERT_NE(ptr, nullptr);
+    ASSERT_EQ(memkind_shared_get_offset(MEMKIND_DEFAULT, ptr), 0U);
+    ASSERT_EQ(memkind_shared_get_ptr(MEMKIND_DEFAULT, 4096), nullptr);
+    memkind_free(MEMKIND_DEFAULT, ptr);
+}
@@ -64,3 +64,83 @@ TEST_F(MemkindStatTests, test_TC_MEMKIND_GetGlobal)
         ASSERT_EQ(MEMKIND_SUCCESS, err);
     }
 }
+
+TEST_F(MemkindStatTests, test_TC_MEMKIND_StatsSnapshot)
+{
+    memkind_t kinds[] = {nullptr, MEMKIND_DEFAULT, MEMKIND_REGULAR};
+    const size_t n = sizeof(kinds) / sizeof(kinds[0]);
+    struct memkind_stats stats[n];
+    size_t value;
+
+    void *ptr = memkind_malloc(MEMKIND_REGULAR, 1 * MB);
+    ASSERT_NE(nullptr, ptr);
+    int err = memkind_get_stats_snapshot(kinds, n, stats);
+    ASSERT_EQ(MEMKIND_SUCCESS, err);
+
+    // snapshot is consistent with values of single statistics
+    for (size_t i = 0; i < n; ++i) {
+        for (int j = 0; j < MEMKIND_STAT_TYPE_MAX_VALUE; ++j) {
+            err = memkind_get_stat(kinds[i], static_cast<memkind_stat_type>(j),
+                                   &value);
+            ASSERT_EQ(MEMKIND_SUCCESS, err);
+            ASSERT_EQ(value, stats[i].stat[j]);
+        }
+    }
+    ASSERT_GE(stats[2].stat[MEMKIND_STAT_TYPE_ALLOCATED], 1 * MB);
+    memkind_free(MEMKIND_REGULAR, ptr);
+}
+
+struct ArenaStatsSummary {
+    memkind_t kind;
+    unsigned arenas;
+    size_t large_allocs;
+    size_t active;
+};
+
+static void arena_stats_cb(memkind_t kind,
+                           const struct memkind_arena_stats *stats, void *arg)
+{
+    ArenaStatsSummary *summary = static_cast<ArenaStatsSummary *>(arg);
+    if (kind != summary->kind) {
+        return;
+    }
+    summary->arenas++;
+    summary->active += stats->active;
+    for (unsigned i = 0; i < stats->nclasses; ++i) {
+        const struct memkind_size_class_stats *c = &stats->classes[i];
+        ASSERT_GE(c->nmalloc, c->ndalloc);
+        if (c->nregs == 0 && c->size >= 1 * MB) {
+            summary->large_allocs += c->curregs;
+        }
+    }
+}
+
+TEST_F(MemkindStatTests, test_TC_MEMKIND_ArenaStats)
+{
+    const int num_allocs = 4;
+    void *ptrs[num_allocs];
+    memkind_t kind = MEMKIND_REGULAR;
+
+    for (int i = 0; i < num_allocs; ++i) {
+        ptrs[i] = memkind_malloc(kind, 1 * MB);
+        ASSERT_NE(nullptr, ptrs[i]);
+    }
+
+    ArenaStatsSummary filtered = {kind, 0, 0, 0};
+    int err = memkind_get_arena_stats(&kind, 1, arena_stats_cb, &filtered);
+    ASSERT_EQ(MEMKIND_SUCCESS, err);
+    ASSERT_GT(filtered.arenas, 0U);
+    ASSERT_GE(filtered.large_allocs, static_cast<size_t>(num_allocs));
+    ASSERT_GE(filtered.active, num_allocs * MB);
+
+    // without filter all kinds are reported
+    ArenaStatsSummary all = {kind, 0, 0, 0};
+    err = memkind_get_arena_stats(nullptr, 0, arena_stats_cb, &all);
+    ASSERT_EQ(MEMKIND_SUCCESS, err);
+    ASSERT_EQ(filtered.arenas, all.arenas);
+    ASSERT_EQ(filtered.large_allocs, all.large_allocs);
+
+    for (int i = 0; i < num_allocs; ++i) {
+        memkind_free(kind, ptrs[i]);
+    }
+}
@@ -0,0 +1,68 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/* Copyright (C) 2022 Intel Corporation. */
+
+#include <memkind/internal/memkind_private.h>
+#include <memkind/internal/memkind_topology.h>
+
+#include "common.h"
+#include <numa.h>
+
+class MemkindTopologyTests: public ::testing::Test
+{
+};
+
+TEST_F(MemkindTopologyTests, test_TC_MEMKIND_TopologySharedNodes)
+{
+    for (int attr = 0; attr < TOPOLOGY_ATTR_MAX; ++attr) {
+        auto t_attr = static_cast<memkind_topology_attr_t>(attr);
+        const struct memkind_topology_nodes *t = memkind_topology_get(t_attr);
+        ASSERT_EQ(t, memkind_topology_get(t_attr));
+
+        struct bitmask *nodemask = numa_allocate_nodemask();
+        ASSERT_EQ(memkind_topology_set_nodemask(t_attr, NODE_VARIANT_MULTIPLE,
+                                                nodemask->maskp,
+                                                nodemask->size),
+                  t->err);
+        if (t->err) {
+            numa_bitmask_free(nodemask);
+            continue;
+        }
+        for (unsigned cpu = 0; cpu < t->num_cpus; ++cpu) {
+            struct bitmask cpu_mask = {t->mask_words * 8 * sizeof(long),
+                                       &t->masks[cpu * t->mask_words]};
+            ASSERT_EQ(numa_bitmask_weight(&cpu_mask), t->cpus[cpu].num);
+            for (unsigned i = 0; i < t->cpus[cpu].num; ++i) {
+                int node = t->nodes[t->cpus[cpu].first + i];
+                ASSERT_LE(node, numa_max_node());
+                ASSERT_TRUE(numa_bitmask_isbitset(&cpu_mask, node));
+            }
+        }
+        ASSERT_GT(numa_bitmask_weight(nodemask), 0U);
+        numa_bitmask_free(nodemask);
+    }
+}
+
+TEST_F(MemkindTopologyTests, test_TC_MEMKIND_TopologyLocalCapacity)
+{
+    const struct memkind_topology_nodes *t =
+        memkind_topology_get(TOPOLOGY_LOCAL_CAPACITY);
+    if (t->err) {
+        GTEST_SKIP() << "Local capacity nodes cannot be detected.";
+    }
+    ASSERT_TRUE(t->single);
+
+    struct bitmask *nodemask = numa_allocate_nodemask();
+    struct bitmask *kind_nodemask = numa_allocate_nodemask();
+    ASSERT_EQ(memkind_topology_set_nodemask(TOPOLOGY_LOCAL_CAPACITY,
+                                            NODE_VARIANT_SINGLE,
+                                            nodemask->maskp, nodemask->size),
+              MEMKIND_SUCCESS);
+    ASSERT_EQ(MEMKIND_HIGHEST_CAPACITY_LOCAL->ops->get_mbind_nodemask(
+                  MEMKIND_HIGHEST_CAPACITY_LOCAL, kind_nodemask->maskp,
+                  kind_nodemask->size),
+              MEMKIND_SUCCESS);
+    ASSERT_EQ(numa_bitmask_weight(nodemask), 1U);
+    ASSERT_TRUE(numa_bitmask_equal(nodemask, kind_nodemask));
+    numa_bitmask_free(kind_nodemask);
+    numa_bitmask_free(nodemask);
+}
@@ -0,0 +1,126 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/* Copyright (C) 2022 Intel Corporation. */
+
+#include <memkind.h>
+
+#include <chrono>
+#include <spawn.h>
+#include <sstream>
+#include <string>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <vector>
+
+#include "common.h"
+
+extern const char *PMEM_DIR;
+extern char **environ;
+
+// Test startup time of short-lived process with libmemtier preloaded.
+// Helper process either never calls allocator (cost of loading library only)
+// or makes one allocation (cost of tiers initialization on first allocation).
+// Test is expected to be run from top build directory (as tiering_tests.py).
+class MemtierInitPerfTest: public ::testing::Test
+{
+protected:
+    const char *libmemtier_path = "tiering/.libs/libmemtier.so";
+    const char *bin_path = "test/memtier_init_perf_test_helper";
+    const int runs = 100;
+
+    void SetUp()
+    {
+        struct stat st;
+        if (stat(libmemtier_path, &st) != 0 || !S_ISREG(st.st_mode)) {
+            GTEST_SKIP() << libmemtier_path << " is required." << std::endl;
+        }
+        if (stat(bin_path, &st) != 0 || !S_ISREG(st.st_mode)) {
+            GTEST_SKIP() << bin_path << " is required." << std::endl;
+        }
+        std::vector<std::string> no_env;
+        ASSERT_EQ(0, measure_startup(no_env, false, ref_time));
+    }
+
+    // Spawn bin_path runs times with additional env vars, returns average
+    // startup time in seconds.
+    int measure_startup(const std::vector<std::string> &extra_env, bool alloc,
+                        double &avg_time)
+    {
+        std::vector<std::string> env_str(extra_env);
+        for (char **env = environ; *env; ++env) {
+            env_str.push_back(*env);
+        }
+        std::vector<char *> envp;
+        for (auto &var : env_str) {
+            envp.push_back(const_cast<char *>(var.c_str()));
+        }
+        envp.push_back(nullptr);
+        char *argv[] = {const_cast<char *>(bin_path),
+                        const_cast<char *>(alloc ? "alloc" : "none"), nullptr};
+
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < runs; ++i) {
+            pid_t pid;
+            int status;
+            if (posix_spawn(&pid, bin_path, nullptr, nullptr, argv,
+                            envp.data()) != 0) {
+                return -1;
+            }
+            if (waitpid(pid, &status, 0) != pid || !WIFEXITED(status) ||
+                WEXITSTATUS(status) != 0) {
+                return -1;
+            }
+        }
+        std::chrono::duration<double> elapsed =
+            std::chrono::steady_clock::now() - start;
+        avg_time = elapsed.count() / runs;
+        return 0;
+    }
+
+    void run_test(const std::string &tiers)
+    {
+        std::vector<std::string> env = {
+            std::string("LD_PRELOAD=") + libmemtier_path,
+            "MEMKIND_MEM_TIERS=" + tiers};
+        double load_time, init_time;
+        if (measure_startup(env, false, load_time) != 0 ||
+            measure_startup(env, true, init_time) != 0) {
+            GTEST_SKIP() << "Cannot start " << bin_path
+                         << " with MEMKIND_MEM_TIERS=" << tiers << std::endl;
+        }
+
+        std::stringstream elapsed_time;
+        elapsed_time << init_time;
+        std::stringstream ref_delta_time;
+        ref_delta_time << std::fixed
+                       << (load_time - ref_time) / ref_time * 100.0;
+        std::stringstream tiers_init_time;
+        tiers_init_time << init_time - load_time;
+
+        RecordProperty("elapsed_time", elapsed_time.str());
+        // load of library alone, process does not allocate
+        RecordProperty("ref_delta_time_percent_rate", ref_delta_time.str());
+        // tiers initialization done on first allocation
+        RecordProperty("tiers_init_time", tiers_init_time.str());
+    }
+
+    double ref_time;
+};
+
+TEST_F(MemtierInitPerfTest, test_TC_MEMKIND_perf_memtier_init_DRAM)
+{
+    run_test("KIND:DRAM,RATIO:1;POLICY:STATIC_RATIO");
+}
+
+TEST_F(MemtierInitPerfTest, test_TC_MEMKIND_perf_memtier_init_FS_DAX)
+{
+    run_test(std::string("KIND:DRAM,RATIO:1;KIND:FS_DAX,PATH:") + PMEM_DIR +
+             ",PMEM_SIZE_LIMIT:0,RATIO:4;POLICY:STATIC_RATIO");
+}
+
+TEST_F(MemtierInitPerfTest, test_TC_MEMKIND_perf_memtier_init_KMEM_DAX)
+{
+    if (memkind_check_available(MEMKIND_DAX_KMEM)) {
+        GTEST_SKIP() << "DAX KMEM is required." << std::endl;
+    }
+    run_test("KIND:DRAM,RATIO:1;KIND:KMEM_DAX,RATIO:4;POLICY:STATIC_RATIO");
+}
@@ -0,0 +1,17 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/* Copyright (C) 2022 Intel Corporation. */
+
+#include <stdlib.h>
+#include <string.h>
+
+// Helper of memtier_init_perf_test: with "alloc" argument it makes a single
+// allocation, otherwise it exits without calling allocator at all, so the
+// difference shows cost of tiers initialization done on first allocation.
+int main(int argc, char *argv[])
+{
+    if (argc == 2 && strcmp(argv[1], "alloc") == 0) {
+        void *volatile ptr = malloc(64);
+        free(ptr);
+    }
+    return 0;
+}
@@ -6,6 +6,7 @@
 #include "allocator_perf_tool/Stats.hpp"
 #include "allocator_perf_tool/TaskFactory.hpp"
 #include "allocator_perf_tool/Thread.hpp"
+#include "allocator_perf_tool/TimerSysTime.hpp"
 #include "common.h"
 
 static const size_t PMEM_PART_SIZE = 0;
@@ -412,3 +413,41 @@ TEST_F(PmemAllocPerformanceTest,
     run_test(AllocatorTypes::MEMKIND_PMEM, FunctionCalls::REALLOC, 72, 1572864,
              10000);
 }
+
+// compares copy of large buffers to PMEM kind with non-temporal stores and
+// plain memcpy()
+TEST_F(PmemAllocPerformanceTest,
+       test_TC_MEMKIND_MEMKIND_PMEM_memcpy_non_temporal_64_MB)
+{
+    const size_t size = 64 * MB;
+    const int iterations = 20;
+    TimerSysTime timer;
+
+    char *src = static_cast<char *>(memkind_malloc(MEMKIND_DEFAULT, size));
+    ASSERT_NE(nullptr, src);
+    char *dst = static_cast<char *>(memkind_malloc(MEMKIND_PMEM_MOCKUP, size));
+    ASSERT_NE(nullptr, dst);
+    memset(src, 'a', size);
+    memset(dst, 'b', size);
+
+    timer.start();
+    for (int i = 0; i < iterations; ++i) {
+        memcpy(dst, src, size);
+    }
+    double ref_time = timer.getElapsedTime();
+
+    timer.start();
+    for (int i = 0; i < iterations; ++i) {
+        memkind_memcpy(MEMKIND_PMEM_MOCKUP, dst, src, size);
+    }
+    double perf_time = timer.getElapsedTime();
+    ASSERT_EQ(0, memcmp(dst, src, size));
+
+    GTestAdapter::RecordProperty("memcpy_time", ref_time);
+    GTestAdapter::RecordProperty("memkind_memcpy_time", perf_time);
+    GTestAdapter::RecordProperty("ref_delta_time_percent",
+                                 (perf_time - ref_time) / ref_time * 100.0);
+
+    memkind_free(MEMKIND_PMEM_MOCKUP, dst);
+    memkind_free(MEMKIND_DEFAULT, src);
+}
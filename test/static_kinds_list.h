@@ -26,4 +26,10 @@ static memkind_t static_kinds_list[] = {
     MEMKIND_LOWEST_LATENCY_LOCAL_PREFERRED,
     MEMKIND_HIGHEST_BANDWIDTH_LOCAL,
     MEMKIND_HIGHEST_BANDWIDTH_LOCAL_PREFERRED,
+    MEMKIND_DEFAULT_THP,
+    MEMKIND_HBW_THP,
+    MEMKIND_DAX_KMEM_THP,
+    MEMKIND_HUGETLB_1GB,
+    MEMKIND_HBW_HUGETLB_1GB,
+    MEMKIND_DAX_KMEM_HUGETLB_1GB,
 };
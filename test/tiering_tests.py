@@ -5,6 +5,7 @@ import os
 import pytest
 import re
 import subprocess
+import sys
 
 from python_framework import cmd_helper
 
@@ -548,3 +549,254 @@ class Test_tiering_config_env(Helper):
             + "RATIO:4;" + wrong_tier + ";" + self.default_policy,
             log_level="2",
             negative_test=True)
+
+
+class Test_tiering_mmap(Helper):
+
+    mmap_threshold_env_var = "MEMKIND_MEM_TIERING_MMAP_THRESHOLD"
+    tiers_config = "KIND:DRAM,RATIO:1;" + Helper.default_policy
+
+    def run_with_mmap_threshold(self, threshold, command, negative_test=False):
+        command = " ".join([self.ld_preload_env,
+                            self.log_prefix + "LOG_LEVEL=2",
+                            self.mem_tiers_env_var + '="' +
+                            self.tiers_config + '"',
+                            self.mmap_threshold_env_var + "=" + threshold,
+                            command])
+        output, retcode = self.cmd.execute_cmd(command)
+        fail_msg = "Execution of: '" + command + \
+            "' returns: " + str(retcode) + "\noutput: " + output
+        if negative_test:
+            assert retcode != 0, fail_msg
+        else:
+            assert retcode == 0, fail_msg
+        return output.splitlines()
+
+    @pytest.mark.parametrize("threshold", ["0", "-1", "abc", "1X"])
+    def test_negative_mmap_threshold(self, threshold):
+        self.run_with_mmap_threshold(threshold, self.bin_path,
+                                     negative_test=True)
+
+    def test_mmap_private_anonymous_placed(self):
+        size = 64 * 1024 * 1024
+        script = "import mmap; " \
+            "m = mmap.mmap(-1, {0}, flags=mmap.MAP_PRIVATE); m[0] = 1; " \
+            "m.close(); " \
+            "s = mmap.mmap(-1, {0}); s[0] = 1; s.close()".format(size)
+        output = self.run_with_mmap_threshold(
+            "32M", sys.executable + " -c '" + script + "'")
+
+        placed = [line for line in output if re.match(
+            self.log_debug_prefix + r"mmap region " + r"0[xX][a-fA-F0-9]+"
+            + " of size " + str(size) + " placed in kind: "
+            + self.kind_name_dict['DRAM'] + "$", line)]
+        # only private mapping is placed, shared one is left untouched
+        assert len(placed) == 1, "Bad mmap placement: " + "\n".join(output)
+
+    def test_mremap_partial_overlap(self):
+        # prints DRAM tier allocated size in MB after each step: middle part
+        # of tracked mapping is moved, then the moved part is grown, unmapped
+        # and finally rest of the mapping is unmapped
+        mb = 1024 * 1024
+        script = "import ctypes; c = ctypes.CDLL(None); " \
+            "vp, sz = ctypes.c_void_p, ctypes.c_size_t; " \
+            "c.mmap.restype = vp; " \
+            "c.mmap.argtypes = [vp, sz, ctypes.c_int, ctypes.c_int, " \
+            "ctypes.c_int, ctypes.c_long]; " \
+            "c.mremap.restype = vp; " \
+            "c.mremap.argtypes = [vp, sz, sz, ctypes.c_int, vp]; " \
+            "c.munmap.argtypes = [vp, sz]; " \
+            "c.memtier_kind_allocated_size.restype = sz; " \
+            "c.memtier_kind_allocated_size.argtypes = [vp]; " \
+            "dram = vp.in_dll(c, \"MEMKIND_DEFAULT\").value; " \
+            "base = c.memtier_kind_allocated_size(dram); " \
+            "size = lambda: print(round((" \
+            "c.memtier_kind_allocated_size(dram) - base) / {0})); " \
+            "a = c.mmap(None, 64 * {0}, 3, 0x22, -1, 0); size(); " \
+            "t = c.mmap(None, 16 * {0}, 3, 0x22, -1, 0); " \
+            "m = c.mremap(a + 16 * {0}, 16 * {0}, 16 * {0}, 3, t); size(); " \
+            "m = c.mremap(m, 16 * {0}, 32 * {0}, 1, None); size(); " \
+            "c.munmap(m, 32 * {0}); size(); " \
+            "c.munmap(a, 64 * {0}); size()".format(mb)
+        output = self.run_with_mmap_threshold(
+            "32M", sys.executable + " -c '" + script + "'")
+        sizes = [line for line in output
+                 if not line.startswith(self.log_prefix)]
+        assert sizes == ["64", "64", "80", "48", "0"], "\n".join(output)
+
+
+class Test_tiering_threads(Helper):
+
+    threads_env_var = "MEMKIND_MEM_TIERING_THREADS"
+    tiers_config = "KIND:DRAM,RATIO:1;" \
+        "KIND:FS_DAX,PATH:/tmp/,PMEM_SIZE_LIMIT:0,RATIO:1;" + \
+        Helper.default_policy
+    # prints for every allocation whether it was served by DRAM tier,
+    # thread is renamed with pthread_setname_np() before allocation; script
+    # exits with os._exit() as interpreter still uses FS_DAX allocations after
+    # libmemtier is unloaded
+    script = "import ctypes, os, sys; c = ctypes.CDLL(None); " \
+        "c.malloc.restype = ctypes.c_void_p; " \
+        "c.memkind_detect_kind.restype = ctypes.c_void_p; " \
+        "dram = ctypes.c_void_p.in_dll(c, \"MEMKIND_DEFAULT\").value; " \
+        "dram_alloc = lambda: c.memkind_detect_kind(" \
+        "ctypes.c_void_p(c.malloc(1024))) == dram; " \
+        "c.pthread_self.restype = ctypes.c_ulong; " \
+        "c.pthread_setname_np.argtypes = [ctypes.c_ulong, ctypes.c_char_p]; " \
+        "rename = lambda name: c.pthread_setname_np(c.pthread_self(), name); "
+
+    def run_with_threads(self, rules, script, negative_test=False):
+        command = " ".join([self.ld_preload_env,
+                            self.mem_tiers_env_var + '="' +
+                            self.tiers_config + '"',
+                            self.threads_env_var + '="' + rules + '"',
+                            sys.executable + " -c '" + self.script +
+                            script + "; sys.stdout.flush(); os._exit(0)'"])
+        output, retcode = self.cmd.execute_cmd(command)
+        fail_msg = "Execution of: '" + command + \
+            "' returns: " + str(retcode) + "\noutput: " + output
+        if negative_test:
+            assert retcode != 0, fail_msg
+        else:
+            assert retcode == 0, fail_msg
+        return [line for line in output.splitlines()
+                if not line.startswith(self.log_prefix)]
+
+    @pytest.mark.parametrize("rules", ["io", "io:", ":1", "io:-1", "io:a",
+                                       "io:0;;", "io:1x", "a" * 64 + ":0"])
+    def test_negative_thread_rules(self, rules):
+        self.run_with_threads(rules, "", negative_test=True)
+
+    def test_negative_thread_rule_tier_not_defined(self):
+        self.run_with_threads("io*:2", "", negative_test=True)
+
+    def test_thread_name_rules(self):
+        if not self.check_fs_dax_support():
+            pytest.skip("FS-DAX is required.")
+        output = self.run_with_threads(
+            "io_*:0;batch*:1",
+            "rename(b\"io_worker\"); "
+            "print(all(dram_alloc() for i in range(100))); "
+            "rename(b\"batch\"); "
+            "print(any(dram_alloc() for i in range(100)))")
+        assert output[-2:] == ["True", "False"], "\n".join(output)
+
+    def test_thread_set_tier(self):
+        if not self.check_fs_dax_support():
+            pytest.skip("FS-DAX is required.")
+        output = self.run_with_threads(
+            "io_*:0",
+            "rename(b\"io_worker\"); "
+            "print(c.memtier_thread_set_tier(1)); "
+            "print(any(dram_alloc() for i in range(100))); "
+            "print(c.memtier_thread_set_tier(-1)); "
+            "print(all(dram_alloc() for i in range(100))); "
+            "print(c.memtier_thread_set_tier(2))")
+        assert output[-5:] == ["0", "False", "0", "True", "22"], \
+            "\n".join(output)
+
+
+class Test_tiering_trace(Helper):
+
+    trace_env_var = "MEMKIND_MEM_TIERING_TRACE"
+    decoder_path = "utils/memtier_trace/memtier_trace_decoder"
+    replay_path = "utils/memtier_trace/memtier_trace_replay"
+    tiers_config = "KIND:DRAM,RATIO:1;" + Helper.default_policy
+    ops_num = 100
+    # every operation is done ops_num times with size which is not used by
+    # interpreter itself, so it could be found among other allocations
+    script = "import ctypes; c = ctypes.CDLL(None); " \
+        "c.malloc.restype = ctypes.c_void_p; " \
+        "c.calloc.restype = ctypes.c_void_p; " \
+        "c.realloc.restype = ctypes.c_void_p; " \
+        "c.realloc.argtypes = [ctypes.c_void_p, ctypes.c_size_t]; " \
+        "c.free.argtypes = [ctypes.c_void_p]; " \
+        "p = [c.malloc(12345) for i in range({0})]; " \
+        "p = [c.realloc(x, 23456) for x in p]; " \
+        "p += [c.calloc(3, 34567) for i in range({0})]; " \
+        "m = [ctypes.c_void_p() for i in range({0})]; " \
+        "[c.posix_memalign(ctypes.byref(x), 4096, 45678) for x in m]; " \
+        "[c.free(x) for x in p + [x.value for x in m]]"
+
+    # child process traces its allocations to separate file
+    fork_script = "import ctypes, os; c = ctypes.CDLL(None); " \
+        "c.malloc.restype = ctypes.c_void_p; " \
+        "c.free.argtypes = [ctypes.c_void_p]; " \
+        "pid = os.fork(); " \
+        "[c.free(c.malloc(56789)) for i in range({0}) if pid == 0]; " \
+        "pid and (print(pid), os.waitpid(pid, 0))"
+
+    def record(self, tmpdir, script=script):
+        trace_path = str(tmpdir.join("trace.bin"))
+        command = " ".join([self.ld_preload_env,
+                            self.mem_tiers_env_var + '="' +
+                            self.tiers_config + '"',
+                            self.trace_env_var + "=" + trace_path,
+                            sys.executable + ' -c "' +
+                            script.format(self.ops_num) + '"'])
+        output, retcode = self.cmd.execute_cmd(command)
+        assert retcode == 0, "Execution of: '" + command + \
+            "' returns: " + str(retcode) + "\noutput: " + output
+        if not os.path.exists(trace_path):
+            pytest.skip("Tracing requires memkind built with "
+                        "--enable-decorators.")
+        self.output = output.splitlines()
+        return trace_path
+
+    def run_tool(self, command):
+        output, retcode = self.cmd.execute_cmd(command)
+        assert retcode == 0, "Execution of: '" + command + \
+            "' returns: " + str(retcode) + "\noutput: " + output
+        return output.splitlines()
+
+    def test_trace_decode_replay(self, tmpdir):
+        trace_path = self.record(tmpdir)
+
+        output = self.run_tool(self.decoder_path + " " + trace_path)
+        summary_idx = output.index("Summary:")
+        records = output[:summary_idx]
+        summary = dict(line.split(": ") for line in output[summary_idx + 1:])
+        counts = {op: int(num) for op, num in summary.items()}
+        assert counts["dropped"] == 0, "\n".join(output[summary_idx:])
+
+        # every record is printed in single line and counted in summary
+        assert len(records) == sum(counts.values()), \
+            "\n".join(output[summary_idx:])
+        assert all(re.match(r"\d+ \d+ tid:\d+ \w+ \S+", line)
+                   for line in records), "Bad record format"
+
+        # interpreter allocations are traced as well, so only operations
+        # done by the script are counted here
+        def ops(pattern):
+            return len([line for line in records if re.search(pattern, line)])
+        assert ops(r" malloc kind:\w+ size:12345 ") == self.ops_num
+        assert ops(r" realloc kind:\w+ old_ptr:\S+ size:23456 ") == \
+            self.ops_num
+        assert ops(r" realloc_begin kind:\w+ ptr:\S+ size:23456$") == \
+            self.ops_num
+        assert ops(r" calloc kind:\w+ num:3 size:34567 ") == self.ops_num
+        assert ops(r" posix_memalign kind:\w+ alignment:4096 size:45678 ") \
+            == self.ops_num
+        assert counts["free"] >= 3 * self.ops_num
+
+        output = self.run_tool(self.replay_path + " " + trace_path)
+        replayed = [int(line.split(": ")[1]) for line in output
+                    if line.startswith("Operations: ")]
+        assert replayed and replayed[0] >= 5 * self.ops_num, \
+            "\n".join(output)
+        assert not [line for line in output if "live object" in line], \
+            "\n".join(output)
+
+    def test_trace_fork(self, tmpdir):
+        trace_path = self.record(tmpdir, self.fork_script)
+        child_trace_path = trace_path + "." + self.output[-1]
+        assert os.path.exists(child_trace_path), "\n".join(self.output)
+
+        output = self.run_tool(self.decoder_path + " " + child_trace_path)
+        assert "dropped: 0" in output, "\n".join(output)
+        assert len([line for line in output
+                    if re.search(r" malloc kind:\w+ size:56789 ", line)]) \
+            == self.ops_num
+
+        output = self.run_tool(self.decoder_path + " " + trace_path)
+        assert not [line for line in output if " size:56789 " in line]
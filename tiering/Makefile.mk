@@ -9,9 +9,11 @@ tiering_libmemtier_la_SOURCES = tiering/ctl.c \
                   tiering/memtier.c \
                   tiering/memtier_log.c \
                   tiering/memtier_log.h \
+                  tiering/memtier_trace.c \
+                  tiering/memtier_trace.h \
                   # end
 
-tiering_libmemtier_la_LIBADD = libmemkind.la
+tiering_libmemtier_la_LIBADD = libmemkind.la -ldl
 
 clean-local: tiering-clean
 
@@ -2,9 +2,11 @@
 /* Copyright (C) 2021-2022 Intel Corporation. */
 
 #include <memkind_memtier.h>
+#include <tiering/ctl.h>
 #include <tiering/memtier_log.h>
 
 #include <errno.h>
+#include <fnmatch.h>
 #include <limits.h>
 #include <regex.h>
 #include <stddef.h>
@@ -17,7 +19,7 @@
 #define CTL_STRING_QUERY_SEPARATOR ";"
 
 #define MAX_ENV_STRING 1024
-#define MAX_KIND       255
+#define MAX_KIND       CTL_MAX_TIERS
 #define MAX_CTL_NAME   64
 
 #define CTL_THRES_VAL 0U
@@ -67,7 +69,8 @@ static int ctl_parse_u(const char *str, unsigned *dest)
     errno = 0;
     unsigned long val_ul = strtoul(str, &endptr, 0);
 
-    if (endptr == str || errno != 0 || val_ul > UINT_MAX) {
+    if (endptr == str || *endptr != '\0' || errno != 0 ||
+        val_ul > UINT_MAX) {
         errno = olderrno;
         return -1;
     }
@@ -410,7 +413,72 @@ static int ctl_parse_threshold_query(char *qbuf, int threshold_id,
     return 0;
 }
 
-struct memtier_memory *ctl_create_tier_memory_from_env(char *env_var_string)
+int ctl_parse_thread_tiers(char *env_var_string, struct ctl_thread_tier *rules,
+                           unsigned *rules_num)
+{
+    char env_var_local[MAX_ENV_STRING] = {0};
+    strncpy(env_var_local, env_var_string, MAX_ENV_STRING - 1);
+
+    // strsep keeps empty rules between adjacent separators, so they are
+    // rejected instead of being skipped
+    char *sptr = env_var_local;
+    unsigned num = 0;
+    char *qbuf;
+
+    while ((qbuf = strsep(&sptr, CTL_STRING_QUERY_SEPARATOR)) != NULL) {
+        char *sep = strrchr(qbuf, *CTL_VALUE_SEPARATOR);
+        if (num == CTL_MAX_THREAD_RULES) {
+            log_err("Too many thread rules defined");
+            return -1;
+        }
+        if (sep == NULL || sep == qbuf ||
+            sep - qbuf >= CTL_MAX_THREAD_PATTERN) {
+            log_err("Invalid thread rule: %s", qbuf);
+            return -1;
+        }
+        *sep = '\0';
+        if (ctl_parse_u(sep + 1, &rules[num].tier)) {
+            log_err("Unsupported tier: %s", sep + 1);
+            return -1;
+        }
+        strcpy(rules[num].pattern, qbuf);
+        ++num;
+    }
+
+    *rules_num = num;
+    return 0;
+}
+
+int ctl_match_thread_tier(const char *thread_name,
+                          const struct ctl_thread_tier *rules,
+                          unsigned rules_num)
+{
+    unsigned i;
+    for (i = 0; i < rules_num; ++i) {
+        if (fnmatch(rules[i].pattern, thread_name, 0) == 0)
+            return rules[i].tier;
+    }
+    return -1;
+}
+
+int ctl_parse_mmap_threshold(char *env_var_string, size_t *threshold)
+{
+    char env_var_local[MAX_ENV_STRING] = {0};
+    strncpy(env_var_local, env_var_string, MAX_ENV_STRING - 1);
+    char *sptr = env_var_local;
+
+    int ret = ctl_parse_size(&sptr, threshold);
+    if (ret != 0 || *threshold == 0) {
+        log_err("Unsupported mmap threshold: %s", env_var_string);
+        return -1;
+    }
+
+    return 0;
+}
+
+struct memtier_memory *ctl_create_tier_memory_from_env(char *env_var_string,
+                                                       memkind_t *tier_kinds,
+                                                       unsigned *tier_num)
 {
     char env_var_local[MAX_ENV_STRING] = {0};
     strncpy(env_var_local, env_var_string, MAX_ENV_STRING - 1);
@@ -539,6 +607,10 @@ struct memtier_memory *ctl_create_tier_memory_from_env(char *env_var_string)
     }
 
     memtier_builder_delete(builder);
+    for (i = 0; i < tier_count; ++i) {
+        tier_kinds[i] = temp_cfg[i].kind;
+    }
+    *tier_num = tier_count;
     return tier_memory;
 
 destroy_builder:
@@ -6,8 +6,30 @@
 extern "C" {
 #endif
 
-struct memtier_memory *ctl_create_tier_memory_from_env(char *env_var_string);
+#include <memkind.h>
+
+#include <stddef.h>
+
+#define CTL_MAX_TIERS          255
+#define CTL_MAX_THREAD_RULES   64
+#define CTL_MAX_THREAD_PATTERN 64
+
+// thread name pattern (fnmatch syntax) and tier index it is pinned to
+struct ctl_thread_tier {
+    char pattern[CTL_MAX_THREAD_PATTERN];
+    unsigned tier;
+};
+
+struct memtier_memory *ctl_create_tier_memory_from_env(char *env_var_string,
+                                                       memkind_t *tier_kinds,
+                                                       unsigned *tier_num);
 void ctl_destroy_tier_memory(struct memtier_memory *kind);
+int ctl_parse_mmap_threshold(char *env_var_string, size_t *threshold);
+int ctl_parse_thread_tiers(char *env_var_string, struct ctl_thread_tier *rules,
+                           unsigned *rules_num);
+int ctl_match_thread_tier(const char *thread_name,
+                          const struct ctl_thread_tier *rules,
+                          unsigned rules_num);
 
 #ifdef __cplusplus
 }
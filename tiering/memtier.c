@@ -2,12 +2,24 @@
 /* Copyright (C) 2021-2022 Intel Corporation. */
 
 #include "../config.h"
+#include <memkind/internal/memkind_private.h>
 #include <memkind_memtier.h>
+#include <memtier.h>
 #include <tiering/ctl.h>
 #include <tiering/memtier_log.h>
 
+#include <dlfcn.h>
+#include <errno.h>
+#include <link.h>
 #include <pthread.h>
+#include <sched.h>
+#include <stdarg.h>
+#include <stdint.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
 
 #define MEMTIER_EXPORT __attribute__((visibility("default")))
 #define MEMTIER_INIT   __attribute__((constructor))
@@ -28,23 +40,50 @@
 #define mt_malloc_usable_size MT_SYMBOL(malloc_usable_size)
 
 #ifdef MEMKIND_DECORATION_ENABLED
-#include <memkind/internal/memkind_private.h>
+#include <tiering/memtier_trace.h>
+
 MEMTIER_EXPORT void memtier_kind_malloc_post(struct memkind *kind, size_t size,
                                              void **result)
 {
+    if (memtier_trace_enabled()) {
+        memtier_trace_event(MEMTIER_TRACE_OP_MALLOC, kind->partition,
+                            kind->name, *result, size, 0);
+        return;
+    }
     log_debug("kind: %s, malloc:(%zu) = %p", kind->name, size, *result);
 }
 
 MEMTIER_EXPORT void memtier_kind_calloc_post(memkind_t kind, size_t num,
                                              size_t size, void **result)
 {
+    if (memtier_trace_enabled()) {
+        memtier_trace_event(MEMTIER_TRACE_OP_CALLOC, kind->partition,
+                            kind->name, *result, size, num);
+        return;
+    }
     log_debug("kind: %s, calloc:(%zu, %zu) = %p", kind->name, num, size,
               *result);
 }
 
+MEMTIER_EXPORT void memtier_kind_realloc_pre(struct memkind *kind, void **ptr,
+                                             size_t *size)
+{
+    // old block could be reused by other thread before post hook is called,
+    // so realloc is ordered with that thread's allocation here
+    if (memtier_trace_enabled()) {
+        memtier_trace_event(MEMTIER_TRACE_OP_REALLOC_BEGIN, kind->partition,
+                            kind->name, *ptr, *size, 0);
+    }
+}
+
 MEMTIER_EXPORT void memtier_kind_realloc_post(struct memkind *kind, void *ptr,
                                               size_t size, void **result)
 {
+    if (memtier_trace_enabled()) {
+        memtier_trace_event(MEMTIER_TRACE_OP_REALLOC, kind->partition,
+                            kind->name, *result, size, (uintptr_t)ptr);
+        return;
+    }
     log_debug("kind: %s, realloc(%p, %zu) = %p", kind->name, ptr, size,
               *result);
 }
@@ -54,12 +93,24 @@ MEMTIER_EXPORT void memtier_kind_posix_memalign_post(memkind_t kind,
                                                      size_t alignment,
                                                      size_t size, int *err)
 {
+    if (memtier_trace_enabled()) {
+        memtier_trace_event(MEMTIER_TRACE_OP_POSIX_MEMALIGN, kind->partition,
+                            kind->name, *err ? NULL : *memptr, size,
+                            alignment);
+        return;
+    }
     log_debug("kind: %s, posix_memalign(%p, %zu, %zu) = %d", kind->name,
               *memptr, alignment, size, err);
 }
 
 MEMTIER_EXPORT void memtier_kind_free_pre(void **ptr)
 {
+    // kind detection is left to decoder, which matches ptr with allocation
+    if (memtier_trace_enabled()) {
+        memtier_trace_event(MEMTIER_TRACE_OP_FREE,
+                            MEMTIER_TRACE_UNKNOWN_PARTITION, NULL, *ptr, 0, 0);
+        return;
+    }
     struct memkind *kind = memkind_detect_kind(*ptr);
     if (kind)
         log_debug("kind: %s, free(%p)", kind->name, *ptr);
@@ -69,6 +120,12 @@ MEMTIER_EXPORT void memtier_kind_free_pre(void **ptr)
 
 MEMTIER_EXPORT void memtier_kind_usable_size_post(void **ptr, size_t size)
 {
+    if (memtier_trace_enabled()) {
+        memtier_trace_event(MEMTIER_TRACE_OP_USABLE_SIZE,
+                            MEMTIER_TRACE_UNKNOWN_PARTITION, NULL, *ptr, size,
+                            0);
+        return;
+    }
     struct memkind *kind = memkind_detect_kind(*ptr);
     if (kind)
         log_debug("kind: %s, malloc_usable_size(%p) = %zu", kind->name, *ptr,
@@ -82,10 +139,299 @@ static int destructed;
 
 static struct memtier_memory *current_memory;
 
+static char *tiers_env_var;
+static int tiers_initializing;
+static pthread_once_t tiers_once = PTHREAD_ONCE_INIT;
+
+// single tier memories used by threads pinned to one of MEMKIND_MEM_TIERS
+static struct memtier_memory *tier_memories[CTL_MAX_TIERS];
+static unsigned tier_num;
+
+static struct ctl_thread_tier thread_rules[CTL_MAX_THREAD_RULES];
+static unsigned thread_rules_num;
+
+typedef enum
+{
+    THREAD_NEW,
+    THREAD_REGISTERED,
+    THREAD_EXITED,
+} memtier_thread_state_t;
+
+struct memtier_thread_slot;
+
+/*
+ * Per-thread memory selection. memory caches memory used by allocation fast
+ * path, it is cleared (and resolved again on next allocation) when thread is
+ * renamed, pinned or library is unloaded.
+ */
+struct memtier_thread {
+    struct memtier_memory *memory;
+    struct memtier_memory *pinned;
+    int state;
+    struct memtier_thread_slot *slot;
+};
+
+typedef enum
+{
+    SLOT_FREE,   // could be claimed by new thread
+    SLOT_ACTIVE, // owned by running thread
+    SLOT_BUSY,   // TLS of owner is accessed by other thread
+} memtier_slot_state_t;
+
+/*
+ * Registry entry of thread which allocates through this library. Slots are
+ * never freed - starting thread claims free slot or pushes new one to the
+ * list without locking. Other threads access TLS of slot owner only while
+ * they hold the slot busy, exiting owner waits for them before its TLS is
+ * released.
+ */
+struct memtier_thread_slot {
+    struct memtier_thread *thread;
+    pthread_t id;
+    int state;
+    struct memtier_thread_slot *next;
+};
+
+static __thread struct memtier_thread t_thread;
+static struct memtier_thread_slot *thread_slots;
+static pthread_key_t threads_key;
+
+/*
+ * memtier_tiers_init -- (internal) creates kinds and tiered memory described
+ * in MEMKIND_MEM_TIERS; done on first allocation instead of at library load,
+ * so FS_DAX files and DAX KMEM topology discovery are not paid by processes
+ * that never allocate
+ */
+static void memtier_tiers_init(void)
+{
+    memkind_t tier_kinds[CTL_MAX_TIERS];
+    unsigned i;
+
+    __atomic_store_n(&tiers_initializing, 1, __ATOMIC_RELEASE);
+    struct memtier_memory *memory =
+        ctl_create_tier_memory_from_env(tiers_env_var, tier_kinds, &tier_num);
+    if (!memory) {
+        log_err("Error with parsing MEMKIND_MEM_TIERS");
+        abort();
+    }
+
+    for (i = 0; i < thread_rules_num; ++i) {
+        if (thread_rules[i].tier >= tier_num) {
+            log_err("Thread rule %s refers to not existing tier %u",
+                    thread_rules[i].pattern, thread_rules[i].tier);
+            abort();
+        }
+    }
+
+    for (i = 0; i < tier_num; ++i) {
+        struct memtier_builder *builder =
+            memtier_builder_new(MEMTIER_POLICY_STATIC_RATIO);
+        if (!builder || memtier_builder_add_tier(builder, tier_kinds[i], 1)) {
+            log_err("Failed to create memory of tier %u", i);
+            abort();
+        }
+        tier_memories[i] = memtier_builder_construct_memtier_memory(builder);
+        memtier_builder_delete(builder);
+        if (!tier_memories[i]) {
+            log_err("Failed to create memory of tier %u", i);
+            abort();
+        }
+    }
+
+    __atomic_store_n(&current_memory, memory, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&tiers_initializing, 0, __ATOMIC_RELEASE);
+}
+
+/*
+ * memtier_get_memory -- (internal) returns tiered memory or NULL when
+ * allocation must be served by bootstrap path (MEMKIND_DEFAULT) - library
+ * is not loaded yet, is already unloaded or request comes while tiered memory
+ * is being created
+ */
+static struct memtier_memory *memtier_get_memory(void)
+{
+    if (!tiers_env_var || destructed ||
+        __atomic_load_n(&tiers_initializing, __ATOMIC_ACQUIRE)) {
+        return NULL;
+    }
+    pthread_once(&tiers_once, memtier_tiers_init);
+    // pairs with memtier_fini(), which unpublishes memory and then looks for
+    // registered threads
+    return __atomic_load_n(&current_memory, __ATOMIC_SEQ_CST);
+}
+
+/*
+ * memtier_slot_lock -- (internal) makes TLS of slot owner accessible for
+ * calling thread, returns 0 when slot is free
+ */
+static int memtier_slot_lock(struct memtier_thread_slot *slot)
+{
+    int expected = SLOT_ACTIVE;
+    while (!__atomic_compare_exchange_n(&slot->state, &expected, SLOT_BUSY, 0,
+                                        __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+        if (expected == SLOT_FREE)
+            return 0;
+        expected = SLOT_ACTIVE;
+        sched_yield();
+    }
+    return 1;
+}
+
+static void memtier_slot_unlock(struct memtier_thread_slot *slot)
+{
+    __atomic_store_n(&slot->state, SLOT_ACTIVE, __ATOMIC_RELEASE);
+}
+
+static void memtier_thread_exit(void *arg)
+{
+    struct memtier_thread_slot *slot = arg;
+    int expected = SLOT_ACTIVE;
+
+    // wait for threads which access TLS of this thread
+    while (!__atomic_compare_exchange_n(&slot->state, &expected, SLOT_FREE, 0,
+                                        __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+        expected = SLOT_ACTIVE;
+        sched_yield();
+    }
+
+    // allocations from later TLS destructors are served by bootstrap path
+    t_thread.state = THREAD_EXITED;
+    t_thread.slot = NULL;
+    __atomic_store_n(&t_thread.memory, NULL, __ATOMIC_RELAXED);
+}
+
+static int memtier_thread_register(void)
+{
+    struct memtier_thread_slot *slot;
+
+    for (slot = __atomic_load_n(&thread_slots, __ATOMIC_ACQUIRE); slot;
+         slot = slot->next) {
+        int expected = SLOT_FREE;
+        if (__atomic_compare_exchange_n(&slot->state, &expected, SLOT_BUSY,
+                                        0, __ATOMIC_SEQ_CST,
+                                        __ATOMIC_RELAXED))
+            goto register_slot;
+    }
+
+    slot = memkind_malloc(MEMKIND_DEFAULT, sizeof(*slot));
+    if (!slot) {
+        return -1;
+    }
+    slot->state = SLOT_BUSY;
+    slot->next = __atomic_load_n(&thread_slots, __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n(&thread_slots, &slot->next, slot, 1,
+                                        __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+        ;
+
+register_slot:
+    slot->thread = &t_thread;
+    slot->id = pthread_self();
+    __atomic_store_n(&slot->state, SLOT_ACTIVE, __ATOMIC_SEQ_CST);
+
+    // set first, pthread_setspecific below might allocate
+    t_thread.state = THREAD_REGISTERED;
+    t_thread.slot = slot;
+    pthread_setspecific(threads_key, slot);
+    return 0;
+}
+
+/*
+ * memtier_thread_memory -- (internal) slow path of allocation, resolves
+ * memory of calling thread: pinned with API, matched by thread name or
+ * default tiered memory; result is cached in TLS
+ */
+static struct memtier_memory *memtier_thread_memory(void)
+{
+    if (t_thread.state == THREAD_EXITED) {
+        return NULL;
+    }
+    // thread is registered before it reads tiered memory, so memtier_fini()
+    // either finds it or this thread sees memory already unpublished
+    if (t_thread.state == THREAD_NEW && tiers_env_var &&
+        memtier_thread_register()) {
+        return NULL;
+    }
+
+    struct memtier_memory *memory = memtier_get_memory();
+    if (!memory) {
+        return NULL;
+    }
+
+    if (t_thread.pinned) {
+        memory = t_thread.pinned;
+    } else if (thread_rules_num) {
+        char name[16] = {0};
+        prctl(PR_GET_NAME, name);
+        int tier = ctl_match_thread_tier(name, thread_rules, thread_rules_num);
+        if (tier >= 0) {
+            memory = tier_memories[tier];
+        }
+    }
+
+    __atomic_store_n(&t_thread.memory, memory, __ATOMIC_RELAXED);
+    return memory;
+}
+
+MEMTIER_EXPORT int memtier_thread_set_tier(int tier)
+{
+    if (!memtier_get_memory()) {
+        return EAGAIN;
+    }
+    if (tier >= (int)tier_num) {
+        log_err("Tier %d is not defined in MEMKIND_MEM_TIERS", tier);
+        return EINVAL;
+    }
+
+    t_thread.pinned = tier < 0 ? NULL : tier_memories[tier];
+    __atomic_store_n(&t_thread.memory, NULL, __ATOMIC_RELAXED);
+    return 0;
+}
+
+MEMTIER_EXPORT void memtier_thread_set_memory(struct memtier_memory *memory)
+{
+    t_thread.pinned = memory;
+    __atomic_store_n(&t_thread.memory, NULL, __ATOMIC_RELAXED);
+}
+
+MEMTIER_EXPORT int pthread_setname_np(pthread_t thread, const char *name)
+{
+    static int (*real_setname)(pthread_t, const char *);
+    if (!real_setname) {
+        real_setname = dlsym(RTLD_NEXT, "pthread_setname_np");
+        if (!real_setname) {
+            return ENOSYS;
+        }
+    }
+
+    int ret = real_setname(thread, name);
+    if (ret == 0 && thread_rules_num) {
+        // renamed thread resolves its memory again on next allocation
+        struct memtier_thread_slot *slot;
+        for (slot = __atomic_load_n(&thread_slots, __ATOMIC_ACQUIRE); slot;
+             slot = slot->next) {
+            if (!memtier_slot_lock(slot))
+                continue;
+            int found = pthread_equal(slot->id, thread);
+            if (found)
+                __atomic_store_n(&slot->thread->memory, NULL,
+                                 __ATOMIC_RELAXED);
+            memtier_slot_unlock(slot);
+            if (found)
+                break;
+        }
+    }
+    return ret;
+}
+
 MEMTIER_EXPORT void *malloc(size_t size)
 {
-    if (MEMTIER_LIKELY(current_memory)) {
-        return memtier_malloc(current_memory, size);
+    struct memtier_memory *memory = t_thread.memory;
+    if (MEMTIER_LIKELY(memory)) {
+        return memtier_malloc(memory, size);
+    }
+    memory = memtier_thread_memory();
+    if (memory) {
+        return memtier_malloc(memory, size);
     } else if (destructed == 0) {
         return memkind_malloc(MEMKIND_DEFAULT, size);
     }
@@ -94,8 +440,13 @@ MEMTIER_EXPORT void *malloc(size_t size)
 
 MEMTIER_EXPORT void *calloc(size_t num, size_t size)
 {
-    if (MEMTIER_LIKELY(current_memory)) {
-        return memtier_calloc(current_memory, num, size);
+    struct memtier_memory *memory = t_thread.memory;
+    if (MEMTIER_LIKELY(memory)) {
+        return memtier_calloc(memory, num, size);
+    }
+    memory = memtier_thread_memory();
+    if (memory) {
+        return memtier_calloc(memory, num, size);
     } else if (destructed == 0) {
         return memkind_calloc(MEMKIND_DEFAULT, num, size);
     }
@@ -104,8 +455,13 @@ MEMTIER_EXPORT void *calloc(size_t num, size_t size)
 
 MEMTIER_EXPORT void *realloc(void *ptr, size_t size)
 {
-    if (MEMTIER_LIKELY(current_memory)) {
-        return memtier_realloc(current_memory, ptr, size);
+    struct memtier_memory *memory = t_thread.memory;
+    if (MEMTIER_LIKELY(memory)) {
+        return memtier_realloc(memory, ptr, size);
+    }
+    memory = memtier_thread_memory();
+    if (memory) {
+        return memtier_realloc(memory, ptr, size);
     } else if (destructed == 0) {
         return memkind_realloc(MEMKIND_DEFAULT, ptr, size);
     }
@@ -115,9 +471,13 @@ MEMTIER_EXPORT void *realloc(void *ptr, size_t size)
 // clang-format off
 MEMTIER_EXPORT int posix_memalign(void **memptr, size_t alignment, size_t size)
 {
-    if (MEMTIER_LIKELY(current_memory)) {
-        return memtier_posix_memalign(current_memory, memptr, alignment,
-                                          size);
+    struct memtier_memory *memory = t_thread.memory;
+    if (MEMTIER_LIKELY(memory)) {
+        return memtier_posix_memalign(memory, memptr, alignment, size);
+    }
+    memory = memtier_thread_memory();
+    if (memory) {
+        return memtier_posix_memalign(memory, memptr, alignment, size);
     } else if (destructed == 0) {
         return memkind_posix_memalign(MEMKIND_DEFAULT, memptr, alignment,
                                      size);
@@ -128,6 +488,7 @@ MEMTIER_EXPORT int posix_memalign(void **memptr, size_t alignment, size_t size)
 
 MEMTIER_EXPORT void free(void *ptr)
 {
+    // free never selects a tier, so it does not trigger tiers initialization
     if (MEMTIER_LIKELY(current_memory)) {
         memtier_realloc(current_memory, ptr, 0);
     } else if (destructed == 0) {
@@ -135,6 +496,361 @@ MEMTIER_EXPORT void free(void *ptr)
     }
 }
 
+// Anonymous private mappings bigger than mmap_threshold made by application
+// are placed with memtier policy and tracked in mmap_regions to release them
+// from tier accounting on munmap. Regions do not overlap and are kept sorted
+// by address.
+#define MMAP_REGIONS_INIT 512
+
+struct mmap_region {
+    uintptr_t addr;
+    size_t size;
+    memkind_t kind;
+};
+
+struct lib_range {
+    uintptr_t start;
+    uintptr_t end;
+};
+
+// interception is active only when MEMKIND_MEM_TIERING_MMAP_THRESHOLD is set,
+// otherwise calls are forwarded to libc
+static size_t mmap_threshold;
+static void *(*libc_mmap)(void *, size_t, int, int, int, off_t);
+static void *(*libc_mmap64)(void *, size_t, int, int, int, off_t);
+static int (*libc_munmap)(void *, size_t);
+static void *(*libc_mremap)(void *, size_t, size_t, int, ...);
+static struct lib_range memkind_lib_range;
+static struct lib_range memtier_lib_range;
+// table is mapped directly, allocating it would recurse into interceptors
+static struct mmap_region *mmap_regions;
+static unsigned mmap_regions_cap;
+// read without lock to skip lookups when nothing is tracked
+static unsigned mmap_regions_num;
+static pthread_mutex_t mmap_regions_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void *sys_mmap(void *addr, size_t length, int prot, int flags, int fd,
+                      off_t offset)
+{
+    return (void *)syscall(SYS_mmap, addr, length, prot, flags, fd, offset);
+}
+
+static int lib_range_find(struct dl_phdr_info *info, size_t size, void *arg)
+{
+    struct lib_range *range = arg;
+    uintptr_t start = UINTPTR_MAX, end = 0;
+    int i;
+
+    for (i = 0; i < info->dlpi_phnum; ++i) {
+        const ElfW(Phdr) *phdr = &info->dlpi_phdr[i];
+        if (phdr->p_type != PT_LOAD)
+            continue;
+        uintptr_t seg_start = info->dlpi_addr + phdr->p_vaddr;
+        uintptr_t seg_end = seg_start + phdr->p_memsz;
+        if (seg_start < start)
+            start = seg_start;
+        if (seg_end > end)
+            end = seg_end;
+    }
+    if (range->start < start || range->start >= end)
+        return 0;
+    range->start = start;
+    range->end = end;
+    return 1;
+}
+
+// finds address range of the library which contains symbol
+static int lib_range_init(const void *symbol, struct lib_range *range)
+{
+    range->start = (uintptr_t)symbol;
+    range->end = 0;
+    return dl_iterate_phdr(lib_range_find, range) ? 0 : -1;
+}
+
+// mappings made by memkind itself (e.g. jemalloc extents) or by this library
+// are not intercepted
+static int memtier_mmap_internal(const void *caller)
+{
+    uintptr_t addr = (uintptr_t)caller;
+    return (addr >= memkind_lib_range.start && addr < memkind_lib_range.end) ||
+        (addr >= memtier_lib_range.start && addr < memtier_lib_range.end);
+}
+
+// functions below are called with mmap_regions_lock held
+
+// returns index of the first region which ends after addr, searching in
+// [first, last) range of the table
+static unsigned mmap_regions_find(uintptr_t addr, unsigned first,
+                                  unsigned last)
+{
+    while (first < last) {
+        unsigned mid = first + (last - first) / 2;
+        if (mmap_regions[mid].addr + mmap_regions[mid].size <= addr)
+            first = mid + 1;
+        else
+            last = mid;
+    }
+    return first;
+}
+
+static int mmap_regions_insert(unsigned idx, uintptr_t addr, size_t size,
+                               memkind_t kind)
+{
+    if (mmap_regions_num == mmap_regions_cap) {
+        unsigned cap =
+            mmap_regions_cap ? 2 * mmap_regions_cap : MMAP_REGIONS_INIT;
+        size_t old_size = mmap_regions_cap * sizeof(struct mmap_region);
+        size_t new_size = cap * sizeof(struct mmap_region);
+        void *table = mmap_regions
+            ? (void *)syscall(SYS_mremap, mmap_regions, old_size, new_size,
+                              MREMAP_MAYMOVE)
+            : sys_mmap(NULL, new_size, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (table == MAP_FAILED) {
+            log_info("Cannot grow mmap regions table, %p is not tracked",
+                     (void *)addr);
+            return -1;
+        }
+        mmap_regions = table;
+        mmap_regions_cap = cap;
+    }
+
+    memmove(&mmap_regions[idx + 1], &mmap_regions[idx],
+            (mmap_regions_num - idx) * sizeof(struct mmap_region));
+    mmap_regions[idx].addr = addr;
+    mmap_regions[idx].size = size;
+    mmap_regions[idx].kind = kind;
+    __atomic_store_n(&mmap_regions_num, mmap_regions_num + 1,
+                     __ATOMIC_RELAXED);
+    return 0;
+}
+
+static void mmap_regions_remove(unsigned first, unsigned last)
+{
+    memmove(&mmap_regions[first], &mmap_regions[last],
+            (mmap_regions_num - last) * sizeof(struct mmap_region));
+    __atomic_store_n(&mmap_regions_num, mmap_regions_num - (last - first),
+                     __ATOMIC_RELAXED);
+}
+
+static void mmap_regions_reverse(unsigned first, unsigned last)
+{
+    while (first + 1 < last) {
+        struct mmap_region tmp = mmap_regions[first];
+        mmap_regions[first++] = mmap_regions[--last];
+        mmap_regions[last] = tmp;
+    }
+}
+
+// swaps [first, middle) and [middle, last) parts of the table
+static void mmap_regions_rotate(unsigned first, unsigned middle,
+                                unsigned last)
+{
+    mmap_regions_reverse(first, middle);
+    mmap_regions_reverse(middle, last);
+    mmap_regions_reverse(first, last);
+}
+
+// splits region which contains addr, so addr becomes a region boundary
+static void mmap_regions_split(uintptr_t addr)
+{
+    unsigned i = mmap_regions_find(addr, 0, mmap_regions_num);
+    if (i == mmap_regions_num || mmap_regions[i].addr >= addr)
+        return;
+
+    struct mmap_region region = mmap_regions[i];
+    uintptr_t end = region.addr + region.size;
+    mmap_regions[i].size = addr - region.addr;
+    if (mmap_regions_insert(i + 1, addr, end - addr, region.kind))
+        memtier_release_region(region.kind, end - addr);
+}
+
+// removes [addr, addr + length) from tracked regions, splitting them if
+// needed
+static void memtier_mmap_release(uintptr_t addr, size_t length)
+{
+    uintptr_t end = addr + length;
+    unsigned first, last;
+
+    mmap_regions_split(addr);
+    mmap_regions_split(end);
+    first = mmap_regions_find(addr, 0, mmap_regions_num);
+    for (last = first;
+         last < mmap_regions_num && mmap_regions[last].addr < end; ++last)
+        memtier_release_region(mmap_regions[last].kind,
+                               mmap_regions[last].size);
+    mmap_regions_remove(first, last);
+}
+
+// moves tracked parts of [old_addr, old_addr + old_size) remapped by mremap
+// to new_addr, they keep their kinds as NUMA policy moves with the mapping;
+// returns 1 when the end of old range is tracked, so part added by growing
+// the mapping belongs to tracked region
+static int memtier_mmap_move(uintptr_t old_addr, size_t old_size,
+                             uintptr_t new_addr, size_t new_size)
+{
+    uintptr_t old_end = old_addr + old_size;
+    unsigned first, last, i, n;
+    int tracked_end = 0;
+
+    // with MREMAP_FIXED mapping replaces whatever was mapped at new_addr
+    if (new_addr != old_addr)
+        memtier_mmap_release(new_addr, new_size);
+
+    mmap_regions_split(old_addr);
+    mmap_regions_split(old_end);
+    first = mmap_regions_find(old_addr, 0, mmap_regions_num);
+    for (last = first;
+         last < mmap_regions_num && mmap_regions[last].addr < old_end; ++last)
+        ;
+    if (last > first &&
+        mmap_regions[last - 1].addr + mmap_regions[last - 1].size == old_end)
+        tracked_end = 1;
+
+    // translate regions to new address, drop parts cut off by shrinking
+    for (i = first, n = first; i < last; ++i) {
+        struct mmap_region region = mmap_regions[i];
+        size_t offset = region.addr - old_addr;
+        if (offset >= new_size) {
+            memtier_release_region(region.kind, region.size);
+            continue;
+        }
+        if (offset + region.size > new_size) {
+            memtier_release_region(region.kind,
+                                   offset + region.size - new_size);
+            region.size = new_size - offset;
+        }
+        region.addr = new_addr + offset;
+        mmap_regions[n++] = region;
+    }
+    mmap_regions_remove(n, last);
+    last = n;
+
+    // restore table order when mapping was moved
+    if (new_addr < old_addr) {
+        unsigned pos = mmap_regions_find(new_addr, 0, first);
+        mmap_regions_rotate(pos, first, last);
+    } else if (new_addr > old_addr) {
+        unsigned pos = mmap_regions_find(new_addr, last, mmap_regions_num);
+        mmap_regions_rotate(first, last, pos);
+    }
+
+    return tracked_end && new_size > old_size;
+}
+
+static void memtier_mmap_place(void *addr, size_t length)
+{
+    struct memtier_memory *memory = t_thread.memory;
+    if (!memory) {
+        memory = memtier_thread_memory();
+        if (!memory) {
+            return;
+        }
+    }
+
+    pthread_mutex_lock(&mmap_regions_lock);
+    memkind_t kind = memtier_place_region(memory, addr, length);
+    if (kind) {
+        unsigned idx =
+            mmap_regions_find((uintptr_t)addr, 0, mmap_regions_num);
+        if (mmap_regions_insert(idx, (uintptr_t)addr, length, kind)) {
+            memtier_release_region(kind, length);
+        } else {
+            log_debug("mmap region %p of size %zu placed in kind: %s", addr,
+                      length, kind->name);
+        }
+    }
+    pthread_mutex_unlock(&mmap_regions_lock);
+}
+
+static void *memtier_mmap(void *addr, size_t length, int prot, int flags,
+                          int fd, off_t offset, const void *caller)
+{
+    void *ptr = sys_mmap(addr, length, prot, flags, fd, offset);
+    if (ptr == MAP_FAILED)
+        return ptr;
+
+    // fixed mapping replaces tracked regions in its range
+    if ((flags & MAP_FIXED) &&
+        __atomic_load_n(&mmap_regions_num, __ATOMIC_RELAXED)) {
+        pthread_mutex_lock(&mmap_regions_lock);
+        memtier_mmap_release((uintptr_t)ptr, length);
+        pthread_mutex_unlock(&mmap_regions_lock);
+    }
+
+    if (mmap_threshold && length >= mmap_threshold &&
+        (flags & (MAP_ANONYMOUS | MAP_PRIVATE)) ==
+            (MAP_ANONYMOUS | MAP_PRIVATE) &&
+        !(flags & MAP_STACK) && destructed == 0 &&
+        !memtier_mmap_internal(caller)) {
+        memtier_mmap_place(ptr, length);
+    }
+    return ptr;
+}
+
+MEMTIER_EXPORT void *mmap(void *addr, size_t length, int prot, int flags,
+                          int fd, off_t offset)
+{
+    if (!mmap_threshold && libc_mmap)
+        return libc_mmap(addr, length, prot, flags, fd, offset);
+    return memtier_mmap(addr, length, prot, flags, fd, offset,
+                        __builtin_return_address(0));
+}
+
+MEMTIER_EXPORT void *mmap64(void *addr, size_t length, int prot, int flags,
+                            int fd, off_t offset)
+{
+    if (!mmap_threshold && libc_mmap64)
+        return libc_mmap64(addr, length, prot, flags, fd, offset);
+    return memtier_mmap(addr, length, prot, flags, fd, offset,
+                        __builtin_return_address(0));
+}
+
+MEMTIER_EXPORT int munmap(void *addr, size_t length)
+{
+    if (!mmap_threshold && libc_munmap)
+        return libc_munmap(addr, length);
+
+    if (__atomic_load_n(&mmap_regions_num, __ATOMIC_RELAXED)) {
+        pthread_mutex_lock(&mmap_regions_lock);
+        memtier_mmap_release((uintptr_t)addr, length);
+        pthread_mutex_unlock(&mmap_regions_lock);
+    }
+    return syscall(SYS_munmap, addr, length);
+}
+
+MEMTIER_EXPORT void *mremap(void *old_addr, size_t old_size, size_t new_size,
+                            int flags, ...)
+{
+    void *new_addr = NULL;
+    if (flags & MREMAP_FIXED) {
+        va_list args;
+        va_start(args, flags);
+        new_addr = va_arg(args, void *);
+        va_end(args);
+    }
+
+    if (!mmap_threshold && libc_mremap)
+        return libc_mremap(old_addr, old_size, new_size, flags, new_addr);
+
+    void *ptr = (void *)syscall(SYS_mremap, old_addr, old_size, new_size,
+                                flags, new_addr);
+    if (ptr == MAP_FAILED ||
+        !__atomic_load_n(&mmap_regions_num, __ATOMIC_RELAXED)) {
+        return ptr;
+    }
+
+    pthread_mutex_lock(&mmap_regions_lock);
+    int grown = memtier_mmap_move((uintptr_t)old_addr, old_size,
+                                  (uintptr_t)ptr, new_size);
+    pthread_mutex_unlock(&mmap_regions_lock);
+    // part added to tracked region is placed with memtier policy
+    if (grown) {
+        memtier_mmap_place((char *)ptr + old_size, new_size - old_size);
+    }
+    return ptr;
+}
+
 MEMTIER_EXPORT size_t malloc_usable_size(void *ptr)
 {
     return memtier_usable_size(ptr);
@@ -147,16 +863,51 @@ static MEMTIER_INIT void memtier_init(void)
     pthread_once(&init_once, log_init_once);
     log_info("Memkind memtier lib loaded!");
 
-    char *env_var = utils_get_env("MEMKIND_MEM_TIERS");
-    if (env_var) {
-        current_memory = ctl_create_tier_memory_from_env(env_var);
-        if (current_memory) {
-            return;
+    char *trace_path = utils_get_env("MEMKIND_MEM_TIERING_TRACE");
+    if (trace_path) {
+#ifdef MEMKIND_DECORATION_ENABLED
+        memtier_trace_init(trace_path);
+#else
+        log_err("MEMKIND_MEM_TIERING_TRACE requires library built with "
+                "--enable-decorators");
+#endif
+    }
+
+    char *mmap_env_var = utils_get_env("MEMKIND_MEM_TIERING_MMAP_THRESHOLD");
+    if (mmap_env_var) {
+        size_t threshold;
+        if (ctl_parse_mmap_threshold(mmap_env_var, &threshold) ||
+            lib_range_init((void *)memkind_malloc, &memkind_lib_range) ||
+            lib_range_init((void *)memtier_init, &memtier_lib_range)) {
+            log_err("Error with parsing MEMKIND_MEM_TIERING_MMAP_THRESHOLD");
+            abort();
         }
-        log_err("Error with parsing MEMKIND_MEM_TIERS");
+        mmap_threshold = threshold;
     } else {
-        log_err("Missing MEMKIND_MEM_TIERS env var");
+        libc_mmap = dlsym(RTLD_NEXT, "mmap");
+        libc_mmap64 = dlsym(RTLD_NEXT, "mmap64");
+        libc_munmap = dlsym(RTLD_NEXT, "munmap");
+        libc_mremap = dlsym(RTLD_NEXT, "mremap");
+    }
+
+    char *threads_env_var = utils_get_env("MEMKIND_MEM_TIERING_THREADS");
+    if (threads_env_var &&
+        ctl_parse_thread_tiers(threads_env_var, thread_rules,
+                               &thread_rules_num)) {
+        log_err("Error with parsing MEMKIND_MEM_TIERING_THREADS");
+        abort();
+    }
+
+    if (pthread_key_create(&threads_key, memtier_thread_exit)) {
+        log_err("Cannot create thread key");
+        abort();
     }
+
+    tiers_env_var = utils_get_env("MEMKIND_MEM_TIERS");
+    if (tiers_env_var) {
+        return;
+    }
+    log_err("Missing MEMKIND_MEM_TIERS env var");
     abort();
 }
 
@@ -164,8 +915,41 @@ static MEMTIER_FINI void memtier_fini(void)
 {
     log_info("Unloading memkind memtier lib!");
 
-    ctl_destroy_tier_memory(current_memory);
-    current_memory = NULL;
+#ifdef MEMKIND_DECORATION_ENABLED
+    memtier_trace_fini();
+#endif
+
+    // unpublish memory and drop it from caches of all live threads; it is
+    // deleted only when no other thread is registered, as such thread might
+    // still be in the middle of allocation which uses it
+    struct memtier_memory *memory =
+        __atomic_exchange_n(&current_memory, NULL, __ATOMIC_SEQ_CST);
+    int in_use = 0;
+
+    struct memtier_thread_slot *slot;
+    for (slot = __atomic_load_n(&thread_slots, __ATOMIC_SEQ_CST); slot;
+         slot = slot->next) {
+        if (slot == t_thread.slot ||
+            __atomic_load_n(&slot->state, __ATOMIC_SEQ_CST) == SLOT_FREE ||
+            !memtier_slot_lock(slot))
+            continue;
+        __atomic_store_n(&slot->thread->memory, NULL, __ATOMIC_RELAXED);
+        slot->thread->pinned = NULL;
+        memtier_slot_unlock(slot);
+        in_use = 1;
+    }
+    __atomic_store_n(&t_thread.memory, NULL, __ATOMIC_RELAXED);
+    t_thread.pinned = NULL;
+
+    if (memory && !in_use) {
+        unsigned i;
+        for (i = 0; i < tier_num; ++i) {
+            memtier_delete_memtier_memory(tier_memories[i]);
+        }
+        ctl_destroy_tier_memory(memory);
+    } else if (memory) {
+        log_info("Tiered memory is left to running threads");
+    }
 
     destructed = 1;
 }
@@ -0,0 +1,428 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/* Copyright (C) 2022 Intel Corporation. */
+
+#include <memkind.h>
+#include <memkind/internal/memkind_private.h>
+#include <tiering/memtier_log.h>
+#include <tiering/memtier_trace.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+// number of records in per-thread ring buffer, has to be power of 2
+#define TRACE_BUF_RECORDS (1U << 14)
+#define TRACE_BUF_MASK    (TRACE_BUF_RECORDS - 1)
+// period of background writer drain
+#define TRACE_WRITER_PERIOD_NS (10 * 1000 * 1000)
+#define TRACE_CACHE_LINE       64
+
+typedef enum
+{
+    TRACE_BUF_ACTIVE, // owned by running thread
+    TRACE_BUF_EXITED, // owner thread exited, waits for final drain
+    TRACE_BUF_FREE,   // drained, could be reused by new thread
+} trace_buf_state_t;
+
+/*
+ * Single producer (owner thread) / single consumer (writer thread) ring
+ * buffer - producer moves head, consumer moves tail.
+ */
+struct trace_buffer {
+    struct memtier_trace_record records[TRACE_BUF_RECORDS];
+    uint64_t head __attribute__((aligned(TRACE_CACHE_LINE)));
+    uint64_t dropped;
+    // set while owner thread writes a record, awaited by fini
+    int busy;
+    uint64_t tail __attribute__((aligned(TRACE_CACHE_LINE)));
+    uint64_t reported_dropped;
+    uint32_t tid;
+    int state;
+    struct trace_buffer *next;
+};
+
+static int trace_active;
+static int trace_stop;
+static int trace_fd = -1;
+static char trace_path[PATH_MAX];
+static pthread_t trace_writer;
+static pthread_key_t trace_key;
+static struct trace_buffer *trace_buffers;
+// sentinel set for threads which are after TLS destruction
+static struct trace_buffer trace_buf_exited;
+static __thread struct trace_buffer *t_buf;
+// source of logical timestamps
+static uint64_t trace_seq;
+
+static char trace_kind_names[MEMKIND_MAX_KIND][MEMKIND_NAME_LENGTH_PRIV];
+// 0 - unknown, 1 - name is being copied, 2 - name published
+static int trace_kind_name_state[MEMKIND_MAX_KIND];
+// names already written to file, accessed only by writer
+static int trace_kind_name_written[MEMKIND_MAX_KIND];
+
+static uint64_t trace_timestamp(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static int trace_write_all(const void *buf, size_t count)
+{
+    const char *p = buf;
+    while (count) {
+        ssize_t ret = write(trace_fd, p, count);
+        if (ret < 0) {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        p += ret;
+        count -= ret;
+    }
+    return 0;
+}
+
+static void trace_thread_exit(void *arg)
+{
+    struct trace_buffer *buf = arg;
+    // events from later TLS destructors of this thread are dropped
+    t_buf = &trace_buf_exited;
+    __atomic_store_n(&buf->state, TRACE_BUF_EXITED, __ATOMIC_RELEASE);
+}
+
+static struct trace_buffer *trace_register_thread(void)
+{
+    struct trace_buffer *buf;
+    // mark thread to not recurse through allocations done below
+    t_buf = &trace_buf_exited;
+
+    for (buf = __atomic_load_n(&trace_buffers, __ATOMIC_ACQUIRE); buf;
+         buf = buf->next) {
+        int expected = TRACE_BUF_FREE;
+        if (__atomic_compare_exchange_n(&buf->state, &expected,
+                                        TRACE_BUF_ACTIVE, 0, __ATOMIC_ACQUIRE,
+                                        __ATOMIC_RELAXED))
+            goto register_buf;
+    }
+
+    buf = mmap(NULL, sizeof(struct trace_buffer), PROT_READ | PROT_WRITE,
+               MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (buf == MAP_FAILED) {
+        return NULL;
+    }
+    buf->state = TRACE_BUF_ACTIVE;
+    buf->next = __atomic_load_n(&trace_buffers, __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n(&trace_buffers, &buf->next, buf, 1,
+                                        __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+        ;
+
+register_buf:
+    buf->tid = syscall(SYS_gettid);
+    pthread_setspecific(trace_key, buf);
+    t_buf = buf;
+    return buf;
+}
+
+static void trace_publish_kind_name(unsigned partition, const char *name)
+{
+    int expected = 0;
+    if (__atomic_compare_exchange_n(&trace_kind_name_state[partition],
+                                    &expected, 1, 0, __ATOMIC_ACQUIRE,
+                                    __ATOMIC_RELAXED)) {
+        strncpy(trace_kind_names[partition], name,
+                MEMKIND_NAME_LENGTH_PRIV - 1);
+        __atomic_store_n(&trace_kind_name_state[partition], 2,
+                         __ATOMIC_RELEASE);
+    }
+}
+
+void memtier_trace_event(memtier_trace_op_t op, unsigned partition,
+                         const char *name, const void *ptr, uint64_t arg,
+                         uint64_t aux)
+{
+    if (!__atomic_load_n(&trace_active, __ATOMIC_RELAXED))
+        return;
+
+    struct trace_buffer *buf = t_buf;
+    if (!buf) {
+        buf = trace_register_thread();
+        if (!buf)
+            return;
+    }
+    if (buf == &trace_buf_exited)
+        return;
+
+    // pairs with fini: either fini sees the buffer busy and waits, or this
+    // thread sees tracing stopped
+    __atomic_store_n(&buf->busy, 1, __ATOMIC_SEQ_CST);
+    if (!__atomic_load_n(&trace_active, __ATOMIC_SEQ_CST))
+        goto done;
+
+    if (partition < MEMKIND_MAX_KIND) {
+        if (__atomic_load_n(&trace_kind_name_state[partition],
+                            __ATOMIC_RELAXED) == 0)
+            trace_publish_kind_name(partition, name);
+    } else {
+        partition = MEMTIER_TRACE_UNKNOWN_PARTITION;
+    }
+
+    uint64_t head = buf->head;
+    uint64_t tail = __atomic_load_n(&buf->tail, __ATOMIC_ACQUIRE);
+    if (head - tail >= TRACE_BUF_RECORDS) {
+        __atomic_store_n(&buf->dropped, buf->dropped + 1, __ATOMIC_RELAXED);
+        goto done;
+    }
+
+    struct memtier_trace_record *rec = &buf->records[head & TRACE_BUF_MASK];
+    rec->seq = __atomic_fetch_add(&trace_seq, 1, __ATOMIC_RELAXED);
+    rec->timestamp = trace_timestamp();
+    rec->ptr = (uintptr_t)ptr;
+    rec->arg = arg;
+    rec->aux = aux;
+    rec->tid = buf->tid;
+    rec->op = op;
+    rec->partition = partition;
+    __atomic_store_n(&buf->head, head + 1, __ATOMIC_RELEASE);
+
+done:
+    __atomic_store_n(&buf->busy, 0, __ATOMIC_RELEASE);
+}
+
+static void trace_write_kind_names(void)
+{
+    unsigned i;
+    for (i = 0; i < MEMKIND_MAX_KIND; ++i) {
+        if (trace_kind_name_written[i] ||
+            __atomic_load_n(&trace_kind_name_state[i], __ATOMIC_ACQUIRE) != 2)
+            continue;
+
+        // name is padded to multiple of record size
+        char payload[MEMKIND_NAME_LENGTH_PRIV +
+                     sizeof(struct memtier_trace_record)] = {0};
+        size_t len = strlen(trace_kind_names[i]);
+        size_t padded = (len + sizeof(struct memtier_trace_record) - 1) /
+            sizeof(struct memtier_trace_record) *
+            sizeof(struct memtier_trace_record);
+        memcpy(payload, trace_kind_names[i], len);
+
+        struct memtier_trace_record rec = {0};
+        rec.timestamp = trace_timestamp();
+        rec.arg = len;
+        rec.op = MEMTIER_TRACE_OP_KIND_NAME;
+        rec.partition = i;
+        trace_write_all(&rec, sizeof(rec));
+        trace_write_all(payload, padded);
+        trace_kind_name_written[i] = 1;
+    }
+}
+
+static void trace_drain_buffer(struct trace_buffer *buf)
+{
+    int state = __atomic_load_n(&buf->state, __ATOMIC_ACQUIRE);
+    if (state == TRACE_BUF_FREE)
+        return;
+
+    uint64_t head = __atomic_load_n(&buf->head, __ATOMIC_ACQUIRE);
+    uint64_t tail = buf->tail;
+    if (head != tail) {
+        trace_write_kind_names();
+
+        uint64_t first = tail & TRACE_BUF_MASK;
+        uint64_t count = head - tail;
+        uint64_t chunk = TRACE_BUF_RECORDS - first;
+        if (chunk > count)
+            chunk = count;
+        trace_write_all(&buf->records[first],
+                        chunk * sizeof(struct memtier_trace_record));
+        if (count > chunk)
+            trace_write_all(&buf->records[0],
+                            (count - chunk) *
+                                sizeof(struct memtier_trace_record));
+        __atomic_store_n(&buf->tail, head, __ATOMIC_RELEASE);
+    }
+
+    uint64_t dropped = __atomic_load_n(&buf->dropped, __ATOMIC_RELAXED);
+    if (dropped != buf->reported_dropped) {
+        struct memtier_trace_record rec = {0};
+        rec.timestamp = trace_timestamp();
+        rec.arg = dropped - buf->reported_dropped;
+        rec.tid = buf->tid;
+        rec.op = MEMTIER_TRACE_OP_DROPPED;
+        rec.partition = MEMTIER_TRACE_UNKNOWN_PARTITION;
+        trace_write_all(&rec, sizeof(rec));
+        buf->reported_dropped = dropped;
+    }
+
+    // all events of exited thread were published before state change
+    if (state == TRACE_BUF_EXITED)
+        __atomic_store_n(&buf->state, TRACE_BUF_FREE, __ATOMIC_RELEASE);
+}
+
+static void trace_drain_all(void)
+{
+    struct trace_buffer *buf;
+    for (buf = __atomic_load_n(&trace_buffers, __ATOMIC_ACQUIRE); buf;
+         buf = buf->next) {
+        trace_drain_buffer(buf);
+    }
+}
+
+static void *trace_writer_thread(void *arg)
+{
+    const struct timespec period = {0, TRACE_WRITER_PERIOD_NS};
+    // writer does not trace its own allocations
+    t_buf = &trace_buf_exited;
+
+    while (!__atomic_load_n(&trace_stop, __ATOMIC_ACQUIRE)) {
+        trace_drain_all();
+        nanosleep(&period, NULL);
+    }
+    trace_drain_all();
+    return NULL;
+}
+
+static int trace_open(const char *path)
+{
+    trace_fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (trace_fd == -1) {
+        log_err("Cannot open trace file %s: %s", path, strerror(errno));
+        return -1;
+    }
+
+    struct memtier_trace_header header = {
+        .magic = MEMTIER_TRACE_MAGIC,
+        .version = MEMTIER_TRACE_VERSION,
+        .record_size = sizeof(struct memtier_trace_record),
+    };
+    if (trace_write_all(&header, sizeof(header))) {
+        log_err("Cannot write trace file header: %s", strerror(errno));
+        close(trace_fd);
+        trace_fd = -1;
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * trace_atfork_child -- writer thread of parent process is not running in
+ * child, so child writes its own trace to file with ".<pid>" suffix; records
+ * of parent which are not drained yet are left to parent
+ */
+static void trace_atfork_child(void)
+{
+    struct trace_buffer *buf;
+    char path[PATH_MAX];
+    unsigned i;
+
+    if (!__atomic_load_n(&trace_active, __ATOMIC_RELAXED))
+        return;
+
+    for (buf = trace_buffers; buf; buf = buf->next) {
+        buf->tail = buf->head;
+        buf->dropped = 0;
+        buf->reported_dropped = 0;
+        buf->busy = 0;
+        // only thread which called fork exists in child
+        if (buf == t_buf)
+            buf->tid = syscall(SYS_gettid);
+        else if (buf->state != TRACE_BUF_FREE)
+            buf->state = TRACE_BUF_FREE;
+    }
+    for (i = 0; i < MEMKIND_MAX_KIND; ++i) {
+        trace_kind_name_written[i] = 0;
+        // name copied by other thread during fork is published again
+        if (trace_kind_name_state[i] == 1)
+            trace_kind_name_state[i] = 0;
+    }
+
+    close(trace_fd);
+    trace_fd = -1;
+    trace_active = 0;
+    trace_stop = 0;
+    if (snprintf(path, sizeof(path), "%s.%d", trace_path, (int)getpid()) >=
+        (int)sizeof(path)) {
+        log_err("Trace file path of child process is too long");
+        return;
+    }
+    if (trace_open(path))
+        return;
+    if (pthread_create(&trace_writer, NULL, trace_writer_thread, NULL)) {
+        log_err("Cannot create trace writer thread");
+        close(trace_fd);
+        trace_fd = -1;
+        return;
+    }
+    __atomic_store_n(&trace_active, 1, __ATOMIC_RELEASE);
+}
+
+int memtier_trace_init(const char *path)
+{
+    if (strlen(path) >= sizeof(trace_path)) {
+        log_err("Trace file path is too long");
+        return -1;
+    }
+    strcpy(trace_path, path);
+
+    if (trace_open(path))
+        return -1;
+
+    if (pthread_key_create(&trace_key, trace_thread_exit)) {
+        log_err("Cannot create trace thread key");
+        goto close_fd;
+    }
+
+    if (pthread_atfork(NULL, NULL, trace_atfork_child)) {
+        log_err("Cannot register trace fork handler");
+        pthread_key_delete(trace_key);
+        goto close_fd;
+    }
+
+    if (pthread_create(&trace_writer, NULL, trace_writer_thread, NULL)) {
+        log_err("Cannot create trace writer thread");
+        pthread_key_delete(trace_key);
+        goto close_fd;
+    }
+
+    __atomic_store_n(&trace_active, 1, __ATOMIC_RELEASE);
+    log_info("Tracing allocations to %s", path);
+    return 0;
+
+close_fd:
+    close(trace_fd);
+    trace_fd = -1;
+    return -1;
+}
+
+int memtier_trace_enabled(void)
+{
+    return __atomic_load_n(&trace_active, __ATOMIC_RELAXED);
+}
+
+void memtier_trace_fini(void)
+{
+    struct trace_buffer *buf;
+    if (!__atomic_load_n(&trace_active, __ATOMIC_RELAXED))
+        return;
+
+    __atomic_store_n(&trace_active, 0, __ATOMIC_SEQ_CST);
+    // producers which still saw tracing active finish their records before
+    // the final drain, later ones return without touching buffers
+    for (buf = __atomic_load_n(&trace_buffers, __ATOMIC_SEQ_CST); buf;
+         buf = buf->next) {
+        while (__atomic_load_n(&buf->busy, __ATOMIC_SEQ_CST))
+            sched_yield();
+    }
+    __atomic_store_n(&trace_stop, 1, __ATOMIC_RELEASE);
+    pthread_join(trace_writer, NULL);
+    close(trace_fd);
+    trace_fd = -1;
+}
@@ -0,0 +1,64 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/* Copyright (C) 2022 Intel Corporation. */
+
+#pragma once
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Binary trace file layout: struct memtier_trace_header followed by stream of
+ * struct memtier_trace_record. Record with op MEMTIER_TRACE_OP_KIND_NAME is
+ * followed by arg bytes of kind name, padded to multiple of record size.
+ */
+#define MEMTIER_TRACE_MAGIC   0x4d454d5452414345ULL /* "MEMTRACE" */
+#define MEMTIER_TRACE_VERSION 3U
+
+#define MEMTIER_TRACE_UNKNOWN_PARTITION UINT16_MAX
+
+typedef enum
+{
+    MEMTIER_TRACE_OP_MALLOC,
+    MEMTIER_TRACE_OP_CALLOC,
+    MEMTIER_TRACE_OP_REALLOC,
+    MEMTIER_TRACE_OP_POSIX_MEMALIGN,
+    MEMTIER_TRACE_OP_FREE,
+    MEMTIER_TRACE_OP_USABLE_SIZE,
+    MEMTIER_TRACE_OP_KIND_NAME, // partition -> name mapping
+    MEMTIER_TRACE_OP_DROPPED,   // arg records lost by thread tid
+    // realloc of ptr started, it is followed by MEMTIER_TRACE_OP_REALLOC
+    // record of the same thread
+    MEMTIER_TRACE_OP_REALLOC_BEGIN,
+    MEMTIER_TRACE_OP_MAX_VALUE,
+} memtier_trace_op_t;
+
+struct memtier_trace_header {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t record_size;
+};
+
+struct memtier_trace_record {
+    uint64_t seq;       // logical timestamp, global order of operations
+    uint64_t timestamp; // CLOCK_MONOTONIC in ns
+    uint64_t ptr;       // returned, freed or reallocated pointer
+    uint64_t arg;       // size (calloc: element size)
+    uint64_t aux;       // realloc: old ptr, calloc: num, memalign: alignment
+    uint32_t tid;
+    uint16_t op;
+    uint16_t partition;
+};
+
+int memtier_trace_init(const char *path);
+int memtier_trace_enabled(void);
+void memtier_trace_event(memtier_trace_op_t op, unsigned partition,
+                         const char *name, const void *ptr, uint64_t arg,
+                         uint64_t aux);
+void memtier_trace_fini(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,20 @@
+# SPDX-License-Identifier: BSD-2-Clause
+# Copyright (C) 2022 Intel Corporation.
+
+noinst_PROGRAMS += utils/memtier_trace/memtier_trace_decoder \
+                   utils/memtier_trace/memtier_trace_replay \
+                   # end
+
+utils_memtier_trace_memtier_trace_decoder_SOURCES = utils/memtier_trace/memtier_trace_decoder.c \
+                                                    tiering/memtier_trace.h \
+                                                    # end
+
+utils_memtier_trace_memtier_trace_replay_LDADD = libmemkind.la
+utils_memtier_trace_memtier_trace_replay_SOURCES = utils/memtier_trace/memtier_trace_replay.cpp \
+                                                   tiering/memtier_trace.h \
+                                                   # end
+
+clean-local: utils_memtier_trace_memtier_trace_decoder-clean
+
+utils_memtier_trace_memtier_trace_decoder-clean:
+	rm -f utils/memtier_trace/*.gcno
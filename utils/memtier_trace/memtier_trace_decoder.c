@@ -0,0 +1,197 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/* Copyright (C) 2022 Intel Corporation. */
+
+#include <tiering/memtier_trace.h>
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define MAX_PARTITION  UINT16_MAX
+#define MAX_KIND_NAME  64
+#define RECORD_SIZE    sizeof(struct memtier_trace_record)
+
+static const char *op_names[MEMTIER_TRACE_OP_MAX_VALUE] = {
+    [MEMTIER_TRACE_OP_MALLOC] = "malloc",
+    [MEMTIER_TRACE_OP_CALLOC] = "calloc",
+    [MEMTIER_TRACE_OP_REALLOC] = "realloc",
+    [MEMTIER_TRACE_OP_POSIX_MEMALIGN] = "posix_memalign",
+    [MEMTIER_TRACE_OP_FREE] = "free",
+    [MEMTIER_TRACE_OP_USABLE_SIZE] = "malloc_usable_size",
+    [MEMTIER_TRACE_OP_KIND_NAME] = "kind_name",
+    [MEMTIER_TRACE_OP_DROPPED] = "dropped",
+    [MEMTIER_TRACE_OP_REALLOC_BEGIN] = "realloc_begin",
+};
+
+static char *kind_names[MAX_PARTITION + 1];
+static uint64_t op_count[MEMTIER_TRACE_OP_MAX_VALUE];
+static uint64_t dropped_count;
+
+static void usage(const char *name)
+{
+    fprintf(stderr,
+            "Usage: %s [-s] trace_file\n"
+            "Decode binary trace written by libmemtier when "
+            "MEMKIND_MEM_TIERING_TRACE is set.\n"
+            "  -s  print only summary\n",
+            name);
+}
+
+static const char *kind_name(uint16_t partition)
+{
+    if (partition == MEMTIER_TRACE_UNKNOWN_PARTITION)
+        return "-";
+    return kind_names[partition] ? kind_names[partition] : "unknown";
+}
+
+static int read_kind_name(FILE *f, const struct memtier_trace_record *rec,
+                          int store)
+{
+    char buf[MAX_KIND_NAME + RECORD_SIZE] = {0};
+    size_t padded = (rec->arg + RECORD_SIZE - 1) / RECORD_SIZE * RECORD_SIZE;
+    if (rec->arg >= MAX_KIND_NAME || fread(buf, 1, padded, f) != padded) {
+        fprintf(stderr, "Corrupted kind name record\n");
+        return -1;
+    }
+    if (store && !kind_names[rec->partition])
+        kind_names[rec->partition] = strdup(buf);
+    return 0;
+}
+
+static void print_record(const struct memtier_trace_record *rec)
+{
+    printf("%" PRIu64 " %" PRIu64 " tid:%u %s ", rec->seq, rec->timestamp,
+           rec->tid, op_names[rec->op]);
+    switch (rec->op) {
+        case MEMTIER_TRACE_OP_MALLOC:
+            printf("kind:%s size:%" PRIu64 " ptr:0x%" PRIx64 "\n",
+                   kind_name(rec->partition), rec->arg, rec->ptr);
+            break;
+        case MEMTIER_TRACE_OP_CALLOC:
+            printf("kind:%s num:%" PRIu64 " size:%" PRIu64 " ptr:0x%" PRIx64
+                   "\n",
+                   kind_name(rec->partition), rec->aux, rec->arg, rec->ptr);
+            break;
+        case MEMTIER_TRACE_OP_REALLOC:
+            printf("kind:%s old_ptr:0x%" PRIx64 " size:%" PRIu64
+                   " ptr:0x%" PRIx64 "\n",
+                   kind_name(rec->partition), rec->aux, rec->arg, rec->ptr);
+            break;
+        case MEMTIER_TRACE_OP_REALLOC_BEGIN:
+            printf("kind:%s ptr:0x%" PRIx64 " size:%" PRIu64 "\n",
+                   kind_name(rec->partition), rec->ptr, rec->arg);
+            break;
+        case MEMTIER_TRACE_OP_POSIX_MEMALIGN:
+            printf("kind:%s alignment:%" PRIu64 " size:%" PRIu64
+                   " ptr:0x%" PRIx64 "\n",
+                   kind_name(rec->partition), rec->aux, rec->arg, rec->ptr);
+            break;
+        case MEMTIER_TRACE_OP_FREE:
+            printf("ptr:0x%" PRIx64 "\n", rec->ptr);
+            break;
+        case MEMTIER_TRACE_OP_USABLE_SIZE:
+            printf("ptr:0x%" PRIx64 " size:%" PRIu64 "\n", rec->ptr, rec->arg);
+            break;
+        case MEMTIER_TRACE_OP_DROPPED:
+            printf("records:%" PRIu64 "\n", rec->arg);
+            break;
+        default:
+            printf("ptr:0x%" PRIx64 " arg:%" PRIu64 " aux:%" PRIu64 "\n",
+                   rec->ptr, rec->arg, rec->aux);
+            break;
+    }
+}
+
+/*
+ * decode -- walk through trace, first pass collects kind names (name record
+ * might be written after first record of kind), second pass prints records
+ */
+static int decode(FILE *f, int pass, int summary)
+{
+    struct memtier_trace_record rec;
+
+    while (fread(&rec, RECORD_SIZE, 1, f) == 1) {
+        if (rec.op >= MEMTIER_TRACE_OP_MAX_VALUE) {
+            fprintf(stderr, "Unknown record operation: %u\n", rec.op);
+            return -1;
+        }
+        if (rec.op == MEMTIER_TRACE_OP_KIND_NAME) {
+            if (read_kind_name(f, &rec, pass == 0))
+                return -1;
+            continue;
+        }
+        if (pass == 0)
+            continue;
+
+        if (rec.op == MEMTIER_TRACE_OP_DROPPED)
+            dropped_count += rec.arg;
+        else
+            op_count[rec.op]++;
+        if (!summary)
+            print_record(&rec);
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    int opt, summary = 0, ret = 1;
+    unsigned i;
+    struct memtier_trace_header header;
+
+    while ((opt = getopt(argc, argv, "sh")) != -1) {
+        switch (opt) {
+            case 's':
+                summary = 1;
+                break;
+            default:
+                usage(argv[0]);
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (optind != argc - 1) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    FILE *f = fopen(argv[optind], "rb");
+    if (!f) {
+        perror(argv[optind]);
+        return 1;
+    }
+
+    if (fread(&header, sizeof(header), 1, f) != 1 ||
+        header.magic != MEMTIER_TRACE_MAGIC) {
+        fprintf(stderr, "%s is not memtier trace file\n", argv[optind]);
+        goto close_file;
+    }
+    if (header.version != MEMTIER_TRACE_VERSION ||
+        header.record_size != RECORD_SIZE) {
+        fprintf(stderr, "Unsupported trace version: %u, record size: %u\n",
+                header.version, header.record_size);
+        goto close_file;
+    }
+
+    if (decode(f, 0, summary))
+        goto close_file;
+    fseek(f, sizeof(header), SEEK_SET);
+    if (decode(f, 1, summary))
+        goto close_file;
+
+    printf("Summary:\n");
+    for (i = 0; i < MEMTIER_TRACE_OP_MAX_VALUE; ++i) {
+        if (i == MEMTIER_TRACE_OP_KIND_NAME || i == MEMTIER_TRACE_OP_DROPPED)
+            continue;
+        printf("%s: %" PRIu64 "\n", op_names[i], op_count[i]);
+    }
+    printf("dropped: %" PRIu64 "\n", dropped_count);
+    ret = 0;
+
+close_file:
+    fclose(f);
+    for (i = 0; i <= MAX_PARTITION; ++i)
+        free(kind_names[i]);
+    return ret;
+}
@@ -0,0 +1,600 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/* Copyright (C) 2022 Intel Corporation. */
+
+#include <memkind.h>
+#include <memkind_memtier.h>
+#include <tiering/memtier_trace.h>
+
+#include <algorithm>
+#include <argp.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sched.h>
+#include <sstream>
+#include <string>
+#include <sys/resource.h>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Replays allocation trace written by libmemtier (MEMKIND_MEM_TIERING_TRACE)
+// with one replay thread per traced thread. Operations of each thread keep
+// their order and operations on the same object keep the global order
+// (logical timestamp) of the trace.
+
+struct ReplayOp {
+    uint64_t size;
+    uint64_t aux; // calloc: num, posix_memalign: alignment
+    uint32_t obj;
+    uint32_t obj_version; // number of earlier operations on this object
+    uint16_t op;
+};
+
+struct ReplayObject {
+    std::atomic<void *> ptr{nullptr};
+    std::atomic<uint32_t> version{0};
+};
+
+class ReplayTarget
+{
+public:
+    virtual ~ReplayTarget() = default;
+    virtual void *malloc(size_t size) = 0;
+    virtual void *calloc(size_t num, size_t size) = 0;
+    virtual void *realloc(void *ptr, size_t size) = 0;
+    virtual int posix_memalign(void **ptr, size_t alignment, size_t size) = 0;
+    virtual void free(void *ptr) = 0;
+    virtual std::vector<std::pair<std::string, memkind_t>> tiers() const
+    {
+        return {};
+    }
+};
+
+class MallocTarget: public ReplayTarget
+{
+public:
+    void *malloc(size_t size) final
+    {
+        return ::malloc(size);
+    }
+    void *calloc(size_t num, size_t size) final
+    {
+        return ::calloc(num, size);
+    }
+    void *realloc(void *ptr, size_t size) final
+    {
+        return ::realloc(ptr, size);
+    }
+    int posix_memalign(void **ptr, size_t alignment, size_t size) final
+    {
+        return ::posix_memalign(ptr, alignment, size);
+    }
+    void free(void *ptr) final
+    {
+        ::free(ptr);
+    }
+};
+
+// memtier_kind_* API is used to have allocated size accounted per kind
+class KindTarget: public ReplayTarget
+{
+public:
+    KindTarget(const std::string &name, memkind_t kind)
+        : m_name(name), m_kind(kind)
+    {}
+    void *malloc(size_t size) final
+    {
+        return memtier_kind_malloc(m_kind, size);
+    }
+    void *calloc(size_t num, size_t size) final
+    {
+        return memtier_kind_calloc(m_kind, num, size);
+    }
+    void *realloc(void *ptr, size_t size) final
+    {
+        return memtier_kind_realloc(m_kind, ptr, size);
+    }
+    int posix_memalign(void **ptr, size_t alignment, size_t size) final
+    {
+        return memtier_kind_posix_memalign(m_kind, ptr, alignment, size);
+    }
+    void free(void *ptr) final
+    {
+        memtier_kind_free(m_kind, ptr);
+    }
+    std::vector<std::pair<std::string, memkind_t>> tiers() const final
+    {
+        return {{m_name, m_kind}};
+    }
+
+private:
+    std::string m_name;
+    memkind_t m_kind;
+};
+
+class MemtierTarget: public ReplayTarget
+{
+public:
+    MemtierTarget(struct memtier_memory *memory,
+                  const std::vector<std::pair<std::string, memkind_t>> &tiers)
+        : m_memory(memory), m_tiers(tiers)
+    {}
+    ~MemtierTarget()
+    {
+        memtier_delete_memtier_memory(m_memory);
+    }
+    void *malloc(size_t size) final
+    {
+        return memtier_malloc(m_memory, size);
+    }
+    void *calloc(size_t num, size_t size) final
+    {
+        return memtier_calloc(m_memory, num, size);
+    }
+    void *realloc(void *ptr, size_t size) final
+    {
+        return memtier_realloc(m_memory, ptr, size);
+    }
+    int posix_memalign(void **ptr, size_t alignment, size_t size) final
+    {
+        return memtier_posix_memalign(m_memory, ptr, alignment, size);
+    }
+    void free(void *ptr) final
+    {
+        memtier_free(ptr);
+    }
+    std::vector<std::pair<std::string, memkind_t>> tiers() const final
+    {
+        return m_tiers;
+    }
+
+private:
+    struct memtier_memory *m_memory;
+    std::vector<std::pair<std::string, memkind_t>> m_tiers;
+};
+
+struct ReplayArgs {
+    const char *trace_path = nullptr;
+    const char *kind_name = nullptr;
+    const char *pmem_dir = nullptr;
+    std::vector<std::string> tiers;
+    memtier_policy_t policy = MEMTIER_POLICY_STATIC_RATIO;
+};
+
+static std::vector<memkind_t> pmem_kinds;
+
+static memkind_t parse_kind(const std::string &name, const char *pmem_dir)
+{
+    if (name == "DRAM")
+        return MEMKIND_DEFAULT;
+    if (name == "REGULAR")
+        return MEMKIND_REGULAR;
+    if (name == "KMEM_DAX")
+        return MEMKIND_DAX_KMEM;
+    if (name == "FS_DAX") {
+        memkind_t kind = nullptr;
+        if (!pmem_dir) {
+            std::cerr << "FS_DAX requires --pmem_dir" << std::endl;
+            return nullptr;
+        }
+        if (memkind_create_pmem(pmem_dir, 0, &kind)) {
+            std::cerr << "Cannot create FS_DAX kind in " << pmem_dir
+                      << std::endl;
+            return nullptr;
+        }
+        pmem_kinds.push_back(kind);
+        return kind;
+    }
+    std::cerr << "Unsupported kind: " << name << std::endl;
+    return nullptr;
+}
+
+static std::unique_ptr<ReplayTarget> create_target(const ReplayArgs &args)
+{
+    if (args.kind_name) {
+        memkind_t kind = parse_kind(args.kind_name, args.pmem_dir);
+        if (!kind)
+            return nullptr;
+        return std::unique_ptr<ReplayTarget>(
+            new KindTarget(args.kind_name, kind));
+    }
+    if (args.tiers.empty())
+        return std::unique_ptr<ReplayTarget>(new MallocTarget());
+
+    struct memtier_builder *builder = memtier_builder_new(args.policy);
+    if (!builder)
+        return nullptr;
+    std::vector<std::pair<std::string, memkind_t>> tiers;
+    for (auto &tier : args.tiers) {
+        size_t sep = tier.find(':');
+        std::string name = tier.substr(0, sep);
+        unsigned ratio = sep == std::string::npos
+            ? 1
+            : std::strtoul(tier.c_str() + sep + 1, nullptr, 10);
+        memkind_t kind = parse_kind(name, args.pmem_dir);
+        if (!kind || memtier_builder_add_tier(builder, kind, ratio)) {
+            memtier_builder_delete(builder);
+            return nullptr;
+        }
+        tiers.emplace_back(name, kind);
+    }
+    struct memtier_memory *memory =
+        memtier_builder_construct_memtier_memory(builder);
+    memtier_builder_delete(builder);
+    if (!memory)
+        return nullptr;
+    return std::unique_ptr<ReplayTarget>(new MemtierTarget(memory, tiers));
+}
+
+class Replay
+{
+public:
+    int load(const char *path)
+    {
+        FILE *f = fopen(path, "rb");
+        if (!f) {
+            perror(path);
+            return -1;
+        }
+        struct memtier_trace_header header;
+        if (fread(&header, sizeof(header), 1, f) != 1 ||
+            header.magic != MEMTIER_TRACE_MAGIC ||
+            header.version != MEMTIER_TRACE_VERSION ||
+            header.record_size != sizeof(struct memtier_trace_record)) {
+            std::cerr << path << " is not supported memtier trace file"
+                      << std::endl;
+            fclose(f);
+            return -1;
+        }
+
+        std::vector<struct memtier_trace_record> records;
+        struct memtier_trace_record rec;
+        uint64_t dropped = 0;
+        while (fread(&rec, sizeof(rec), 1, f) == 1) {
+            if (rec.op == MEMTIER_TRACE_OP_KIND_NAME) {
+                size_t padded = (rec.arg + sizeof(rec) - 1) / sizeof(rec);
+                fseek(f, padded * sizeof(rec), SEEK_CUR);
+            } else if (rec.op == MEMTIER_TRACE_OP_DROPPED) {
+                dropped += rec.arg;
+            } else if (rec.op != MEMTIER_TRACE_OP_USABLE_SIZE) {
+                records.push_back(rec);
+            }
+        }
+        fclose(f);
+        if (dropped) {
+            std::cerr << "Warning: trace lost " << dropped
+                      << " records, replay is not exact" << std::endl;
+        }
+
+        std::sort(records.begin(), records.end(),
+                  [](const struct memtier_trace_record &a,
+                     const struct memtier_trace_record &b) {
+                      return a.seq < b.seq;
+                  });
+        build_ops(records);
+        if (m_live_collisions) {
+            std::cerr << "Warning: " << m_live_collisions
+                      << " allocations returned address of live object, "
+                         "replay is not exact"
+                      << std::endl;
+        }
+        return 0;
+    }
+
+    void run(ReplayTarget &target)
+    {
+        std::vector<std::thread> threads;
+        std::vector<std::vector<uint64_t>> latencies(
+            m_thread_ops.size() * MEMTIER_TRACE_OP_MAX_VALUE);
+        std::atomic<bool> start{false}, done{false};
+        auto tiers = target.tiers();
+        std::vector<size_t> peak(tiers.size(), 0);
+
+        // sampling of allocated size per tier, outside of replay threads
+        std::thread monitor([&]() {
+            while (!done.load()) {
+                for (size_t i = 0; i < tiers.size(); ++i)
+                    peak[i] = std::max(
+                        peak[i], memtier_kind_allocated_size(tiers[i].second));
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        });
+
+        size_t t = 0;
+        for (auto &ops : m_thread_ops) {
+            threads.emplace_back([&, t]() {
+                while (!start.load())
+                    ;
+                replay_thread(target, ops.second,
+                              &latencies[t * MEMTIER_TRACE_OP_MAX_VALUE]);
+            });
+            ++t;
+        }
+        auto begin = std::chrono::steady_clock::now();
+        start.store(true);
+        for (auto &thread : threads)
+            thread.join();
+        auto end = std::chrono::steady_clock::now();
+        done.store(true);
+        monitor.join();
+
+        std::chrono::duration<double> elapsed = end - begin;
+        report(elapsed.count(), latencies, tiers, peak);
+
+        // release objects which were not freed in trace
+        for (auto &obj : m_objects) {
+            void *ptr = obj.ptr.load();
+            if (ptr)
+                target.free(ptr);
+        }
+    }
+
+private:
+    void build_ops(const std::vector<struct memtier_trace_record> &records)
+    {
+        std::unordered_map<uint64_t, uint32_t> live;
+        // objects of reallocs in progress, keyed by tid
+        std::unordered_map<uint32_t, uint32_t> reallocs;
+        std::vector<uint32_t> versions;
+
+        auto set_live = [&](uint64_t ptr, uint32_t obj) {
+            auto res = live.emplace(ptr, obj);
+            if (!res.second) {
+                // object at ptr was not freed in trace
+                ++m_live_collisions;
+                res.first->second = obj;
+            }
+        };
+
+        for (auto &rec : records) {
+            ReplayOp op = {rec.arg, rec.aux, 0, 0, rec.op};
+            bool alloc = false;
+            switch (rec.op) {
+                case MEMTIER_TRACE_OP_MALLOC:
+                case MEMTIER_TRACE_OP_CALLOC:
+                case MEMTIER_TRACE_OP_POSIX_MEMALIGN:
+                    alloc = true;
+                    break;
+                case MEMTIER_TRACE_OP_REALLOC_BEGIN: {
+                    // old block could be allocated by other thread before
+                    // realloc returns, so it is not live from now
+                    auto it = live.find(rec.ptr);
+                    if (it != live.end()) {
+                        reallocs[rec.tid] = it->second;
+                        live.erase(it);
+                    }
+                    continue;
+                }
+                case MEMTIER_TRACE_OP_REALLOC: {
+                    auto pending = reallocs.find(rec.tid);
+                    auto it = live.end();
+                    if (pending != reallocs.end()) {
+                        op.obj = pending->second;
+                        reallocs.erase(pending);
+                    } else if (rec.aux &&
+                               (it = live.find(rec.aux)) != live.end()) {
+                        // begin record was dropped
+                        op.obj = it->second;
+                        live.erase(it);
+                    } else {
+                        // unknown object
+                        op.op = MEMTIER_TRACE_OP_MALLOC;
+                        alloc = true;
+                        break;
+                    }
+                    if (!rec.ptr) {
+                        // failed realloc keeps old block
+                        set_live(rec.aux, op.obj);
+                        continue;
+                    }
+                    set_live(rec.ptr, op.obj);
+                    break;
+                }
+                case MEMTIER_TRACE_OP_FREE: {
+                    auto it = live.find(rec.ptr);
+                    if (it == live.end())
+                        continue;
+                    op.obj = it->second;
+                    live.erase(it);
+                    break;
+                }
+                default:
+                    continue;
+            }
+            if (alloc) {
+                if (!rec.ptr)
+                    continue;
+                op.obj = versions.size();
+                versions.push_back(0);
+                set_live(rec.ptr, op.obj);
+            }
+            op.obj_version = versions[op.obj]++;
+            m_thread_ops[rec.tid].push_back(op);
+            ++m_ops_count;
+        }
+        m_objects = std::vector<ReplayObject>(versions.size());
+    }
+
+    void replay_thread(ReplayTarget &target, const std::vector<ReplayOp> &ops,
+                       std::vector<uint64_t> *latencies)
+    {
+        for (auto &op : ops) {
+            ReplayObject &obj = m_objects[op.obj];
+            // wait for earlier operations on object done by other threads
+            while (obj.version.load(std::memory_order_acquire) !=
+                   op.obj_version)
+                sched_yield();
+
+            void *ptr = obj.ptr.load(std::memory_order_relaxed);
+            auto begin = std::chrono::steady_clock::now();
+            switch (op.op) {
+                case MEMTIER_TRACE_OP_MALLOC:
+                    ptr = target.malloc(op.size);
+                    break;
+                case MEMTIER_TRACE_OP_CALLOC:
+                    ptr = target.calloc(op.aux, op.size);
+                    break;
+                case MEMTIER_TRACE_OP_POSIX_MEMALIGN:
+                    if (target.posix_memalign(&ptr, op.aux, op.size))
+                        ptr = nullptr;
+                    break;
+                case MEMTIER_TRACE_OP_REALLOC: {
+                    void *new_ptr = target.realloc(ptr, op.size);
+                    if (new_ptr)
+                        ptr = new_ptr;
+                    break;
+                }
+                case MEMTIER_TRACE_OP_FREE:
+                    target.free(ptr);
+                    ptr = nullptr;
+                    break;
+            }
+            auto end = std::chrono::steady_clock::now();
+            latencies[op.op].push_back(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(end -
+                                                                     begin)
+                    .count());
+
+            obj.ptr.store(ptr, std::memory_order_relaxed);
+            obj.version.store(op.obj_version + 1, std::memory_order_release);
+        }
+    }
+
+    void report(double elapsed,
+                std::vector<std::vector<uint64_t>> &thread_latencies,
+                const std::vector<std::pair<std::string, memkind_t>> &tiers,
+                const std::vector<size_t> &peak)
+    {
+        static const char *op_names[MEMTIER_TRACE_OP_MAX_VALUE] = {
+            "malloc", "calloc", "realloc", "posix_memalign", "free"};
+        const double percentiles[] = {50.0, 90.0, 99.0, 99.9};
+
+        std::cout << "Threads: " << m_thread_ops.size() << std::endl;
+        std::cout << "Operations: " << m_ops_count << std::endl;
+        std::cout << "Time [s]: " << elapsed << std::endl;
+        std::cout << "Throughput [ops/s]: " << m_ops_count / elapsed
+                  << std::endl;
+
+        std::cout << "Latency [ns]:" << std::endl;
+        std::cout << std::setw(14) << "operation" << std::setw(10) << "count";
+        for (double p : percentiles) {
+            std::ostringstream label;
+            label << "p" << p;
+            std::cout << std::setw(9) << label.str();
+        }
+        std::cout << std::setw(10) << "max" << std::endl;
+        for (unsigned op = 0; op <= MEMTIER_TRACE_OP_FREE; ++op) {
+            std::vector<uint64_t> lat;
+            for (size_t t = 0; t < m_thread_ops.size(); ++t) {
+                auto &l = thread_latencies[t * MEMTIER_TRACE_OP_MAX_VALUE + op];
+                lat.insert(lat.end(), l.begin(), l.end());
+            }
+            if (lat.empty())
+                continue;
+            std::sort(lat.begin(), lat.end());
+            std::cout << std::setw(14) << op_names[op] << std::setw(10)
+                      << lat.size();
+            for (double p : percentiles) {
+                size_t idx = std::min(lat.size() - 1,
+                                      (size_t)(p / 100.0 * lat.size()));
+                std::cout << std::setw(9) << lat[idx];
+            }
+            std::cout << std::setw(10) << lat.back() << std::endl;
+        }
+
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        std::cout << "Peak RSS [kB]: " << usage.ru_maxrss << std::endl;
+        for (size_t i = 0; i < tiers.size(); ++i)
+            std::cout << "Peak allocated size [B] " << tiers[i].first << ": "
+                      << peak[i] << std::endl;
+    }
+
+    // operations of each traced thread, keyed by tid
+    std::map<uint32_t, std::vector<ReplayOp>> m_thread_ops;
+    std::vector<ReplayObject> m_objects;
+    uint64_t m_ops_count = 0;
+    // allocations which got address of object not freed in trace
+    uint64_t m_live_collisions = 0;
+};
+
+// clang-format off
+static int parse_opt(int key, char *arg, struct argp_state *state)
+{
+    auto args = (ReplayArgs *)state->input;
+    switch (key) {
+        case 'k':
+            args->kind_name = arg;
+            break;
+        case 't':
+            args->tiers.push_back(arg);
+            break;
+        case 'p':
+            if (!strcmp(arg, "STATIC_RATIO"))
+                args->policy = MEMTIER_POLICY_STATIC_RATIO;
+            else if (!strcmp(arg, "DYNAMIC_THRESHOLD"))
+                args->policy = MEMTIER_POLICY_DYNAMIC_THRESHOLD;
+            else
+                argp_error(state, "Unknown policy: %s", arg);
+            break;
+        case 'd':
+            args->pmem_dir = arg;
+            break;
+        case ARGP_KEY_ARG:
+            if (args->trace_path)
+                argp_usage(state);
+            args->trace_path = arg;
+            break;
+        case ARGP_KEY_END:
+            if (!args->trace_path)
+                argp_usage(state);
+            if (args->kind_name && !args->tiers.empty())
+                argp_error(state, "--kind and --tier are exclusive");
+            break;
+    }
+    return 0;
+}
+
+static struct argp_option options[] = {
+    {"kind", 'k', "KIND", 0, "Replay with single kind: DRAM, REGULAR, KMEM_DAX or FS_DAX."},
+    {"tier", 't', "KIND:RATIO", 0, "Add memtier tier, could be repeated."},
+    {"policy", 'p', "POLICY", 0, "Memtier policy: STATIC_RATIO (default) or DYNAMIC_THRESHOLD."},
+    {"pmem_dir", 'd', "PATH", 0, "Directory for FS_DAX kind."},
+    {0}};
+// clang-format on
+
+static struct argp argp = {
+    options, parse_opt, "TRACE_FILE",
+    "Replays trace written by libmemtier with MEMKIND_MEM_TIERING_TRACE set. "
+    "Without --kind and --tier, system malloc is used."};
+
+int main(int argc, char *argv[])
+{
+    ReplayArgs args;
+    argp_parse(&argp, argc, argv, 0, 0, &args);
+
+    Replay replay;
+    if (replay.load(args.trace_path))
+        return 1;
+
+    int ret = 0;
+    {
+        auto target = create_target(args);
+        if (target) {
+            replay.run(*target);
+        } else {
+            std::cerr << "Failed to create replay target" << std::endl;
+            ret = 1;
+        }
+    }
+    for (auto kind : pmem_kinds)
+        memkind_destroy_kind(kind);
+    return ret;
+}